@@ -7,6 +7,7 @@
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
 #include "common/assert.h"
+#include "common/trace.h"
 #include "core/core.h"
 #include "core/settings.h"
 
@@ -44,8 +45,13 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
 }
 
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
+    // The thread belongs to the audio backend, so it's only named in the traces
+    Common::Trace::SetThreadName("Audio");
+    Common::Trace::Scope trace_scope("Audio callback");
+
     const std::vector<s16> in{fifo.Pop()};
     const std::size_t num_in{in.size() / 2};
+    Common::Trace::Counter("Audio frames queued", static_cast<s64>(num_in));
     const std::size_t frames_written =
         time_stretcher.Process(in.data(), num_in, buffer, num_frames);
 
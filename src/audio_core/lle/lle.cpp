@@ -11,6 +11,7 @@
 #include "common/bit_field.h"
 #include "common/swap.h"
 #include "common/thread.h"
+#include "common/trace.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/lock.h"
@@ -149,8 +150,12 @@ struct DspLle::Impl final {
     static constexpr u32 TeakraSlice = 20000;
 
     void TeakraThread() {
+        Common::SetCurrentThreadName("Teakra");
         while (true) {
-            teakra.Run(TeakraSlice);
+            {
+                Common::Trace::Scope trace_scope("Teakra slice");
+                teakra.Run(TeakraSlice);
+            }
             teakra_slice_barrier.Sync();
             if (stop_signal) {
                 if (stop_generation == teakra_slice_barrier.Generation())
@@ -170,6 +175,8 @@ struct DspLle::Impl final {
     }
 
     void RunTeakraSlice() {
+        // Includes waiting for the DSP thread if it's multithreaded
+        Core::SubsystemTimer timer(Core::Subsystem::Audio);
         if (multithread) {
             teakra_slice_barrier.Sync();
         } else {
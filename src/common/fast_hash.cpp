@@ -0,0 +1,37 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/fast_hash.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+// Each implementation has its own static copy of XXH3
+#define XXH_INLINE_ALL
+#define XXH_VECTOR XXH_SCALAR
+#include <xxhash.h>
+
+namespace Common {
+
+namespace FastHash {
+
+u64 HashGeneric(const u8* data, std::size_t len) {
+    return XXH3_64bits(data, len);
+}
+
+} // namespace FastHash
+
+u64 ComputeFastHash64(const void* data, std::size_t len) {
+#ifdef ARCHITECTURE_x86_64
+    static const bool has_avx2 = GetCPUCaps().avx2;
+    if (has_avx2) {
+        return FastHash::HashAVX2(static_cast<const u8*>(data), len);
+    }
+    return FastHash::HashSSE2(static_cast<const u8*>(data), len);
+#else
+    return FastHash::HashGeneric(static_cast<const u8*>(data), len);
+#endif
+}
+
+} // namespace Common
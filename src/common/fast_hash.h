@@ -0,0 +1,34 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Computes the XXH3 64-bit hash of the specified block of data. Large blocks are hashed several
+ * times faster than with ComputeHash64, but the hashes are different.
+ * @param data Block of data to compute hash over
+ * @param len Length of data (in bytes) to compute hash over
+ * @returns 64-bit hash value that was computed over the data block
+ */
+u64 ComputeFastHash64(const void* data, std::size_t len);
+
+namespace FastHash {
+
+/// Portable implementation
+u64 HashGeneric(const u8* data, std::size_t len);
+
+#ifdef ARCHITECTURE_x86_64
+// These give the same hashes as HashGeneric, HashAVX2 needs a CPU supporting AVX2
+u64 HashSSE2(const u8* data, std::size_t len);
+u64 HashAVX2(const u8* data, std::size_t len);
+#endif
+
+} // namespace FastHash
+
+} // namespace Common
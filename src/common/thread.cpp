@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/thread.h"
+#include "common/trace.h"
 #if defined(_WIN32)
 #include <windows.h>
 #else
@@ -40,6 +41,8 @@ void SetCurrentThreadName(const char* name) {
     } info;
 #pragma pack(pop)
 
+    Trace::SetThreadName(name);
+
     info.dwType = 0x1000;
     info.szName = name;
     info.dwThreadID = static_cast<DWORD>(-1);
@@ -55,6 +58,8 @@ void SetCurrentThreadName(const char* name) {
 
 #if !defined(_WIN32) || defined(_MSC_VER)
 void SetCurrentThreadName(const char* name) {
+    Trace::SetThreadName(name);
+
 #if defined(__Bitrig__) || defined(__DragonFly__) || defined(__FreeBSD__) || defined(__OpenBSD__)
     pthread_set_name_np(pthread_self(), name);
 #elif defined(__NetBSD__)
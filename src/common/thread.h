@@ -91,6 +91,7 @@ private:
     std::size_t generation = 0; // Incremented once each time the barrier is used
 };
 
+/// Names the calling thread for debuggers and traces
 void SetCurrentThreadName(const char* name);
 
 } // namespace Common
@@ -9,7 +9,9 @@
 #include <thread>
 #include <vector>
 #include "common/assert.h"
+#include "common/thread.h"
 #include "common/threadsafe_queue.h"
+#include "common/trace.h"
 
 namespace Common {
 
@@ -80,9 +82,11 @@ private:
 
     private:
         void Loop() {
+            SetCurrentThreadName("Thread Pool");
             std::function<void()> task;
             for (;;) {
                 while (queue.Pop(task)) {
+                    Trace::Scope trace_scope("Thread pool task");
                     task();
                 }
                 if (spinlock_enabled) {
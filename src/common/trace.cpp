@@ -0,0 +1,266 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <fmt/format.h>
+#include "common/trace.h"
+
+namespace Common::Trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+enum class EventType : u8 {
+    Begin,
+    End,
+    Counter,
+};
+
+/// An event, read by the dumping thread while it may be overwritten
+struct Event {
+    std::atomic<s64> timestamp{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<s64> value{0};
+    std::atomic<EventType> type{EventType::Begin};
+};
+
+struct ThreadBuffer {
+    u32 id = 0;
+    std::string name; ///< Guarded by the registry mutex
+    /// Number of events whose writing started, stored before writing an event
+    std::atomic<u64> num_started{0};
+    /// Number of events written, stored after writing an event
+    std::atomic<u64> num_written{0};
+    std::unique_ptr<std::array<Event, EVENTS_PER_THREAD>> events =
+        std::make_unique<std::array<Event, EVENTS_PER_THREAD>>();
+};
+
+/// The buffers of every thread that recorded events, kept after the threads exit
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+std::unordered_set<std::string> interned_names;
+
+const auto epoch = std::chrono::steady_clock::now();
+
+/// Events recorded before this time are dropped from the dumps
+std::atomic<s64> start_time{0};
+
+thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+thread_local std::string thread_name;
+
+s64 Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                epoch)
+        .count();
+}
+
+ThreadBuffer& GetThreadBuffer() {
+    if (thread_buffer == nullptr) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard lock(registry_mutex);
+        buffer->id = static_cast<u32>(buffers.size() + 1);
+        buffer->name = thread_name.empty() ? fmt::format("Thread {}", buffer->id) : thread_name;
+        buffers.push_back(buffer);
+        thread_buffer = std::move(buffer);
+    }
+    return *thread_buffer;
+}
+
+void Record(EventType type, const char* name, s64 value) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const u64 index = buffer.num_started.load(std::memory_order_relaxed);
+    buffer.num_started.store(index + 1, std::memory_order_relaxed);
+    // Readers that see a part of the event also see that its slot is being overwritten
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = (*buffer.events)[index % EVENTS_PER_THREAD];
+    event.timestamp.store(Now(), std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.value.store(value, std::memory_order_relaxed);
+    event.type.store(type, std::memory_order_relaxed);
+    buffer.num_written.store(index + 1, std::memory_order_release);
+}
+
+std::string EscapeJSON(const std::string& string) {
+    std::string escaped;
+    for (const char c : string) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+struct EventCopy {
+    s64 timestamp;
+    const char* name;
+    s64 value;
+    EventType type;
+};
+
+/// Copies the events of the buffer that weren't overwritten while they were copied
+std::vector<EventCopy> CopyEvents(const ThreadBuffer& buffer) {
+    const u64 end = buffer.num_written.load(std::memory_order_acquire);
+    const u64 begin = end - std::min<u64>(end, EVENTS_PER_THREAD);
+
+    std::vector<EventCopy> events;
+    events.reserve(end - begin);
+    for (u64 index = begin; index < end; ++index) {
+        const Event& event = (*buffer.events)[index % EVENTS_PER_THREAD];
+        events.push_back({event.timestamp.load(std::memory_order_relaxed),
+                          event.name.load(std::memory_order_relaxed),
+                          event.value.load(std::memory_order_relaxed),
+                          event.type.load(std::memory_order_relaxed)});
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const u64 started = buffer.num_started.load(std::memory_order_relaxed);
+    const u64 first_intact = started - std::min<u64>(started, EVENTS_PER_THREAD);
+    if (first_intact > begin) {
+        events.erase(events.begin(),
+                     events.begin() + static_cast<std::ptrdiff_t>(
+                                          std::min<u64>(first_intact - begin, events.size())));
+    }
+    return events;
+}
+
+} // Anonymous namespace
+
+void SetEnabled(bool enabled) {
+    if (enabled && !g_enabled.load(std::memory_order_relaxed)) {
+        start_time.store(Now(), std::memory_order_relaxed);
+    }
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SetThreadName(const std::string& name) {
+    if (name == thread_name) {
+        return;
+    }
+    thread_name = name;
+    if (thread_buffer != nullptr) {
+        std::lock_guard lock(registry_mutex);
+        thread_buffer->name = name;
+    }
+}
+
+const char* Intern(const std::string& name) {
+    std::lock_guard lock(registry_mutex);
+    // Elements of unordered sets don't move when rehashing
+    return interned_names.insert(name).first->c_str();
+}
+
+void Begin(const char* name) {
+    if (IsEnabled()) {
+        Record(EventType::Begin, name, 0);
+    }
+}
+
+void End() {
+    if (IsEnabled()) {
+        Record(EventType::End, nullptr, 0);
+    }
+}
+
+void Counter(const char* name, s64 value) {
+    if (IsEnabled()) {
+        Record(EventType::Counter, name, value);
+    }
+}
+
+std::string Dump() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_copy;
+    std::vector<std::string> names;
+    {
+        std::lock_guard lock(registry_mutex);
+        buffers_copy = buffers;
+        for (const auto& buffer : buffers) {
+            names.push_back(EscapeJSON(buffer->name));
+        }
+    }
+    const s64 start = start_time.load(std::memory_order_relaxed);
+
+    std::unordered_map<const char*, std::string> escaped_names;
+    const auto GetEscapedName = [&escaped_names](const char* name) -> const std::string& {
+        auto it = escaped_names.find(name);
+        if (it == escaped_names.end()) {
+            it = escaped_names.emplace(name, EscapeJSON(name)).first;
+        }
+        return it->second;
+    };
+
+    fmt::memory_buffer json;
+    const auto out = std::back_inserter(json);
+    fmt::format_to(out, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    const auto Separate = [out, &first] {
+        if (!first) {
+            fmt::format_to(out, ",\n");
+        }
+        first = false;
+    };
+
+    for (std::size_t i = 0; i < buffers_copy.size(); ++i) {
+        const ThreadBuffer& buffer = *buffers_copy[i];
+        Separate();
+        fmt::format_to(out,
+                       "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                       "\"args\":{{\"name\":\"{}\"}}}}",
+                       buffer.id, names[i]);
+
+        // The ends of slices begun before the oldest event kept are dropped
+        std::size_t depth = 0;
+        for (const EventCopy& event : CopyEvents(buffer)) {
+            if (event.timestamp < start) {
+                continue;
+            }
+            const double timestamp_us = (event.timestamp - start) / 1000.0;
+            switch (event.type) {
+            case EventType::Begin:
+                ++depth;
+                Separate();
+                fmt::format_to(out,
+                               "{{\"name\":\"{}\",\"ph\":\"B\",\"ts\":{:.3f},\"pid\":1,"
+                               "\"tid\":{}}}",
+                               GetEscapedName(event.name), timestamp_us, buffer.id);
+                break;
+            case EventType::End:
+                if (depth == 0) {
+                    break;
+                }
+                --depth;
+                Separate();
+                fmt::format_to(out, "{{\"ph\":\"E\",\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                               timestamp_us, buffer.id);
+                break;
+            case EventType::Counter:
+                Separate();
+                fmt::format_to(out,
+                               "{{\"name\":\"{0}\",\"ph\":\"C\",\"ts\":{1:.3f},\"pid\":1,"
+                               "\"tid\":{2},\"args\":{{\"{0}\":{3}}}}}",
+                               GetEscapedName(event.name), timestamp_us, buffer.id, event.value);
+                break;
+            }
+        }
+    }
+
+    fmt::format_to(out, "]}}");
+    return fmt::to_string(json);
+}
+
+} // namespace Common::Trace
@@ -0,0 +1,72 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * Records timelines of what each thread does, to be viewed in chrome://tracing or Perfetto.
+ * Every thread writes its events to its own ring buffer without locking, and keeps only its
+ * newest events. Recording an event while tracing is disabled only costs an atomic load.
+ * Event names must outlive the trace, so they are string literals or names from Intern.
+ */
+namespace Common::Trace {
+
+/// Number of events kept for each thread
+constexpr std::size_t EVENTS_PER_THREAD = 1 << 17;
+
+extern std::atomic<bool> g_enabled;
+
+/// Starts or stops recording events. Starting drops the events recorded before.
+void SetEnabled(bool enabled);
+
+inline bool IsEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+/// Names the calling thread in the traces, cheap if the name doesn't change
+void SetThreadName(const std::string& name);
+
+/// Returns a copy of the name that lives as long as the program
+const char* Intern(const std::string& name);
+
+/// Begins a slice of the calling thread's timeline, ended by the next End
+void Begin(const char* name);
+
+/// Ends the last slice begun by the calling thread
+void End();
+
+/// Records a value of a counter
+void Counter(const char* name, s64 value);
+
+/// Returns the events of every thread in the Chrome trace event JSON format
+std::string Dump();
+
+/// Records a slice from its construction to its destruction
+class Scope {
+public:
+    explicit Scope(const char* name) : recorded(IsEnabled()) {
+        if (recorded) {
+            Begin(name);
+        }
+    }
+
+    ~Scope() {
+        if (recorded) {
+            End();
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    /// Keeps the slices balanced if tracing is toggled inside the scope
+    bool recorded;
+};
+
+} // namespace Common::Trace
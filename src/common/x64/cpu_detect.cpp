@@ -33,6 +33,12 @@ static inline void __cpuid(int info[4], int function_id) {
     return __cpuidex(info, function_id, 0);
 }
 
+static inline u64 _xgetbv(u32 index) {
+    u32 eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((u64)edx << 32) | eax;
+}
+
 #endif // _MSC_VER
 
 namespace Common {
@@ -48,7 +54,18 @@ static CPUCaps Detect() {
     if (max_std_fn >= 1) {
         __cpuid(cpu_id, 0x00000001);
 
+        caps.ssse3 = (cpu_id[2] >> 9) & 1;
         caps.sse4_1 = (cpu_id[2] >> 19) & 1;
+
+        // AVX registers are only usable if the OS saves the YMM state on context switches
+        const bool os_saves_ymm =
+            ((cpu_id[2] >> 27) & 1) && ((cpu_id[2] >> 28) & 1) && (_xgetbv(0) & 0x6) == 0x6;
+
+        if (max_std_fn >= 7 && os_saves_ymm) {
+            __cpuidex(cpu_id, 0x00000007, 0x00000000);
+
+            caps.avx2 = (cpu_id[1] >> 5) & 1;
+        }
     }
 
     return caps;
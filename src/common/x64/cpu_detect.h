@@ -8,7 +8,9 @@ namespace Common {
 
 /// CPU capabilities that may be detected by this module
 struct CPUCaps {
+    bool ssse3;
     bool sse4_1;
+    bool avx2;
 };
 
 /**
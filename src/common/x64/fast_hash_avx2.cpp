@@ -0,0 +1,17 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/fast_hash.h"
+
+#define XXH_INLINE_ALL
+#define XXH_VECTOR XXH_AVX2
+#include <xxhash.h>
+
+namespace Common::FastHash {
+
+u64 HashAVX2(const u8* data, std::size_t len) {
+    return XXH3_64bits(data, len);
+}
+
+} // namespace Common::FastHash
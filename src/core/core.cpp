@@ -85,6 +85,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             current_core_to_execute->GetTimer()->Idle();
             PrepareReschedule();
         } else {
+            SubsystemTimer timer(Subsystem::CPU);
             if (tight_loop) {
                 current_core_to_execute->Run();
             } else {
@@ -114,6 +115,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
                 cpu_core->GetTimer()->Idle();
                 PrepareReschedule();
             } else {
+                SubsystemTimer timer(Subsystem::CPU);
                 if (tight_loop) {
                     cpu_core->Run();
                 } else {
@@ -203,6 +205,9 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                                              FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
                                              Kernel().GetCurrentProcess()->codeset->program_id));
         custom_tex_cache->FindCustomTextures();
+        if (Settings::values.build_custom_texture_pack) {
+            custom_tex_cache->BuildTexturePack();
+        }
     }
     if (Settings::values.preload_textures) {
         custom_tex_cache->PreloadTextures();
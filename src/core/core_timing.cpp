@@ -7,6 +7,7 @@
 #include <tuple>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/trace.h"
 #include "core/core_timing.h"
 #include "core/settings.h"
 
@@ -39,7 +40,8 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
                "during Init to avoid breaking save states.",
                name);
 
-    auto info = event_types.emplace(name, TimingEventType{callback, nullptr});
+    auto info =
+        event_types.emplace(name, TimingEventType{callback, nullptr, Common::Trace::Intern(name)});
     TimingEventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
     return event_type;
@@ -179,6 +181,7 @@ void Timing::Timer::Advance(s64 max_slice_length) {
         Event evt = std::move(event_queue.front());
         std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
         event_queue.pop_back();
+        Common::Trace::Scope trace_scope(evt.type->trace_name);
         evt.type->callback(evt.userdata, executed_ticks - evt.time);
     }
 
@@ -130,6 +130,7 @@ using TimedCallback = std::function<void(u64 userdata, int cycles_late)>;
 struct TimingEventType {
     TimedCallback callback;
     const std::string* name;
+    const char* trace_name; ///< Name of the callback slices in traces
 };
 
 constexpr int MAX_SLICE_LENGTH = 20000;
@@ -2,18 +2,59 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstring>
+#include <future>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/stb_image.h"
 #include "common/texture.h"
+#include "common/thread_pool.h"
+#include "common/zstd_compression.h"
 #include "core/core.h"
 #include "core/custom_tex_cache.h"
+#include "core/settings.h"
 
 namespace Core {
 
+namespace {
+
+constexpr u32 PACK_MAGIC = 0x4B505456; // "VTPK"
+constexpr u32 PACK_VERSION = 1;
+
+struct PackHeader {
+    u32 magic;
+    u32 version;
+    u64 num_entries;
+    u64 index_offset;
+};
+static_assert(sizeof(PackHeader) == 24, "PackHeader has the wrong size");
+static_assert(sizeof(CustomTexPackEntry) == 32, "CustomTexPackEntry has the wrong size");
+
+/// Number of textures decoded by each thread pool worker before the results are handed out
+constexpr std::size_t TEXTURES_PER_WORKER = 4;
+
+std::size_t GetTextureSize(const CustomTexInfo& tex_info) {
+    return tex_info.tex.size();
+}
+
+std::size_t GetMemoryBudget() {
+    return static_cast<std::size_t>(Settings::values.custom_textures_memory_budget) << 20;
+}
+
+} // Anonymous namespace
+
 CustomTexCache::CustomTexCache() = default;
 
-CustomTexCache::~CustomTexCache() = default;
+CustomTexCache::~CustomTexCache() {
+    if (loader_thread.joinable()) {
+        stop_loader = true;
+        load_queue.Push(0);
+        loader_thread.join();
+    }
+}
 
 bool CustomTexCache::IsTextureDumped(u64 hash) const {
     return dumped_textures.count(hash);
@@ -23,16 +64,49 @@ void CustomTexCache::SetTextureDumped(const u64 hash) {
     dumped_textures.insert(hash);
 }
 
+std::shared_ptr<const CustomTexInfo> CustomTexCache::LookupTexture(u64 hash) {
+    std::lock_guard lock(mutex);
+    const auto iter = custom_textures.find(hash);
+    if (iter != custom_textures.end()) {
+        lru_textures.splice(lru_textures.begin(), lru_textures, iter->second.lru_position);
+        return iter->second.info;
+    }
+    if (!CustomTextureExists(hash) || failed_textures.count(hash) ||
+        !queued_textures.insert(hash).second) {
+        return nullptr;
+    }
+    if (!loader_thread.joinable()) {
+        loader_thread = std::thread(&CustomTexCache::LoaderLoop, this);
+    }
+    load_queue.Push(hash);
+    return nullptr;
+}
+
 bool CustomTexCache::IsTextureCached(u64 hash) const {
+    std::lock_guard lock(mutex);
     return custom_textures.count(hash);
 }
 
-const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) const {
-    return custom_textures.at(hash);
-}
+void CustomTexCache::CacheTexture(u64 hash, CustomTexInfo tex_info) {
+    std::lock_guard lock(mutex);
+    if (custom_textures.count(hash)) {
+        return;
+    }
+    resident_size += GetTextureSize(tex_info);
+    lru_textures.push_front(hash);
+    custom_textures.emplace(
+        hash, CachedTexture{std::make_shared<const CustomTexInfo>(std::move(tex_info)),
+                            lru_textures.begin()});
 
-void CustomTexCache::CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height) {
-    custom_textures[hash] = {width, height, tex};
+    // Surfaces keep their uploaded copy, so evicted textures are only decoded again when a
+    // surface using them is reloaded
+    const std::size_t budget = GetMemoryBudget();
+    while (budget != 0 && resident_size > budget && lru_textures.size() > 1) {
+        const auto evicted = custom_textures.find(lru_textures.back());
+        resident_size -= GetTextureSize(*evicted->second.info);
+        custom_textures.erase(evicted);
+        lru_textures.pop_back();
+    }
 }
 
 void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
@@ -46,10 +120,18 @@ void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
 void CustomTexCache::FindCustomTextures() {
     // Custom textures are currently stored as
     // [TitleID]/tex1_[width]x[height]_[64-bit hash]_[format].[extension]
+    // or decoded in the texture pack [TitleID].pack
 
-    const std::string load_path =
-        fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
-                    Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id);
+    const u64 program_id =
+        Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id;
+    const std::string& load_dir = FileUtil::GetUserPath(FileUtil::UserPath::LoadDir);
+    FindCustomTextures(fmt::format("{}textures/{:016X}/", load_dir, program_id),
+                       fmt::format("{}textures/{:016X}.pack", load_dir, program_id));
+}
+
+void CustomTexCache::FindCustomTextures(const std::string& load_path,
+                                        const std::string& pack_path) {
+    this->pack_path = pack_path;
 
     if (FileUtil::Exists(load_path)) {
         FileUtil::FSTEntry texture_dir;
@@ -78,38 +160,209 @@ void CustomTexCache::FindCustomTextures() {
             }
         }
     }
+
+    LoadTexturePack();
+}
+
+void CustomTexCache::LoadTexturePack() {
+    pack_entries.clear();
+    FileUtil::IOFile file(pack_path, "rb");
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    PackHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) || header.magic != PACK_MAGIC ||
+        header.version != PACK_VERSION) {
+        LOG_ERROR(Core, "Texture pack {} is invalid", pack_path);
+        return;
+    }
+    std::vector<CustomTexPackEntry> entries(header.num_entries);
+    if (!file.Seek(header.index_offset, SEEK_SET) ||
+        file.ReadArray(entries.data(), entries.size()) != entries.size()) {
+        LOG_ERROR(Core, "Failed to read the index of texture pack {}", pack_path);
+        return;
+    }
+    for (const CustomTexPackEntry& entry : entries) {
+        pack_entries.emplace(entry.hash, entry);
+    }
+    LOG_INFO(Core, "Loaded {} textures from texture pack {}", pack_entries.size(), pack_path);
+}
+
+std::optional<CustomTexInfo> CustomTexCache::LoadTexture(u64 hash) const {
+    // The texture pack is built from the texture files, so it takes precedence
+    if (const auto entry = pack_entries.find(hash); entry != pack_entries.end()) {
+        // Each load opens the pack again, so textures can be read from several threads
+        FileUtil::IOFile file(pack_path, "rb");
+        std::vector<u8> compressed(entry->second.size);
+        if (file.IsOpen() && file.Seek(entry->second.offset, SEEK_SET) &&
+            file.ReadBytes(compressed.data(), compressed.size()) == compressed.size()) {
+            CustomTexInfo tex_info{entry->second.width, entry->second.height,
+                                   Common::Compression::DecompressDataZSTD(compressed)};
+            if (tex_info.tex.size() == tex_info.width * tex_info.height * 4) {
+                return tex_info;
+            }
+        }
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {:016X} from the texture pack",
+                  hash);
+        return std::nullopt;
+    }
+
+    const auto path = custom_texture_paths.find(hash);
+    if (path == custom_texture_paths.end()) {
+        return std::nullopt;
+    }
+    const CustomTexPathInfo& path_info = path->second;
+    CustomTexInfo tex_info;
+    unsigned char* image =
+        stbi_load(path_info.path.c_str(), reinterpret_cast<int*>(&tex_info.width),
+                  reinterpret_cast<int*>(&tex_info.height), nullptr, 4);
+    if (image == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        return std::nullopt;
+    }
+    tex_info.tex.resize(tex_info.width * tex_info.height * 4);
+    std::memcpy(tex_info.tex.data(), image, tex_info.tex.size());
+    free(image);
+
+    // Make sure the texture size is a power of 2
+    std::bitset<32> width_bits(tex_info.width);
+    std::bitset<32> height_bits(tex_info.height);
+    if (width_bits.count() != 1 || height_bits.count() != 1) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        return std::nullopt;
+    }
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
+    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
+    return tex_info;
+}
+
+template <typename Callback>
+void CustomTexCache::LoadTexturesParallel(const std::vector<u64>& hashes,
+                                          Callback&& callback) const {
+    // Decoding PNGs and decompressing are independent, so textures are decoded in batches on the
+    // thread pool, keeping only one batch in memory at a time
+    Common::ThreadPool& thread_pool = Common::ThreadPool::GetPool();
+    const std::size_t num_workers = thread_pool.TotalThreads();
+    const std::size_t batch_size = num_workers * TEXTURES_PER_WORKER;
+    std::vector<std::optional<CustomTexInfo>> batch;
+    std::vector<std::future<void>> workers;
+    for (std::size_t begin = 0; begin < hashes.size(); begin += batch_size) {
+        const std::size_t end = std::min(begin + batch_size, hashes.size());
+        batch.assign(end - begin, std::nullopt);
+        std::atomic<std::size_t> next{begin};
+        for (std::size_t i = 0; i < std::min(num_workers, end - begin); ++i) {
+            workers.push_back(thread_pool.Push([&] {
+                for (std::size_t index = next++; index < end; index = next++) {
+                    batch[index - begin] = LoadTexture(hashes[index]);
+                }
+            }));
+        }
+        for (std::future<void>& worker : workers) {
+            worker.get();
+        }
+        workers.clear();
+
+        for (std::size_t index = begin; index < end; ++index) {
+            if (batch[index - begin] && !callback(hashes[index], *batch[index - begin])) {
+                return;
+            }
+        }
+    }
 }
 
 void CustomTexCache::PreloadTextures() {
+    std::vector<u64> hashes;
+    hashes.reserve(custom_texture_paths.size() + pack_entries.size());
     for (const auto& path : custom_texture_paths) {
-        const auto& path_info = path.second;
-        Core::CustomTexInfo tex_info;
-        unsigned char* image =
-            stbi_load(path_info.path.c_str(), reinterpret_cast<int*>(&tex_info.width),
-                      reinterpret_cast<int*>(&tex_info.height), nullptr, 4);
-        if (image != nullptr) {
-            tex_info.tex.resize(tex_info.width * tex_info.height * 4);
-            std::memcpy(tex_info.tex.data(), image, tex_info.tex.size());
-            free(image);
-
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-            }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        hashes.push_back(path.first);
+    }
+    for (const auto& entry : pack_entries) {
+        if (!custom_texture_paths.count(entry.first)) {
+            hashes.push_back(entry.first);
+        }
+    }
+
+    const std::size_t budget = GetMemoryBudget();
+    std::size_t preloaded_size = 0;
+    LoadTexturesParallel(hashes, [&](u64 hash, CustomTexInfo& tex_info) {
+        preloaded_size += GetTextureSize(tex_info);
+        if (budget != 0 && preloaded_size > budget) {
+            LOG_INFO(Core, "Custom texture memory budget reached, the other textures will be "
+                           "loaded when used");
+            return false;
+        }
+        CacheTexture(hash, std::move(tex_info));
+        return true;
+    });
+}
+
+void CustomTexCache::BuildTexturePack() {
+    std::vector<u64> hashes;
+    hashes.reserve(custom_texture_paths.size());
+    for (const auto& path : custom_texture_paths) {
+        hashes.push_back(path.first);
+    }
+    // Textures must be decoded from their files
+    pack_entries.clear();
+
+    const std::string temporary_path = pack_path + ".tmp";
+    FileUtil::IOFile file(temporary_path, "wb");
+    PackHeader header{PACK_MAGIC, PACK_VERSION, 0, 0};
+    if (!file.IsOpen() || file.WriteObject(header) != 1) {
+        LOG_ERROR(Core, "Failed to create texture pack {}", temporary_path);
+        return;
+    }
+
+    std::vector<CustomTexPackEntry> entries;
+    entries.reserve(hashes.size());
+    bool success = true;
+    LoadTexturesParallel(hashes, [&](u64 hash, CustomTexInfo& tex_info) {
+        const std::vector<u8> compressed =
+            Common::Compression::CompressDataZSTDDefault(tex_info.tex.data(), tex_info.tex.size());
+        entries.push_back({hash, tex_info.width, tex_info.height, file.Tell(), compressed.size()});
+        success = file.WriteBytes(compressed.data(), compressed.size()) == compressed.size();
+        return success;
+    });
+
+    header.num_entries = entries.size();
+    header.index_offset = file.Tell();
+    success = success && file.WriteArray(entries.data(), entries.size()) == entries.size() &&
+              file.Seek(0, SEEK_SET) && file.WriteObject(header) == 1;
+    file.Close();
+    if (success && FileUtil::Exists(pack_path)) {
+        success = FileUtil::Delete(pack_path);
+    }
+    if (!success || !FileUtil::Rename(temporary_path, pack_path)) {
+        LOG_ERROR(Core, "Failed to write texture pack {}", pack_path);
+        FileUtil::Delete(temporary_path);
+        return;
+    }
+    LOG_INFO(Core, "Built texture pack {} with {} textures", pack_path, entries.size());
+
+    LoadTexturePack();
+}
+
+void CustomTexCache::LoaderLoop() {
+    for (;;) {
+        const u64 hash = load_queue.PopWait();
+        if (stop_loader) {
+            return;
+        }
+        std::optional<CustomTexInfo> tex_info = LoadTexture(hash);
+        if (tex_info) {
+            CacheTexture(hash, std::move(*tex_info));
+        }
+        std::lock_guard lock(mutex);
+        queued_textures.erase(hash);
+        if (!tex_info) {
+            failed_textures.insert(hash);
         }
     }
 }
 
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
-    return custom_texture_paths.count(hash);
+    return custom_texture_paths.count(hash) || pack_entries.count(hash);
 }
 
 const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
@@ -4,11 +4,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "common/common_types.h"
+#include "common/threadsafe_queue.h"
 
 namespace Core {
 struct CustomTexInfo {
@@ -23,6 +30,15 @@ struct CustomTexPathInfo {
     u64 hash;
 };
 
+/// Location of a texture in the texture pack, stored as flipped RGBA8 compressed with Zstandard
+struct CustomTexPackEntry {
+    u64 hash;
+    u32 width;
+    u32 height;
+    u64 offset;
+    u64 size;
+};
+
 // TODO: think of a better name for this class...
 class CustomTexCache {
 public:
@@ -32,20 +48,59 @@ public:
     bool IsTextureDumped(u64 hash) const;
     void SetTextureDumped(u64 hash);
 
+    /**
+     * Returns the custom texture replacing the texture with the given hash if it's in memory.
+     * Otherwise returns nullptr, and starts loading it in the background if it exists.
+     */
+    std::shared_ptr<const CustomTexInfo> LookupTexture(u64 hash);
     bool IsTextureCached(u64 hash) const;
-    const CustomTexInfo& LookupTexture(u64 hash) const;
-    void CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height);
+    void CacheTexture(u64 hash, CustomTexInfo tex_info);
 
     void AddTexturePath(u64 hash, const std::string& path);
     void FindCustomTextures();
+    /// Finds the custom texture files in the directory, and the texture pack at the path
+    void FindCustomTextures(const std::string& load_path, const std::string& pack_path);
     void PreloadTextures();
     bool CustomTextureExists(u64 hash) const;
     const CustomTexPathInfo& LookupTexturePathInfo(u64 hash) const;
     bool IsTexturePathMapEmpty() const;
 
+    /// Writes all custom texture files to the texture pack of the current game, and uses it
+    void BuildTexturePack();
+
 private:
+    struct CachedTexture {
+        std::shared_ptr<const CustomTexInfo> info;
+        std::list<u64>::iterator lru_position;
+    };
+
+    /// Decodes a custom texture from the texture pack, or from its file
+    std::optional<CustomTexInfo> LoadTexture(u64 hash) const;
+
+    /// Decodes textures on the thread pool, calling the callback in order on this thread
+    template <typename Callback>
+    void LoadTexturesParallel(const std::vector<u64>& hashes, Callback&& callback) const;
+
+    void LoadTexturePack();
+    void LoaderLoop();
+
     std::unordered_set<u64> dumped_textures;
-    std::unordered_map<u64, CustomTexInfo> custom_textures;
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+
+    std::string pack_path;
+    std::unordered_map<u64, CustomTexPackEntry> pack_entries;
+
+    // Textures in memory, from the most to the least recently used. Textures are used by the
+    // renderer and loaded in the background, so these are guarded by the mutex.
+    mutable std::mutex mutex;
+    std::unordered_map<u64, CachedTexture> custom_textures;
+    std::list<u64> lru_textures;
+    std::size_t resident_size = 0;
+    std::unordered_set<u64> queued_textures;
+    std::unordered_set<u64> failed_textures;
+
+    Common::MPSCQueue<u64> load_queue;
+    std::atomic_bool stop_loader{false};
+    std::thread loader_thread;
 };
 } // namespace Core
@@ -1580,6 +1580,8 @@ const SVC::FunctionDef* SVC::GetSVCInfo(u32 func_num) {
 }
 
 void SVC::CallSVC(u32 immediate) {
+    Core::SubsystemTimer timer(Core::Subsystem::SVC);
+
     // Lock the global kernel mutex when we enter the kernel HLE.
     std::lock_guard lock{HLE::g_hle_lock};
 
@@ -7,12 +7,21 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
 
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
+    // Interrupts raised by commands running on the GPU thread are signaled from the emulation
+    // thread once the commands have run
+    if (VideoCore::g_gpu_thread != nullptr && VideoCore::g_gpu_thread->IsGPUThread()) {
+        VideoCore::g_gpu_thread->DeferInterrupt(interrupt_id);
+        return;
+    }
+
     auto gpu = gsp_gpu.lock();
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
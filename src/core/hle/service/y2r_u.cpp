@@ -6,6 +6,7 @@
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/process.h"
@@ -21,6 +22,16 @@ static const CoefficientSet standard_coefficients[4] = {
     {{0x12A, 0x1CA, 0x88, 0x36, 0x21C, -0x1F04, 0x99C, -0x2421}},  // ITU_Rec709_Scaling
 };
 
+/// Estimated time the hardware takes to convert a pixel, including the CDMA transfers. This puts
+/// a 400x240 frame at about 0.7 ms.
+constexpr u64 CONVERSION_CYCLES_PER_PIXEL = 2;
+
+/// Size of the output of a conversion in memory. dst_image_size would seem to be perfect for this,
+/// but it doesn't include the gap :(
+static u32 GetOutputSize(const ConversionConfiguration& conversion) {
+    return conversion.input_lines * (conversion.dst.transfer_unit + conversion.dst.gap);
+}
+
 ResultCode ConversionConfiguration::SetInputLineWidth(u16 width) {
     if (width == 0 || width > 1024 || width % 8 != 0) {
         return ResultCode(ErrorDescription::OutOfRange, ErrorModule::CAM,
@@ -498,18 +509,49 @@ void Y2R_U::GetDitheringWeightParams(Kernel::HLERequestContext& ctx) {
     LOG_DEBUG(Service_Y2R, "called");
 }
 
+void Y2R_U::CompletionEventCallBack(u64, s64) {
+    FinishConversion();
+    completion_event->Signal();
+}
+
+void Y2R_U::FinishConversion() {
+    if (!is_busy) {
+        return;
+    }
+    conversion_result.wait();
+    is_busy = false;
+
+    // The output may have been loaded by the rasterizer cache while the conversion was running
+    Memory::RasterizerFlushVirtualRegion(pending_conversion->config.dst.address,
+                                         GetOutputSize(pending_conversion->config),
+                                         Memory::FlushMode::Invalidate);
+}
+
 void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x26, 0, 0);
 
-    // dst_image_size would seem to be perfect for this, but it doesn't include the gap :(
-    u32 total_output_size =
-        conversion.input_lines * (conversion.dst.transfer_unit + conversion.dst.gap);
-    Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
+    if (is_busy) {
+        LOG_WARNING(Service_Y2R, "started a conversion while another one is in progress");
+        system.CoreTiming().UnscheduleEvent(completion_event_callback, 0);
+        FinishConversion();
+    }
+
+    Memory::RasterizerFlushVirtualRegion(conversion.dst.address, GetOutputSize(conversion),
                                          Memory::FlushMode::FlushAndInvalidate);
 
-    HW::Y2R::PerformConversion(system.Memory(), conversion);
+    if (!HW::Y2R::PrepareConversion(system.Memory(), conversion, *pending_conversion)) {
+        LOG_ERROR(Service_Y2R, "conversion buffers aren't mapped");
+    }
 
-    completion_event->Signal();
+    // The conversion runs while the emulated CPU keeps going. The completion event waits for it
+    // if it isn't finished by the time the hardware would be.
+    conversion_result = std::async(std::launch::async, [this] {
+        HW::Y2R::PerformConversion(*pending_conversion);
+    });
+    is_busy = true;
+    system.CoreTiming().ScheduleEvent(
+        CONVERSION_CYCLES_PER_PIXEL * conversion.input_line_width * conversion.input_lines,
+        completion_event_callback);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -520,6 +562,9 @@ void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
 void Y2R_U::StopConversion(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x27, 0, 0);
 
+    system.CoreTiming().UnscheduleEvent(completion_event_callback, 0);
+    FinishConversion();
+
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 
@@ -531,7 +576,7 @@ void Y2R_U::IsBusyConversion(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
-    rb.Push<u8>(0); // StartConversion always finishes immediately
+    rb.Push<u8>(is_busy);
 
     LOG_DEBUG(Service_Y2R, "called");
 }
@@ -683,9 +728,18 @@ Y2R_U::Y2R_U(Core::System& system) : ServiceFramework("y2r:u", 1), system(system
     RegisterHandlers(functions);
 
     completion_event = system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "Y2R:Completed");
+    completion_event_callback = system.CoreTiming().RegisterEvent(
+        "Y2R::CompletionEventCallBack",
+        [this](u64 userdata, s64 cycles_late) { CompletionEventCallBack(userdata, cycles_late); });
+    pending_conversion = std::make_unique<HW::Y2R::Conversion>();
 }
 
-Y2R_U::~Y2R_U() = default;
+Y2R_U::~Y2R_U() {
+    system.CoreTiming().RemoveEvent(completion_event_callback);
+    if (is_busy) {
+        conversion_result.wait();
+    }
+}
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <future>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -13,12 +14,17 @@
 
 namespace Core {
 class System;
-}
+struct TimingEventType;
+} // namespace Core
 
 namespace Kernel {
 class Event;
 }
 
+namespace HW::Y2R {
+struct Conversion;
+}
+
 namespace Service::Y2R {
 
 enum class InputFormat : u8 {
@@ -293,9 +299,18 @@ private:
     void DriverFinalize(Kernel::HLERequestContext& ctx);
     void GetPackageParameter(Kernel::HLERequestContext& ctx);
 
+    void CompletionEventCallBack(u64 userdata, s64 cycles_late);
+
+    /// Waits for the conversion in progress to be written to memory
+    void FinishConversion();
+
     Core::System& system;
 
     std::shared_ptr<Kernel::Event> completion_event;
+    Core::TimingEventType* completion_event_callback;
+    std::unique_ptr<HW::Y2R::Conversion> pending_conversion;
+    std::future<void> conversion_result;
+    bool is_busy = false;
     ConversionConfiguration conversion{};
     DitheringWeightParams dithering_weight_params{};
     bool temporal_dithering_enabled = false;
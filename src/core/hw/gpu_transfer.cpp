@@ -0,0 +1,571 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "common/alignment.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "core/hw/gpu_transfer.h"
+#include "video_core/utils.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace GPU {
+
+namespace {
+
+using PixelFormat = Regs::PixelFormat;
+
+constexpr std::size_t NUM_PIXEL_FORMATS = 5;
+
+constexpr u32 GetBytesPerPixel(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return 4;
+    case PixelFormat::RGB8:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case Regs::PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(src_pixel);
+
+    case Regs::PixelFormat::RGB8:
+        return Color::DecodeRGB8(src_pixel);
+
+    case Regs::PixelFormat::RGB565:
+        return Color::DecodeRGB565(src_pixel);
+
+    case Regs::PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(src_pixel);
+
+    case Regs::PixelFormat::RGBA4:
+        return Color::DecodeRGBA4(src_pixel);
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", static_cast<u32>(input_format));
+        return {0, 0, 0, 0};
+    }
+}
+
+void EncodePixel(Regs::PixelFormat output_format, const Common::Vec4<u8>& color, u8* dst_pixel) {
+    switch (output_format) {
+    case Regs::PixelFormat::RGBA8:
+        Color::EncodeRGBA8(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGB8:
+        Color::EncodeRGB8(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGB565:
+        Color::EncodeRGB565(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGB5A1:
+        Color::EncodeRGB5A1(color, dst_pixel);
+        break;
+
+    case Regs::PixelFormat::RGBA4:
+        Color::EncodeRGBA4(color, dst_pixel);
+        break;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                  static_cast<u32>(output_format));
+        break;
+    }
+}
+
+// The row converters decode to and encode from Common::Vec4<u8> colors stored in a u32, with red
+// in the lowest byte.
+
+u32 ToU32(const Common::Vec4<u8>& color) {
+    u32 pixel;
+    std::memcpy(&pixel, &color, sizeof(pixel));
+    return pixel;
+}
+
+Common::Vec4<u8> ToVec4(u32 pixel) {
+    Common::Vec4<u8> color;
+    std::memcpy(&color, &pixel, sizeof(pixel));
+    return color;
+}
+
+#ifdef ARCHITECTURE_x86_64
+__m128i Load(const void* source) {
+    return _mm_loadu_si128(static_cast<const __m128i*>(source));
+}
+
+void Store(void* dest, __m128i value) {
+    _mm_storeu_si128(static_cast<__m128i*>(dest), value);
+}
+
+/// Reverses the bytes of each 32 bit lane, which converts between RGBA8 in memory and colors
+__m128i ByteSwap32(__m128i value) {
+    value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+__m128i Expand4(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi32(value, 4), value);
+}
+
+__m128i Expand5(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi32(value, 3), _mm_srli_epi32(value, 2));
+}
+
+__m128i Expand6(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi32(value, 2), _mm_srli_epi32(value, 4));
+}
+
+__m128i Combine(__m128i r, __m128i g, __m128i b, __m128i a) {
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                        _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+}
+
+/// Decodes four 16 bit pixels held in the low halves of the 32 bit lanes
+template <PixelFormat format>
+__m128i Decode16(__m128i pixels) {
+    const __m128i mask4 = _mm_set1_epi32(0xF);
+    const __m128i mask5 = _mm_set1_epi32(0x1F);
+    if constexpr (format == PixelFormat::RGB565) {
+        const __m128i r = Expand5(_mm_srli_epi32(pixels, 11));
+        const __m128i g = Expand6(_mm_and_si128(_mm_srli_epi32(pixels, 5), _mm_set1_epi32(0x3F)));
+        const __m128i b = Expand5(_mm_and_si128(pixels, mask5));
+        return Combine(r, g, b, _mm_set1_epi32(0xFF));
+    } else if constexpr (format == PixelFormat::RGB5A1) {
+        const __m128i r = Expand5(_mm_srli_epi32(pixels, 11));
+        const __m128i g = Expand5(_mm_and_si128(_mm_srli_epi32(pixels, 6), mask5));
+        const __m128i b = Expand5(_mm_and_si128(_mm_srli_epi32(pixels, 1), mask5));
+        const __m128i a = _mm_sub_epi32(_mm_setzero_si128(),
+                                        _mm_and_si128(pixels, _mm_set1_epi32(1)));
+        return Combine(r, g, b, _mm_and_si128(a, _mm_set1_epi32(0xFF)));
+    } else {
+        const __m128i r = Expand4(_mm_srli_epi32(pixels, 12));
+        const __m128i g = Expand4(_mm_and_si128(_mm_srli_epi32(pixels, 8), mask4));
+        const __m128i b = Expand4(_mm_and_si128(_mm_srli_epi32(pixels, 4), mask4));
+        const __m128i a = Expand4(_mm_and_si128(pixels, mask4));
+        return Combine(r, g, b, a);
+    }
+}
+
+/// Encodes four colors to 16 bit pixels in the low halves of the 32 bit lanes
+template <PixelFormat format>
+__m128i Encode16(__m128i colors) {
+    const auto Field = [colors](int shift, u32 mask) {
+        const __m128i shifted =
+            shift > 0 ? _mm_srli_epi32(colors, shift) : _mm_slli_epi32(colors, -shift);
+        return _mm_and_si128(shifted, _mm_set1_epi32(static_cast<int>(mask)));
+    };
+    if constexpr (format == PixelFormat::RGB565) {
+        return _mm_or_si128(_mm_or_si128(Field(-8, 0xF800), Field(5, 0x7E0)), Field(19, 0x1F));
+    } else if constexpr (format == PixelFormat::RGB5A1) {
+        return _mm_or_si128(_mm_or_si128(Field(-8, 0xF800), Field(5, 0x7C0)),
+                            _mm_or_si128(Field(18, 0x3E), _mm_srli_epi32(colors, 31)));
+    } else {
+        return _mm_or_si128(_mm_or_si128(Field(-8, 0xF000), Field(4, 0xF00)),
+                            _mm_or_si128(Field(16, 0xF0), _mm_srli_epi32(colors, 28)));
+    }
+}
+
+/// Packs the low halves of the 32 bit lanes of two vectors
+__m128i Pack32To16(__m128i low, __m128i high) {
+    // Sign extending the halves keeps the signed saturation of packs from changing them
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+    return _mm_packs_epi32(low, high);
+}
+#endif
+
+template <PixelFormat format>
+void DecodeRow(const u8* source, u32* dest, u32 count) {
+    constexpr u32 bytes_per_pixel = GetBytesPerPixel(format);
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (format == PixelFormat::RGBA8) {
+        for (; i + 4 <= count; i += 4) {
+            Store(dest + i, ByteSwap32(Load(source + i * 4)));
+        }
+    } else if constexpr (bytes_per_pixel == 2) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            const __m128i pixels = Load(source + i * 2);
+            Store(dest + i, Decode16<format>(_mm_unpacklo_epi16(pixels, zero)));
+            Store(dest + i + 4, Decode16<format>(_mm_unpackhi_epi16(pixels, zero)));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        dest[i] = ToU32(DecodePixel(format, source + i * bytes_per_pixel));
+    }
+}
+
+template <PixelFormat format>
+void EncodeRow(const u32* source, u8* dest, u32 count) {
+    constexpr u32 bytes_per_pixel = GetBytesPerPixel(format);
+    u32 i = 0;
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (format == PixelFormat::RGBA8) {
+        for (; i + 4 <= count; i += 4) {
+            Store(dest + i * 4, ByteSwap32(Load(source + i)));
+        }
+    } else if constexpr (bytes_per_pixel == 2) {
+        for (; i + 8 <= count; i += 8) {
+            Store(dest + i * 2, Pack32To16(Encode16<format>(Load(source + i)),
+                                           Encode16<format>(Load(source + i + 4))));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        EncodePixel(format, ToVec4(source[i]), dest + i * bytes_per_pixel);
+    }
+}
+
+/// Averages two colors, rounding down
+constexpr u32 Average2(u32 a, u32 b) {
+    return (a & b) + (((a ^ b) >> 1) & 0x7F7F7F7F);
+}
+
+/// Averages four colors, rounding down
+constexpr u32 Average4(const u32* colors) {
+    u32 even = 0;
+    u32 odd = 0;
+    for (int i = 0; i < 4; ++i) {
+        even += colors[i] & 0x00FF00FF;
+        odd += (colors[i] >> 8) & 0x00FF00FF;
+    }
+    return ((even >> 2) & 0x00FF00FF) | (((odd >> 2) & 0x00FF00FF) << 8);
+}
+
+/// A pixel that's copied without being converted
+template <u32 bytes_per_pixel>
+struct RawPixel {
+    u8 bytes[bytes_per_pixel];
+};
+
+/**
+ * Copies a row out of a strip of 8x8 tiles in Morton order, scaling it down if needed. In Morton
+ * order, the texels of a row at an even x are followed by the next texel of the row, and by the
+ * texels of the next row after that when the row is even.
+ */
+template <typename Pixel>
+void ReadTileRow(const Pixel* strip, u32 row, u32 num_tiles,
+                 Regs::DisplayTransferConfig::ScalingMode scaling, Pixel* dest) {
+    for (u32 tile = 0; tile < num_tiles; ++tile) {
+        const Pixel* tile_pixels = strip + tile * 64;
+        for (u32 x = 0; x < 8; x += 2) {
+            const Pixel* pair = tile_pixels + VideoCore::MortonInterleave(x, row);
+            if constexpr (std::is_same_v<Pixel, u32>) {
+                if (scaling == Regs::DisplayTransferConfig::ScaleX) {
+                    dest[tile * 4 + x / 2] = Average2(pair[0], pair[1]);
+                    continue;
+                }
+                if (scaling == Regs::DisplayTransferConfig::ScaleXY) {
+                    dest[tile * 4 + x / 2] = Average4(pair);
+                    continue;
+                }
+            }
+            std::memcpy(dest + tile * 8 + x, pair, sizeof(Pixel) * 2);
+        }
+    }
+}
+
+/// Copies a row into a strip of 8x8 tiles in Morton order
+template <typename Pixel>
+void WriteTileRow(const Pixel* source, u32 row, u32 num_tiles, Pixel* strip) {
+    for (u32 tile = 0; tile < num_tiles; ++tile) {
+        Pixel* tile_pixels = strip + tile * 64;
+        for (u32 x = 0; x < 8; x += 2) {
+            std::memcpy(tile_pixels + VideoCore::MortonInterleave(x, row), source + tile * 8 + x,
+                        sizeof(Pixel) * 2);
+        }
+    }
+}
+
+/**
+ * Converts a display transfer a row at a time. Tiled input is decoded a strip of 8x8 tiles at
+ * once, and tiled output is encoded a strip at once, so the decoders and encoders always work on
+ * contiguous pixels.
+ */
+template <typename Pixel, u32 src_bytes_per_pixel, u32 dst_bytes_per_pixel, typename Decode,
+          typename Encode>
+void ConvertRows(const u8* src, u8* dst, const Regs::DisplayTransferConfig& config, Decode decode,
+                 Encode encode) {
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+    const u32 input_width = output_width << horizontal_scale;
+    const u32 input_stride = config.input_width * src_bytes_per_pixel;
+    const u32 output_stride = output_width * dst_bytes_per_pixel;
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+
+    static thread_local std::vector<Pixel> row;
+    static thread_local std::vector<Pixel> input_strip;
+    static thread_local std::vector<Pixel> output_strip;
+    row.resize(input_width);
+    if (input_tiled) {
+        input_strip.resize(input_width * 8);
+    }
+    if (output_tiled) {
+        output_strip.resize(output_width * 8);
+    }
+
+    u32 decoded_strip = ~0U;
+    for (u32 output_y = 0; output_y < output_height; ++output_y) {
+        // Flipping maps rows both ways, so this is where the output row comes from
+        const u32 y = config.flip_vertically ? output_height - output_y - 1 : output_y;
+
+        if (input_tiled) {
+            const u32 input_y = y << vertical_scale;
+            if (input_y / 8 != decoded_strip) {
+                decoded_strip = input_y / 8;
+                decode(src + decoded_strip * 8 * input_stride, input_strip.data(),
+                       input_width * 8);
+            }
+            ReadTileRow(input_strip.data(), input_y % 8, input_width / 8, config.scaling.Value(),
+                        row.data());
+        } else {
+            decode(src + y * input_stride, row.data(), output_width);
+        }
+
+        if (output_tiled) {
+            WriteTileRow(row.data(), output_y % 8, output_width / 8, output_strip.data());
+            if (output_y % 8 == 7) {
+                encode(output_strip.data(), dst + (output_y & ~7) * output_stride,
+                       output_width * 8);
+            }
+        } else {
+            encode(row.data(), dst + output_y * output_stride, output_width);
+        }
+    }
+}
+
+template <PixelFormat input_format, PixelFormat output_format>
+void ConvertFormats(const u8* src, u8* dst, const Regs::DisplayTransferConfig& config) {
+    constexpr u32 src_bytes_per_pixel = GetBytesPerPixel(input_format);
+    constexpr u32 dst_bytes_per_pixel = GetBytesPerPixel(output_format);
+
+    if constexpr (input_format == output_format) {
+        // Decoding and encoding to the same format gives back the same bytes, so only the layout
+        // changes
+        if (config.scaling == config.NoScale) {
+            using Pixel = RawPixel<src_bytes_per_pixel>;
+            ConvertRows<Pixel, src_bytes_per_pixel, dst_bytes_per_pixel>(
+                src, dst, config,
+                [](const u8* source, Pixel* dest, u32 count) {
+                    std::memcpy(dest, source, count * sizeof(Pixel));
+                },
+                [](const Pixel* source, u8* dest, u32 count) {
+                    std::memcpy(dest, source, count * sizeof(Pixel));
+                });
+            return;
+        }
+    }
+
+    ConvertRows<u32, src_bytes_per_pixel, dst_bytes_per_pixel>(
+        src, dst, config, DecodeRow<input_format>, EncodeRow<output_format>);
+}
+
+using ConvertFunction = void (*)(const u8*, u8*, const Regs::DisplayTransferConfig&);
+
+template <PixelFormat input_format>
+constexpr std::array<ConvertFunction, NUM_PIXEL_FORMATS> MakeConvertFunctions() {
+    return {ConvertFormats<input_format, PixelFormat::RGBA8>,
+            ConvertFormats<input_format, PixelFormat::RGB8>,
+            ConvertFormats<input_format, PixelFormat::RGB565>,
+            ConvertFormats<input_format, PixelFormat::RGB5A1>,
+            ConvertFormats<input_format, PixelFormat::RGBA4>};
+}
+
+constexpr std::array<std::array<ConvertFunction, NUM_PIXEL_FORMATS>, NUM_PIXEL_FORMATS>
+    convert_functions{
+        MakeConvertFunctions<PixelFormat::RGBA8>(),  MakeConvertFunctions<PixelFormat::RGB8>(),
+        MakeConvertFunctions<PixelFormat::RGB565>(), MakeConvertFunctions<PixelFormat::RGB5A1>(),
+        MakeConvertFunctions<PixelFormat::RGBA4>(),
+    };
+
+} // Anonymous namespace
+
+void FillMemory(u8* start, u8* end, const Regs::MemoryFillConfig& config) {
+    // Holds a whole number of 16, 24 and 32 bit values, so it can be stored repeatedly
+    std::array<u8, 48> pattern;
+    std::size_t size = end - start;
+
+    if (config.fill_24bit) {
+        // fill with 24-bit values, the last one may go past the end
+        for (std::size_t i = 0; i < pattern.size(); i += 3) {
+            pattern[i] = config.value_24bit_r;
+            pattern[i + 1] = config.value_24bit_g;
+            pattern[i + 2] = config.value_24bit_b;
+        }
+        size = Common::AlignUp(size, 3);
+    } else if (config.fill_32bit) {
+        // fill with 32-bit values
+        const u32 value = config.value_32bit;
+        for (std::size_t i = 0; i < pattern.size(); i += sizeof(u32)) {
+            std::memcpy(&pattern[i], &value, sizeof(u32));
+        }
+        size = Common::AlignDown(size, sizeof(u32));
+    } else {
+        // fill with 16-bit values, the last one may go past the end
+        const u16 value = config.value_16bit.Value();
+        for (std::size_t i = 0; i < pattern.size(); i += sizeof(u16)) {
+            std::memcpy(&pattern[i], &value, sizeof(u16));
+        }
+        size = Common::AlignUp(size, sizeof(u16));
+    }
+
+    // Copies of a constant size are done with wide stores
+    for (; size >= pattern.size(); size -= pattern.size(), start += pattern.size()) {
+        std::memcpy(start, pattern.data(), pattern.size());
+    }
+    std::memcpy(start, pattern.data(), size);
+}
+
+void DisplayTransferPixels(const u8* src_pointer, u8* dst_pointer,
+                           const Regs::DisplayTransferConfig& config) {
+    int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    u32 output_width = config.output_width >> horizontal_scale;
+    u32 output_height = config.output_height >> vertical_scale;
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            Common::Vec4<u8> src_color;
+
+            // Calculate the [x,y] position of the input image
+            // based on the current output position and the scale
+            u32 input_x = x << horizontal_scale;
+            u32 input_y = y << vertical_scale;
+
+            u32 output_y;
+            if (config.flip_vertically) {
+                // Flip the y value of the output data,
+                // we do this after calculating the [x,y] position of the input image
+                // to account for the scaling options.
+                output_y = output_height - y - 1;
+            } else {
+                output_y = y;
+            }
+
+            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+            u32 src_offset;
+            u32 dst_offset;
+
+            if (config.input_linear) {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as linear and the output as tiled
+                    u32 coarse_y = output_y & ~7;
+                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 coarse_y * stride;
+                } else {
+                    // Both input and output are linear
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as tiled and the output as linear
+                    u32 coarse_y = input_y & ~7;
+                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 coarse_y * stride;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    // Both input and output are tiled
+                    u32 out_coarse_y = output_y & ~7;
+                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                    u32 in_coarse_y = input_y & ~7;
+                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 in_coarse_y * in_stride;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 out_coarse_y * out_stride;
+                }
+            }
+
+            const u8* src_pixel = src_pointer + src_offset;
+            src_color = DecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                Common::Vec4<u8> pixel =
+                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                Common::Vec4<u8> pixel1 =
+                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel2 =
+                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel3 =
+                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            u8* dst_pixel = dst_pointer + dst_offset;
+            EncodePixel(config.output_format, src_color, dst_pixel);
+        }
+    }
+}
+
+bool DisplayTransferRows(const u8* src, u8* dst, const Regs::DisplayTransferConfig& config) {
+    const auto input_format = static_cast<std::size_t>(config.input_format.Value());
+    const auto output_format = static_cast<std::size_t>(config.output_format.Value());
+    if (input_format >= NUM_PIXEL_FORMATS || output_format >= NUM_PIXEL_FORMATS ||
+        config.scaling > config.ScaleXY ||
+        (config.input_linear && config.scaling != config.NoScale)) {
+        return false;
+    }
+
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+
+    // Tiled images are converted a strip of whole tiles at a time
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+    if (input_tiled && ((output_width << horizontal_scale) % 8 != 0 ||
+                        (output_height << vertical_scale) % 8 != 0)) {
+        return false;
+    }
+    if (output_tiled && (output_width % 8 != 0 || output_height % 8 != 0)) {
+        return false;
+    }
+
+    // Pixels are converted in a different order, so in-place transfers must go pixel by pixel
+    const std::size_t input_size = static_cast<std::size_t>(output_height << vertical_scale) *
+                                   config.input_width *
+                                   GetBytesPerPixel(config.input_format.Value());
+    const std::size_t output_size = static_cast<std::size_t>(output_height) * output_width *
+                                    GetBytesPerPixel(config.output_format.Value());
+    if (src < dst + output_size && dst < src + input_size) {
+        return false;
+    }
+
+    convert_functions[input_format][output_format](src, dst, config);
+    return true;
+}
+
+} // namespace GPU
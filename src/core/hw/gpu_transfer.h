@@ -0,0 +1,25 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/// Fills the memory from start to end with the value of a memory fill
+void FillMemory(u8* start, u8* end, const Regs::MemoryFillConfig& config);
+
+/// Converts the pixels of a display transfer one at a time. Handles every configuration.
+void DisplayTransferPixels(const u8* src, u8* dst, const Regs::DisplayTransferConfig& config);
+
+/**
+ * Converts the pixels of a display transfer a row at a time, with converters specialized for the
+ * input and output formats. The result is the same as DisplayTransferPixels.
+ * @returns false if the configuration isn't supported, in which case nothing was written
+ */
+bool DisplayTransferRows(const u8* src, u8* dst, const Regs::DisplayTransferConfig& config);
+
+} // namespace GPU
@@ -5,16 +5,21 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/logging/log.h"
 #include "common/vector_math.h"
-#include "core/core.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
 #include "core/memory.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace HW::Y2R {
 
 using namespace Service::Y2R;
@@ -23,10 +28,115 @@ static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
+#ifdef ARCHITECTURE_x86_64
+static __m128i LoadLuma(const u8* input) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)),
+                             _mm_setzero_si128());
+}
+
+/// Loads 4 chroma samples and repeats each of them for two pixels
+static __m128i LoadChroma(const u8* input) {
+    u32 samples;
+    std::memcpy(&samples, input, sizeof(samples));
+    const __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(samples));
+    return _mm_unpacklo_epi8(_mm_unpacklo_epi8(bytes, bytes), _mm_setzero_si128());
+}
+
+/**
+ * Converts 8 pixels with the same fixed point calculation as ConvertYUVToRGB. The components are
+ * interleaved in pairs so that _mm_madd_epi16 does both multiplications of a channel at once.
+ */
+static void ConvertPixelsSSE2(__m128i Y, __m128i U, __m128i V, const CoefficientSet& c,
+                              u32* output) {
+    const __m128i c_Y_V = _mm_set1_epi32((static_cast<u16>(c[1]) << 16) | static_cast<u16>(c[0]));
+    const __m128i c_Y = _mm_set1_epi32(static_cast<u16>(c[0]));
+    const __m128i c_V_U = _mm_set1_epi32((static_cast<u16>(c[3]) << 16) | static_cast<u16>(c[2]));
+    const __m128i c_Y_U = _mm_set1_epi32((static_cast<u16>(c[4]) << 16) | static_cast<u16>(c[0]));
+    const s32 rounding_offset = 0x18;
+
+    const auto channel = [](__m128i low, __m128i high, s32 offset) {
+        const __m128i offset_vector = _mm_set1_epi32(offset);
+        low = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(low, 3), offset_vector), 5);
+        high = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(high, 3), offset_vector), 5);
+        // Saturating to 16 bits doesn't change the result of the clamp
+        const __m128i value = _mm_packs_epi32(low, high);
+        return _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(0xFF));
+    };
+
+    const __m128i Y_V_low = _mm_unpacklo_epi16(Y, V);
+    const __m128i Y_V_high = _mm_unpackhi_epi16(Y, V);
+    const __m128i V_U_low = _mm_unpacklo_epi16(V, U);
+    const __m128i V_U_high = _mm_unpackhi_epi16(V, U);
+    const __m128i Y_U_low = _mm_unpacklo_epi16(Y, U);
+    const __m128i Y_U_high = _mm_unpackhi_epi16(Y, U);
+
+    const __m128i r = channel(_mm_madd_epi16(Y_V_low, c_Y_V), _mm_madd_epi16(Y_V_high, c_Y_V),
+                              c[5] + rounding_offset);
+    const __m128i g = channel(
+        _mm_sub_epi32(_mm_madd_epi16(Y_V_low, c_Y), _mm_madd_epi16(V_U_low, c_V_U)),
+        _mm_sub_epi32(_mm_madd_epi16(Y_V_high, c_Y), _mm_madd_epi16(V_U_high, c_V_U)),
+        c[6] + rounding_offset);
+    const __m128i b = channel(_mm_madd_epi16(Y_U_low, c_Y_U), _mm_madd_epi16(Y_U_high, c_Y_U),
+                              c[7] + rounding_offset);
+
+    // Each pixel is r << 24 | g << 16 | b << 8
+    const __m128i low_half = _mm_slli_epi16(b, 8);
+    const __m128i high_half = _mm_or_si128(_mm_slli_epi16(r, 8), g);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(low_half, high_half));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4),
+                     _mm_unpackhi_epi16(low_half, high_half));
+}
+
+/// Converts a image strip 8 pixels (a tile row) at a time
+static void ConvertYUVToRGBSSE2(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                                const u8* input_V, ImageTile output[], unsigned int width,
+                                unsigned int height, const CoefficientSet& coefficients) {
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; x += 8) {
+            __m128i Y, U, V;
+            switch (input_format) {
+            case InputFormat::YUV422_Indiv8:
+            case InputFormat::YUV422_Indiv16:
+                Y = LoadLuma(&input_Y[y * width + x]);
+                U = LoadChroma(&input_U[(y * width + x) / 2]);
+                V = LoadChroma(&input_V[(y * width + x) / 2]);
+                break;
+            case InputFormat::YUV420_Indiv8:
+            case InputFormat::YUV420_Indiv16:
+                Y = LoadLuma(&input_Y[y * width + x]);
+                U = LoadChroma(&input_U[((y / 2) * width + x) / 2]);
+                V = LoadChroma(&input_V[((y / 2) * width + x) / 2]);
+                break;
+            case InputFormat::YUYV422_Interleaved: {
+                const u8* pixels = &input_Y[(y * width + x) * 2];
+                const __m128i YUYV = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+                Y = _mm_and_si128(YUYV, _mm_set1_epi16(0xFF));
+                const __m128i UV = _mm_srli_epi16(YUYV, 8);
+                U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(UV, _MM_SHUFFLE(2, 2, 0, 0)),
+                                        _MM_SHUFFLE(2, 2, 0, 0));
+                V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(UV, _MM_SHUFFLE(3, 3, 1, 1)),
+                                        _MM_SHUFFLE(3, 3, 1, 1));
+                break;
+            }
+            default:
+                UNREACHABLE();
+            }
+
+            ConvertPixelsSSE2(Y, U, V, coefficients, &output[x / 8][y * 8]);
+        }
+    }
+}
+#endif
+
 /// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
 static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
                             const u8* input_V, ImageTile output[], unsigned int width,
                             unsigned int height, const CoefficientSet& coefficients) {
+#ifdef ARCHITECTURE_x86_64
+    ConvertYUVToRGBSSE2(input_format, input_Y, input_U, input_V, output, width, height,
+                        coefficients);
+    return;
+#endif
 
     for (unsigned int y = 0; y < height; ++y) {
         for (unsigned int x = 0; x < width; ++x) {
@@ -79,10 +189,8 @@ static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u
 /// Simulates an incoming CDMA transfer. The N parameter is used to automatically convert 16-bit
 /// formats to 8-bit.
 template <std::size_t N>
-static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuffer& buf,
+static void ReceiveData(const u8* input, u8* output, const ConversionBuffer& buf,
                         std::size_t amount_of_data) {
-    const u8* input = memory.GetPointer(buf.address);
-
     std::size_t output_unit = buf.transfer_unit / N;
     ASSERT(amount_of_data % output_unit == 0);
 
@@ -93,20 +201,15 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
 
         output += output_unit;
         input += buf.transfer_unit + buf.gap;
-
-        buf.address += buf.transfer_unit + buf.gap;
-        buf.image_size -= buf.transfer_unit;
         amount_of_data -= output_unit;
     }
 }
 
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
-                     int amount_of_data, OutputFormat output_format, u8 alpha) {
-
-    u8* output = memory.GetPointer(buf.address);
-
+template <OutputFormat output_format>
+static void SendData(const u32* input, u8* output, const ConversionBuffer& buf,
+                     int amount_of_data, u8 alpha) {
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
         while (output < unit_end) {
@@ -136,11 +239,59 @@ static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionB
         }
 
         output += buf.gap;
-        buf.address += buf.transfer_unit + buf.gap;
-        buf.image_size -= buf.transfer_unit;
     }
 }
 
+static void SendData(const u32* input, u8* output, const ConversionBuffer& buf, int amount_of_data,
+                     OutputFormat output_format, u8 alpha) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        SendData<OutputFormat::RGBA8>(input, output, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB8:
+        SendData<OutputFormat::RGB8>(input, output, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB5A1:
+        SendData<OutputFormat::RGB5A1>(input, output, buf, amount_of_data, alpha);
+        break;
+    case OutputFormat::RGB565:
+        SendData<OutputFormat::RGB565>(input, output, buf, amount_of_data, alpha);
+        break;
+    }
+}
+
+static u32 BytesPerPixel(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    }
+    UNREACHABLE();
+}
+
+/// Resolves the start of a transfer and advances the buffer past it, like ReceiveData and SendData
+/// do with their units of pixels_per_unit pixels
+template <typename T>
+static bool ResolveTransfer(Memory::MemorySystem& memory, ConversionBuffer& buf,
+                            std::size_t amount_of_data, std::size_t pixels_per_unit, T*& pointer) {
+    if (pixels_per_unit == 0) {
+        LOG_ERROR(Service_Y2R, "Transfer unit at 0x{:08X} is too small", buf.address);
+        return false;
+    }
+    pointer = memory.GetPointer(buf.address);
+    if (pointer == nullptr) {
+        return false;
+    }
+    const std::size_t units = (amount_of_data + pixels_per_unit - 1) / pixels_per_unit;
+    buf.address += static_cast<u32>(units * (buf.transfer_unit + buf.gap));
+    buf.image_size -= static_cast<u32>(units * buf.transfer_unit);
+    return true;
+}
+
 static const u8 linear_lut[TILE_SIZE] = {
     // clang-format off
      0,  1,  2,  3,  4,  5,  6,  7,
@@ -210,6 +361,54 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
     }
 }
 
+bool PrepareConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt,
+                       Conversion& conversion) {
+    conversion.config = cvt;
+    conversion.strips.clear();
+
+    const std::size_t dst_pixels_per_unit =
+        (cvt.dst.transfer_unit + BytesPerPixel(cvt.output_format) - 1) /
+        BytesPerPixel(cvt.output_format);
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
+        const std::size_t row_data_size = std::min(cvt.input_lines - y, 8u) * cvt.input_line_width;
+        StripBuffers strip;
+
+        bool resolved = true;
+        switch (cvt.input_format) {
+        case InputFormat::YUV422_Indiv8:
+        case InputFormat::YUV420_Indiv8:
+        case InputFormat::YUV422_Indiv16:
+        case InputFormat::YUV420_Indiv16: {
+            const bool is_16bit = cvt.input_format == InputFormat::YUV422_Indiv16 ||
+                                  cvt.input_format == InputFormat::YUV420_Indiv16;
+            const bool is_420 = cvt.input_format == InputFormat::YUV420_Indiv8 ||
+                                cvt.input_format == InputFormat::YUV420_Indiv16;
+            const std::size_t N = is_16bit ? 2 : 1;
+            const std::size_t uv_data_size = row_data_size / (is_420 ? 4 : 2);
+            resolved = ResolveTransfer(memory, cvt.src_Y, row_data_size,
+                                       cvt.src_Y.transfer_unit / N, strip.src_Y) &&
+                       ResolveTransfer(memory, cvt.src_U, uv_data_size,
+                                       cvt.src_U.transfer_unit / N, strip.src_U) &&
+                       ResolveTransfer(memory, cvt.src_V, uv_data_size,
+                                       cvt.src_V.transfer_unit / N, strip.src_V);
+            break;
+        }
+        case InputFormat::YUYV422_Interleaved:
+            resolved = ResolveTransfer(memory, cvt.src_YUYV, row_data_size * 2,
+                                       cvt.src_YUYV.transfer_unit, strip.src_Y);
+            break;
+        }
+
+        if (!resolved ||
+            !ResolveTransfer(memory, cvt.dst, row_data_size, dst_pixels_per_unit, strip.dst)) {
+            conversion.strips.clear();
+            return false;
+        }
+        conversion.strips.push_back(strip);
+    }
+    return true;
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -259,8 +458,16 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  *
  * Hardware behaves strangely (doesn't fire the completion interrupt, for example) in these cases,
  * so they are believed to be invalid configurations anyway.
+ *
+ * The transfers are resolved to host pointers beforehand by PrepareConversion, so that the
+ * conversion itself can run on a worker thread while the emulated CPU keeps going.
  */
-void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
+void PerformConversion(const Conversion& conversion) {
+    const ConversionConfiguration& cvt = conversion.config;
+    if (conversion.strips.empty()) {
+        return;
+    }
+
     ASSERT(cvt.input_line_width % 8 == 0);
     ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
     // Tiles per row
@@ -287,6 +494,7 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
 
     for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
         unsigned int row_height = std::min(cvt.input_lines - y, 8u);
+        const StripBuffers& strip = conversion.strips[y / 8];
 
         // Total size in pixels of incoming data required for this strip.
         const std::size_t row_data_size = row_height * cvt.input_line_width;
@@ -297,29 +505,29 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
 
         switch (cvt.input_format) {
         case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+            ReceiveData<1>(strip.src_Y, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(strip.src_U, input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<1>(strip.src_V, input_V, cvt.src_V, row_data_size / 2);
             break;
         case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+            ReceiveData<1>(strip.src_Y, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(strip.src_U, input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<1>(strip.src_V, input_V, cvt.src_V, row_data_size / 4);
             break;
         case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+            ReceiveData<2>(strip.src_Y, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(strip.src_U, input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<2>(strip.src_V, input_V, cvt.src_V, row_data_size / 2);
             break;
         case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+            ReceiveData<2>(strip.src_Y, input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(strip.src_U, input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<2>(strip.src_V, input_V, cvt.src_V, row_data_size / 4);
             break;
         case InputFormat::YUYV422_Interleaved:
             input_U = nullptr;
             input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+            ReceiveData<1>(strip.src_Y, input_Y, cvt.src_YUYV, row_data_size * 2);
             break;
         }
 
@@ -373,8 +581,8 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
 
         // Note(yuriks): If additional optimization is required, output_format can be moved to a
         // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+        SendData(reinterpret_cast<u32*>(data_buffer.get()), strip.dst, cvt.dst,
+                 (int)row_data_size, cvt.output_format, (u8)cvt.alpha);
     }
 }
 } // namespace HW::Y2R
@@ -4,14 +4,39 @@
 
 #pragma once
 
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/service/y2r_u.h"
+
 namespace Memory {
 class MemorySystem;
 }
 
-namespace Service::Y2R {
-struct ConversionConfiguration;
-} // namespace Service::Y2R
-
 namespace HW::Y2R {
-void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt);
+
+/// Host pointers to the data transferred for one 8 line strip of a conversion
+struct StripBuffers {
+    const u8* src_Y = nullptr; ///< Also used for YUYV422_Interleaved input
+    const u8* src_U = nullptr;
+    const u8* src_V = nullptr;
+    u8* dst = nullptr;
+};
+
+/// A conversion whose buffers were resolved to host memory
+struct Conversion {
+    Service::Y2R::ConversionConfiguration config{};
+    std::vector<StripBuffers> strips;
+};
+
+/**
+ * Resolves the buffers of each strip of a conversion, advancing the buffers of cvt the way the
+ * transfers do. Must be called from the emulation thread.
+ * @returns false if a buffer isn't in mapped memory, in which case nothing should be converted
+ */
+bool PrepareConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt,
+                       Conversion& conversion);
+
+/// Performs a prepared conversion. It doesn't use the memory system, so it can run on any thread.
+void PerformConversion(const Conversion& conversion);
+
 } // namespace HW::Y2R
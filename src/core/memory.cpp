@@ -407,6 +407,8 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
+    Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+    VideoCore::SynchronizeGPUThread("rasterizer cache access");
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
@@ -415,6 +417,8 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+    VideoCore::SynchronizeGPUThread("rasterizer cache access");
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
@@ -425,6 +429,8 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+    VideoCore::SynchronizeGPUThread("rasterizer cache access");
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
@@ -435,6 +441,9 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         return;
     }
 
+    Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+    VideoCore::SynchronizeGPUThread("rasterizer cache access");
+
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -4,7 +4,9 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iterator>
+#include <limits>
 #include <mutex>
 #include <numeric>
 #include <thread>
@@ -27,6 +29,110 @@ constexpr std::size_t IgnoreFrames = 5;
 
 namespace Core {
 
+namespace {
+
+std::array<std::atomic<u64>, static_cast<std::size_t>(Subsystem::Count)> subsystem_times_ns{};
+
+/// The innermost timer of the thread
+thread_local SubsystemTimer* current_timer = nullptr;
+
+void AddSubsystemTime(Subsystem subsystem, std::chrono::steady_clock::duration time) {
+    subsystem_times_ns[static_cast<std::size_t>(subsystem)].fetch_add(
+        static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()),
+        std::memory_order_relaxed);
+}
+
+} // Anonymous namespace
+
+std::atomic<bool> g_subsystem_times_enabled{false};
+
+void SetSubsystemTimesEnabled(bool enabled) {
+    g_subsystem_times_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+const char* GetSubsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+    case Subsystem::CPU:
+        return "cpu";
+    case Subsystem::SVC:
+        return "svc";
+    case Subsystem::HLE:
+        return "hle";
+    case Subsystem::PICA:
+        return "pica";
+    case Subsystem::Rasterizer:
+        return "rasterizer";
+    case Subsystem::Audio:
+        return "audio";
+    case Subsystem::Present:
+        return "present";
+    default:
+        return "unknown";
+    }
+}
+
+SubsystemTimer::SubsystemTimer(Subsystem subsystem)
+    : subsystem(subsystem), timed(AreSubsystemTimesEnabled()),
+      parent(timed ? current_timer : nullptr), trace_scope(GetSubsystemName(subsystem)) {
+    if (!timed) {
+        return;
+    }
+
+    start = std::chrono::steady_clock::now();
+    // The parent is paused while this timer is alive
+    if (parent != nullptr) {
+        AddSubsystemTime(parent->subsystem, start - parent->start);
+    }
+    current_timer = this;
+}
+
+SubsystemTimer::~SubsystemTimer() {
+    if (!timed) {
+        return;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    AddSubsystemTime(subsystem, end - start);
+    if (parent != nullptr) {
+        parent->start = end;
+    }
+    current_timer = parent;
+}
+
+SubsystemTimes GetSubsystemTimes() {
+    SubsystemTimes times;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        times[i] = std::chrono::nanoseconds(subsystem_times_ns[i].load(std::memory_order_relaxed));
+    }
+    return times;
+}
+
+void ResetSubsystemTimes() {
+    for (auto& time : subsystem_times_ns) {
+        time.store(0, std::memory_order_relaxed);
+    }
+}
+
+TimeSummary SummarizeTimes(std::vector<double> times) {
+    TimeSummary summary;
+    if (times.empty()) {
+        return summary;
+    }
+
+    std::sort(times.begin(), times.end());
+    const auto Percentile = [&times](double percent) {
+        const auto rank = static_cast<std::size_t>(std::ceil(percent / 100.0 * times.size()));
+        return times[std::max<std::size_t>(rank, 1) - 1];
+    };
+    summary.mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    summary.p50 = Percentile(50);
+    summary.p90 = Percentile(90);
+    summary.p95 = Percentile(95);
+    summary.p99 = Percentile(99);
+    summary.max = times.back();
+    return summary;
+}
+
 PerfStats::~PerfStats() {
     if (!Settings::values.record_frame_times) {
         return;
@@ -70,6 +176,38 @@ void PerfStats::EndSystemFrame() {
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
+
+    RecordFrameBreakdown(frame_time, previous_frame_length);
+}
+
+void PerfStats::RecordFrameBreakdown(Clock::duration frame_time, Clock::duration frame_period) {
+    const auto ToMicroseconds = [](auto duration) {
+        const s64 count = duration_cast<microseconds>(duration).count();
+        return static_cast<u32>(std::clamp<s64>(count, 0, std::numeric_limits<u32>::max()));
+    };
+
+    const SubsystemTimes subsystem_times = GetSubsystemTimes();
+    const u64 index = num_frame_breakdowns.load(std::memory_order_relaxed);
+    FrameBreakdownSlot& slot = frame_breakdowns[index % FRAME_BREAKDOWN_COUNT];
+
+    // Seqlock, the readers skip the slot if its sequence changes while they read it
+    const u32 sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.frame_time.store(ToMicroseconds(frame_time), std::memory_order_relaxed);
+    slot.frame_period.store(ToMicroseconds(frame_period), std::memory_order_relaxed);
+    for (std::size_t i = 0; i < subsystem_times.size(); ++i) {
+        // The times start again from zero when they're reset
+        const auto time = subsystem_times[i] >= previous_subsystem_times[i]
+                              ? subsystem_times[i] - previous_subsystem_times[i]
+                              : subsystem_times[i];
+        slot.subsystem_times[i].store(ToMicroseconds(time), std::memory_order_relaxed);
+    }
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    num_frame_breakdowns.store(index + 1, std::memory_order_release);
+    previous_subsystem_times = subsystem_times;
 }
 
 double PerfStats::GetLastFrameTimeScale() {
@@ -79,6 +217,48 @@ double PerfStats::GetLastFrameTimeScale() {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+std::vector<double> PerfStats::GetFrameTimes() {
+    std::lock_guard lock{object_mutex};
+
+    if (current_index <= IgnoreFrames) {
+        return {};
+    }
+    return std::vector<double>(perf_history.begin() + IgnoreFrames,
+                               perf_history.begin() + current_index);
+}
+
+std::vector<FrameBreakdown> PerfStats::GetFrameBreakdowns(std::size_t count) const {
+    const u64 end = num_frame_breakdowns.load(std::memory_order_acquire);
+    const u64 begin = end - std::min<u64>({count, end, FRAME_BREAKDOWN_COUNT});
+
+    std::vector<FrameBreakdown> breakdowns;
+    breakdowns.reserve(end - begin);
+    for (u64 frame = begin; frame < end; ++frame) {
+        const FrameBreakdownSlot& slot = frame_breakdowns[frame % FRAME_BREAKDOWN_COUNT];
+        // Each write of the slot adds 2 to the sequence
+        const auto expected_sequence = static_cast<u32>(2 * (frame / FRAME_BREAKDOWN_COUNT + 1));
+        if (slot.sequence.load(std::memory_order_acquire) != expected_sequence) {
+            continue;
+        }
+
+        FrameBreakdown breakdown;
+        breakdown.frame_number = frame;
+        breakdown.frame_time = slot.frame_time.load(std::memory_order_relaxed) / 1000.0;
+        breakdown.frame_period = slot.frame_period.load(std::memory_order_relaxed) / 1000.0;
+        for (std::size_t i = 0; i < breakdown.subsystem_times.size(); ++i) {
+            breakdown.subsystem_times[i] =
+                slot.subsystem_times[i].load(std::memory_order_relaxed) / 1000.0;
+        }
+
+        // Skips the slot if the emulation thread overwrote it while it was read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == expected_sequence) {
+            breakdowns.push_back(breakdown);
+        }
+    }
+    return breakdowns;
+}
+
 void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
     if (frame_advancing_enabled) {
         // Frame advancing is enabled: wait on event instead of doing framelimiting
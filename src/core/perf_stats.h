@@ -9,11 +9,90 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <vector>
 #include "common/common_types.h"
 #include "common/thread.h"
+#include "common/trace.h"
 
 namespace Core {
 
+/// Subsystems whose time is measured by SubsystemTimer
+enum class Subsystem : std::size_t {
+    CPU,        ///< Running the emulated ARM code
+    SVC,        ///< Handling supervisor calls, except service requests
+    HLE,        ///< Handling service requests
+    PICA,       ///< Processing GPU command lists, including vertex shaders
+    Rasterizer, ///< Drawing triangles and flushing the rasterizer cache
+    Audio,      ///< Generating DSP audio frames
+    Present,    ///< Drawing the screens at the end of a frame, before the frame limiting
+    Count,
+};
+
+/// Returns the name of the subsystem
+const char* GetSubsystemName(Subsystem subsystem);
+
+extern std::atomic<bool> g_subsystem_times_enabled;
+
+/// Starts or stops adding the time of SubsystemTimers to their subsystems
+void SetSubsystemTimesEnabled(bool enabled);
+
+inline bool AreSubsystemTimesEnabled() {
+    return g_subsystem_times_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Adds the time until it's destroyed to a subsystem, if the subsystem times are enabled. The time
+ * of the timers created on the same thread while it's alive is only added to their own
+ * subsystems, so nested subsystems aren't counted twice. The time is also recorded as a slice of
+ * the thread's trace. A timer costs two atomic loads while neither is enabled.
+ */
+class SubsystemTimer {
+public:
+    explicit SubsystemTimer(Subsystem subsystem);
+    ~SubsystemTimer();
+
+    SubsystemTimer(const SubsystemTimer&) = delete;
+    SubsystemTimer& operator=(const SubsystemTimer&) = delete;
+
+private:
+    Subsystem subsystem;
+    /// Keeps the nesting consistent if the subsystem times are toggled inside the timer
+    bool timed;
+    SubsystemTimer* parent;
+    std::chrono::steady_clock::time_point start;
+    Common::Trace::Scope trace_scope;
+};
+
+using SubsystemTimes =
+    std::array<std::chrono::nanoseconds, static_cast<std::size_t>(Subsystem::Count)>;
+
+/// Returns the time spent in each subsystem by every thread since the last reset
+SubsystemTimes GetSubsystemTimes();
+
+/// Sets the time spent in each subsystem to zero
+void ResetSubsystemTimes();
+
+/// Statistics of a series of times
+struct TimeSummary {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/// Returns the statistics of the times, the percentiles are nearest rank percentiles
+TimeSummary SummarizeTimes(std::vector<double> times);
+
+/// Times of a system frame in milliseconds
+struct FrameBreakdown {
+    u64 frame_number = 0;
+    double frame_time = 0.0;   ///< From the beginning to the end of the system frame
+    double frame_period = 0.0; ///< From the end of the previous system frame, with frame limiting
+    std::array<double, static_cast<std::size_t>(Subsystem::Count)> subsystem_times{};
+};
+
 /**
  * Class to manage and query performance/timing statistics. All public functions of this class are
  * thread-safe unless stated otherwise.
@@ -33,7 +112,30 @@ public:
      */
     double GetLastFrameTimeScale();
 
+    /// Returns the times of the system frames in milliseconds, without the frames of the boot
+    std::vector<double> GetFrameTimes();
+
+    /**
+     * Returns the breakdowns of up to the given number of the last system frames, oldest first.
+     * This doesn't block the emulation thread.
+     */
+    std::vector<FrameBreakdown> GetFrameBreakdowns(std::size_t count) const;
+
+    /// Number of system frames whose breakdowns are kept
+    static constexpr std::size_t FRAME_BREAKDOWN_COUNT = 1024;
+
 private:
+    /// A frame breakdown in microseconds, read by other threads while it may be overwritten
+    struct FrameBreakdownSlot {
+        /// Odd while the slot is being written
+        std::atomic<u32> sequence{0};
+        std::atomic<u32> frame_time{0};
+        std::atomic<u32> frame_period{0};
+        std::array<std::atomic<u32>, static_cast<std::size_t>(Subsystem::Count)> subsystem_times{};
+    };
+
+    void RecordFrameBreakdown(Clock::duration frame_time, Clock::duration frame_period);
+
     std::mutex object_mutex{};
 
     /// Current index for writing to the perf_history array
@@ -51,6 +153,15 @@ private:
 
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Ring buffer of the frame breakdowns, only written by the emulation thread
+    std::array<FrameBreakdownSlot, FRAME_BREAKDOWN_COUNT> frame_breakdowns;
+
+    /// Number of frame breakdowns ever recorded
+    std::atomic<u64> num_frame_breakdowns{0};
+
+    /// Subsystem times at the end of the previous system frame
+    SubsystemTimes previous_subsystem_times = GetSubsystemTimes();
 };
 
 class FrameLimiter {
@@ -7,8 +7,8 @@
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
-#include "common/stb_image_write.h"
 #include "common/thread.h"
+#include "common/trace.h"
 #include "common/version.h"
 #include "core/arm/arm_interface.h"
 #include "core/cheats/cheat_base.h"
@@ -22,7 +22,10 @@
 #include "core/memory.h"
 #include "core/movie.h"
 #include "core/rpc/server.h"
+#include "video_core/command_processor.h"
+#include "video_core/frame_capture.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
 #include "video_core/video_core.h"
 
 namespace Settings {
@@ -73,6 +76,78 @@ void from_json(const nlohmann::json& json, Vec3<float>& v) {
 
 namespace RPC {
 
+namespace {
+
+/// Replies with the frame, encoded in the format and PNG level of the query parameters
+void SendCapturedFrame(const httplib::Request& req, httplib::Response& res,
+                       std::shared_ptr<const VideoCore::CapturedFrame> frame) {
+    const auto format = VideoCore::ParseCaptureFormat(
+        req.has_param("format") ? req.get_param_value("format") : "png");
+    if (!format) {
+        res.status = 400;
+        res.set_content("invalid format", "text/plain");
+        return;
+    }
+
+    int level = 8;
+    try {
+        if (req.has_param("level")) {
+            level = std::stoi(req.get_param_value("level"));
+        }
+    } catch (std::logic_error&) {
+        res.status = 400;
+        res.set_content("invalid level", "text/plain");
+        return;
+    }
+    if (level < VideoCore::MIN_PNG_LEVEL) {
+        res.status = 400;
+        res.set_content("invalid level", "text/plain");
+        return;
+    }
+
+    res.set_header("X-Frame-Number", std::to_string(frame->number));
+    res.set_header("X-Frame-Width", std::to_string(frame->width));
+    res.set_header("X-Frame-Height", std::to_string(frame->height));
+    res.set_header("Content-Type", VideoCore::GetCaptureFormatMimeType(*format));
+
+    // The reply is sent from the frame or the encoded data without copying them into the body
+    if (*format == VideoCore::CaptureFormat::RGBA) {
+        const std::size_t size = frame->pixels.size();
+        res.set_content_provider(
+            size, [frame = std::move(frame)](std::size_t offset, std::size_t length,
+                                             httplib::DataSink& sink) {
+                sink.write(reinterpret_cast<const char*>(frame->pixels.data()) + offset, length);
+            });
+        return;
+    }
+
+    auto data = std::make_shared<const std::vector<u8>>(
+        VideoCore::EncodeFrame(*frame, *format, level));
+    if (data->empty()) {
+        res.status = 500;
+        res.set_content("failed to encode", "text/plain");
+        return;
+    }
+    const std::size_t size = data->size();
+    res.set_content_provider(size, [data = std::move(data)](std::size_t offset, std::size_t length,
+                                                            httplib::DataSink& sink) {
+        sink.write(reinterpret_cast<const char*>(data->data()) + offset, length);
+    });
+}
+
+} // Anonymous namespace
+
+nlohmann::json TimeSummaryToJson(const Core::TimeSummary& summary) {
+    return {
+        {"mean", summary.mean},
+        {"p50", summary.p50},
+        {"p90", summary.p90},
+        {"p95", summary.p95},
+        {"p99", summary.p99},
+        {"max", summary.max},
+    };
+}
+
 Server::Server(Core::System& system, const int port) {
     server = std::make_unique<httplib::Server>();
 
@@ -368,67 +443,123 @@ Server::Server(Core::System& system, const int port) {
             return;
         }
 
-        const Layout::FramebufferLayout& layout =
-            VideoCore::g_renderer->GetRenderWindow().GetFramebufferLayout();
-
+        Common::Trace::SetThreadName("RPC");
         Common::Event done;
-        std::vector<u8> data(layout.width * layout.height * 4);
-        if (VideoCore::RequestScreenshot(data.data(), [&] { done.Set(); }, layout)) {
+        std::shared_ptr<const VideoCore::CapturedFrame> frame;
+        VideoCore::g_frame_capture.RequestFrame(
+            [&](std::shared_ptr<const VideoCore::CapturedFrame> captured_frame) {
+                frame = std::move(captured_frame);
+                done.Set();
+            });
+        {
+            Common::Trace::Scope trace_scope("Wait for screenshot");
+            done.Wait();
+        }
+
+        if (frame == nullptr) {
+            res.status = 503;
+            res.set_content("emulation stopped", "text/plain");
+            return;
+        }
+        SendCapturedFrame(req, res, std::move(frame));
+    });
+
+    server->Get("/framestream", [&](const httplib::Request& req, httplib::Response& res) {
+        if (!system.IsPoweredOn()) {
             res.status = 503;
-            res.set_content("another screenshot is pending", "text/plain");
+            res.set_content("emulation not running", "text/plain");
             return;
         }
-        done.Wait();
 
-        const auto rotate = [](const std::vector<u8>& input,
-                               const Layout::FramebufferLayout& layout) {
-            std::vector<u8> output(input.size());
+        if (Settings::values.frame_stream_interval == 0) {
+            res.status = 503;
+            res.set_content("frame streaming disabled", "text/plain");
+            return;
+        }
 
-            for (std::size_t i = 0; i < layout.height; i++) {
-                for (std::size_t j = 0; j < layout.width; j++) {
-                    for (std::size_t k = 0; k < 4; k++) {
-                        output[i * (layout.width * 4) + j * 4 + k] =
-                            input[(layout.height - i - 1) * (layout.width * 4) + j * 4 + k];
-                    }
-                }
+        u64 after = 0;
+        try {
+            if (req.has_param("after")) {
+                after = std::stoull(req.get_param_value("after"));
             }
+        } catch (std::logic_error&) {
+            res.status = 400;
+            res.set_content("invalid after", "text/plain");
+            return;
+        }
 
-            return output;
-        };
+        auto frame = VideoCore::g_frame_capture.WaitForFrame(after, std::chrono::seconds(1));
+        if (frame == nullptr) {
+            res.status = 204;
+            return;
+        }
+        SendCapturedFrame(req, res, std::move(frame));
+    });
+
+    server->Get("/framestreaminterval", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(
+            nlohmann::json{
+                {"value", Settings::values.frame_stream_interval},
+            }
+                .dump(),
+            "application/json");
+    });
 
-        const auto convert_bgra_to_rgba = [](const std::vector<u8>& input,
-                                             const Layout::FramebufferLayout& layout) {
-            int offset = 0;
-            std::vector<u8> output(input.size());
+    server->Post("/framestreaminterval",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.frame_stream_interval = json["value"].get<u32>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
 
-            for (u32 y = 0; y < layout.height; ++y) {
-                for (u32 x = 0; x < layout.width; ++x) {
-                    output[offset] = input[offset + 2];
-                    output[offset + 1] = input[offset + 1];
-                    output[offset + 2] = input[offset];
-                    output[offset + 3] = input[offset + 3];
+    server->Get("/perfstats", [&](const httplib::Request& req, httplib::Response& res) {
+        if (!system.IsPoweredOn()) {
+            res.status = 503;
+            res.set_content("emulation not running", "text/plain");
+            return;
+        }
 
-                    offset += 4;
-                }
+        std::size_t frames = 300;
+        try {
+            if (req.has_param("frames")) {
+                frames = std::stoul(req.get_param_value("frames"));
             }
+        } catch (std::logic_error&) {
+            res.status = 400;
+            res.set_content("invalid frames", "text/plain");
+            return;
+        }
 
-            return output;
-        };
-
-        data = convert_bgra_to_rgba(rotate(data, layout), layout);
+        const std::vector<Core::FrameBreakdown> breakdowns =
+            system.perf_stats->GetFrameBreakdowns(frames);
+        std::vector<double> frame_times;
+        std::array<std::vector<double>, static_cast<std::size_t>(Core::Subsystem::Count)>
+            subsystem_times;
+        double total_period = 0.0;
+        for (const Core::FrameBreakdown& breakdown : breakdowns) {
+            frame_times.push_back(breakdown.frame_time);
+            for (std::size_t i = 0; i < subsystem_times.size(); ++i) {
+                subsystem_times[i].push_back(breakdown.subsystem_times[i]);
+            }
+            total_period += breakdown.frame_period;
+        }
 
-        std::vector<u8> out;
-        stbi_write_func* f = [](void* context, void* data, int size) {
-            std::vector<u8>* out = static_cast<std::vector<u8>*>(context);
-            out->resize(size);
-            std::memcpy(out->data(), data, size);
+        nlohmann::json json{
+            {"frames", breakdowns.size()},
+            {"fps", total_period > 0.0 ? breakdowns.size() * 1000.0 / total_period : 0.0},
+            {"frame_time", TimeSummaryToJson(Core::SummarizeTimes(std::move(frame_times)))},
         };
-        if (stbi_write_png_to_func(f, &out, layout.width, layout.height, 4, data.data(),
-                                   layout.width * 4) == 0) {
-            res.set_content("failed to encode", "text/plain");
-        } else {
-            res.set_content(reinterpret_cast<const char*>(out.data()), out.size(), "image/png");
+        nlohmann::json& subsystems = json["subsystems"] = nlohmann::json::object();
+        for (std::size_t i = 0; i < subsystem_times.size(); ++i) {
+            subsystems[Core::GetSubsystemName(static_cast<Core::Subsystem>(i))] =
+                TimeSummaryToJson(Core::SummarizeTimes(std::move(subsystem_times[i])));
         }
+        res.set_content(json.dump(), "application/json");
     });
 
     server->Get("/layout", [&](const httplib::Request& req, httplib::Response& res) {
@@ -706,6 +837,30 @@ Server::Server(Core::System& system, const int port) {
         }
     });
 
+    server->Get("/surfacecachememorybudget",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"value", Settings::values.surface_cache_memory_budget},
+                            {"used", VideoCore::g_surface_cache_memory_used.load()},
+                            {"evictions", VideoCore::g_surface_cache_evictions.load()},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/surfacecachememorybudget",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.surface_cache_memory_budget = json["value"].get<u32>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
     server->Get("/frameadvancing", [&](const httplib::Request& req, httplib::Response& res) {
         res.set_content(
             nlohmann::json{
@@ -959,10 +1114,109 @@ Server::Server(Core::System& system, const int port) {
         }
     });
 
+    server->Get("/softwarerenderermultithreading",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"enabled", Settings::values.enable_software_renderer_multithread},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/softwarerenderermultithreading",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.enable_software_renderer_multithread =
+                             json["enabled"].get<bool>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
+    server->Get("/softwarerendererproctexcache",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"enabled", Settings::values.enable_software_renderer_proctex_cache},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/softwarerendererproctexcache",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.enable_software_renderer_proctex_cache =
+                             json["enabled"].get<bool>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
+    server->Get("/gputhreadsyncdebug", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(
+            nlohmann::json{
+                {"enabled", Settings::values.gpu_thread_sync_debug},
+            }
+                .dump(),
+            "application/json");
+    });
+
+    server->Post("/gputhreadsyncdebug", [&](const httplib::Request& req, httplib::Response& res) {
+        try {
+            const nlohmann::json json = nlohmann::json::parse(req.body);
+            Settings::values.gpu_thread_sync_debug = json["enabled"].get<bool>();
+            res.status = 204;
+        } catch (nlohmann::json::exception& exception) {
+            res.status = 500;
+            res.set_content(exception.what(), "text/plain");
+        }
+    });
+
+    server->Get("/commandlistcache", [&](const httplib::Request& req, httplib::Response& res) {
+        const Pica::CommandProcessor::CommandListCacheStats stats =
+            Pica::CommandProcessor::GetCommandListCacheStats();
+        const u64 lookups = stats.hits + stats.misses;
+        res.set_content(
+            nlohmann::json{
+                {"enabled", Settings::values.use_command_list_cache},
+                {"verify", Settings::values.command_list_cache_verify},
+                {"hits", stats.hits},
+                {"misses", stats.misses},
+                {"mismatches", stats.mismatches},
+                {"hit_rate", lookups == 0 ? 0.0 : static_cast<double>(stats.hits) / lookups},
+            }
+                .dump(),
+            "application/json");
+    });
+
+    server->Post("/commandlistcache", [&](const httplib::Request& req, httplib::Response& res) {
+        try {
+            const nlohmann::json json = nlohmann::json::parse(req.body);
+            Settings::values.use_command_list_cache = json["enabled"].get<bool>();
+            Settings::values.command_list_cache_verify = json["verify"].get<bool>();
+            res.status = 204;
+        } catch (nlohmann::json::exception& exception) {
+            res.status = 500;
+            res.set_content(exception.what(), "text/plain");
+        }
+    });
+
     server->Get("/dumptextures", [&](const httplib::Request& req, httplib::Response& res) {
+        const OpenGL::TextureDumper::Stats stats = OpenGL::TextureDumper::GetInstance().GetStats();
         res.set_content(
             nlohmann::json{
                 {"enabled", Settings::values.dump_textures},
+                {"queued", stats.queued},
+                {"written", stats.written},
+                {"dropped", stats.dropped},
             }
                 .dump(),
             "application/json");
@@ -1020,6 +1274,93 @@ Server::Server(Core::System& system, const int port) {
                      }
                  });
 
+    server->Get("/customtexturesmemorybudget",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"value", Settings::values.custom_textures_memory_budget},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/customtexturesmemorybudget",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.custom_textures_memory_budget =
+                             json["value"].get<u32>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
+    server->Get("/buildcustomtexturepack",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"enabled", Settings::values.build_custom_texture_pack},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/buildcustomtexturepack",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.build_custom_texture_pack = json["enabled"].get<bool>();
+                         res.status = 202;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
+    server->Get("/fasttexturehash", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(
+            nlohmann::json{
+                {"enabled", Settings::values.fast_texture_hash},
+            }
+                .dump(),
+            "application/json");
+    });
+
+    server->Post("/fasttexturehash", [&](const httplib::Request& req, httplib::Response& res) {
+        try {
+            const nlohmann::json json = nlohmann::json::parse(req.body);
+            Settings::values.fast_texture_hash = json["enabled"].get<bool>();
+            res.status = 204;
+        } catch (nlohmann::json::exception& exception) {
+            res.status = 500;
+            res.set_content(exception.what(), "text/plain");
+        }
+    });
+
+    server->Get("/incrementaltexturehash",
+                [&](const httplib::Request& req, httplib::Response& res) {
+                    res.set_content(
+                        nlohmann::json{
+                            {"enabled", Settings::values.incremental_texture_hash},
+                        }
+                            .dump(),
+                        "application/json");
+                });
+
+    server->Post("/incrementaltexturehash",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.incremental_texture_hash = json["enabled"].get<bool>();
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
     server->Get("/usecpujit", [&](const httplib::Request& req, httplib::Response& res) {
         res.set_content(
             nlohmann::json{
@@ -1308,6 +1649,53 @@ Server::Server(Core::System& system, const int port) {
         }
     });
 
+    server->Get("/recordsubsystemtimes", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(
+            nlohmann::json{
+                {"enabled", Settings::values.record_subsystem_times},
+            }
+                .dump(),
+            "application/json");
+    });
+
+    server->Post("/recordsubsystemtimes",
+                 [&](const httplib::Request& req, httplib::Response& res) {
+                     try {
+                         const nlohmann::json json = nlohmann::json::parse(req.body);
+                         Settings::values.record_subsystem_times = json["enabled"].get<bool>();
+                         Core::SetSubsystemTimesEnabled(Settings::values.record_subsystem_times);
+                         res.status = 204;
+                     } catch (nlohmann::json::exception& exception) {
+                         res.status = 500;
+                         res.set_content(exception.what(), "text/plain");
+                     }
+                 });
+
+    server->Get("/recordtrace", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(
+            nlohmann::json{
+                {"enabled", Settings::values.record_trace},
+            }
+                .dump(),
+            "application/json");
+    });
+
+    server->Post("/recordtrace", [&](const httplib::Request& req, httplib::Response& res) {
+        try {
+            const nlohmann::json json = nlohmann::json::parse(req.body);
+            Settings::values.record_trace = json["enabled"].get<bool>();
+            Common::Trace::SetEnabled(Settings::values.record_trace);
+            res.status = 204;
+        } catch (nlohmann::json::exception& exception) {
+            res.status = 500;
+            res.set_content(exception.what(), "text/plain");
+        }
+    });
+
+    server->Get("/trace", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(Common::Trace::Dump(), "application/json");
+    });
+
     server->Get("/cameras", [&](const httplib::Request& req, httplib::Response& res) {
         res.set_content(
             nlohmann::json{
@@ -1941,7 +2329,10 @@ Server::Server(Core::System& system, const int port) {
         }
     });
 
-    request_handler_thread = std::thread([this, port] { server->listen("0.0.0.0", port); });
+    request_handler_thread = std::thread([this, port] {
+        Common::SetCurrentThreadName("RPC");
+        server->listen("0.0.0.0", port);
+    });
     LOG_INFO(RPC_Server, "RPC server running on port {}", port);
 }
 
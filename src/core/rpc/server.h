@@ -6,9 +6,11 @@
 
 #include <memory>
 #include <thread>
+#include <json.hpp>
 
 namespace Core {
 class System;
+struct TimeSummary;
 } // namespace Core
 
 namespace httplib {
@@ -27,4 +29,7 @@ private:
     std::thread request_handler_thread;
 };
 
+/// Returns the statistics as they're replied by /perfstats
+nlohmann::json TimeSummaryToJson(const Core::TimeSummary& summary);
+
 } // namespace RPC
@@ -4,6 +4,7 @@
 
 #include <utility>
 #include "audio_core/dsp_interface.h"
+#include "common/trace.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/shared_page.h"
@@ -11,6 +12,7 @@
 #include "core/hle/service/ir/ir_rst.h"
 #include "core/hle/service/ir/ir_user.h"
 #include "core/hle/service/mic_u.h"
+#include "core/perf_stats.h"
 #include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_manager.h"
@@ -24,7 +26,11 @@ void Apply() {
     GDBStub::SetServerPort(values.gdbstub_port);
     GDBStub::ToggleServer(values.use_gdbstub);
 
-    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
+    Common::Trace::SetEnabled(values.record_trace);
+    Core::SetSubsystemTimesEnabled(values.record_subsystem_times);
+
+    // The headless renderer has no OpenGL context
+    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer && !values.use_headless_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
     VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
@@ -81,11 +87,13 @@ void LogSettings() {
     LogSetting("init_clock", static_cast<int>(values.init_clock));
     LogSetting("init_time", values.init_time);
     LogSetting("use_hw_renderer", values.use_hw_renderer);
+    LogSetting("use_headless_renderer", values.use_headless_renderer);
     LogSetting("use_hw_shader", values.use_hw_shader);
     LogSetting("use_disk_shader_cache", values.use_disk_shader_cache);
     LogSetting("shaders_accurate_mul", values.shaders_accurate_mul);
     LogSetting("use_shader_jit", values.use_shader_jit);
     LogSetting("resolution_factor", values.resolution_factor);
+    LogSetting("surface_cache_memory_budget", values.surface_cache_memory_budget);
     LogSetting("use_frame_limit", values.use_frame_limit);
     LogSetting("frame_limit", values.frame_limit);
     LogSetting("texture_filter_factor", values.texture_filter_factor);
@@ -101,6 +109,15 @@ void LogSettings() {
     LogSetting("sharper_distant_objects", values.sharper_distant_objects);
     LogSetting("ignore_format_reinterpretation", values.ignore_format_reinterpretation);
     LogSetting("min_vertices_per_thread", values.min_vertices_per_thread);
+    LogSetting("enable_software_renderer_multithread",
+               values.enable_software_renderer_multithread);
+    LogSetting("enable_software_renderer_simd", values.enable_software_renderer_simd);
+    LogSetting("enable_software_renderer_proctex_cache",
+               values.enable_software_renderer_proctex_cache);
+    LogSetting("use_gpu_thread", values.use_gpu_thread);
+    LogSetting("gpu_thread_sync_debug", values.gpu_thread_sync_debug);
+    LogSetting("use_command_list_cache", values.use_command_list_cache);
+    LogSetting("command_list_cache_verify", values.command_list_cache_verify);
     LogSetting("layout_option", static_cast<int>(values.layout_option));
     LogSetting("swap_screen", values.swap_screen);
     LogSetting("upright_screen", values.upright_screen);
@@ -116,6 +133,11 @@ void LogSettings() {
     LogSetting("dump_textures", values.dump_textures);
     LogSetting("custom_textures", values.custom_textures);
     LogSetting("preload_textures", values.preload_textures);
+    LogSetting("custom_textures_memory_budget", values.custom_textures_memory_budget);
+    LogSetting("build_custom_texture_pack", values.build_custom_texture_pack);
+    LogSetting("fast_texture_hash", values.fast_texture_hash);
+    LogSetting("incremental_texture_hash", values.incremental_texture_hash);
+    LogSetting("frame_stream_interval", values.frame_stream_interval);
     LogSetting("enable_dsp_lle", values.enable_dsp_lle);
     LogSetting("enable_dsp_lle_multithread", values.enable_dsp_lle_multithread);
     LogSetting("sink_id", values.sink_id);
@@ -131,6 +153,8 @@ void LogSettings() {
     }
     LogSetting("log_filter", values.log_filter);
     LogSetting("record_frame_times", values.record_frame_times);
+    LogSetting("record_subsystem_times", values.record_subsystem_times);
+    LogSetting("record_trace", values.record_trace);
     LogSetting("use_gdbstub", values.use_gdbstub);
     LogSetting("gdbstub_port", values.gdbstub_port);
     for (const auto& module : values.lle_modules) {
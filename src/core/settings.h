@@ -178,11 +178,13 @@ struct Values {
 
     // Renderer
     bool use_hw_renderer = true;
+    bool use_headless_renderer = false;
     bool use_hw_shader = true;
     bool use_disk_shader_cache = true;
     bool shaders_accurate_mul = false;
     bool use_shader_jit = true;
     u16 resolution_factor = 1;
+    u32 surface_cache_memory_budget = 0;
     bool use_frame_limit = true;
     u16 frame_limit = 100;
     u16 texture_filter_factor = 1;
@@ -198,6 +200,13 @@ struct Values {
     bool sharper_distant_objects = false;
     bool ignore_format_reinterpretation = false;
     int min_vertices_per_thread = 10;
+    bool enable_software_renderer_multithread = true;
+    bool enable_software_renderer_simd = true;
+    bool enable_software_renderer_proctex_cache = false;
+    bool use_gpu_thread = false;
+    bool gpu_thread_sync_debug = false;
+    bool use_command_list_cache = false;
+    bool command_list_cache_verify = false;
 
     // Layout
     LayoutOption layout_option = LayoutOption::Default;
@@ -217,6 +226,11 @@ struct Values {
     bool dump_textures = false;
     bool custom_textures = false;
     bool preload_textures = false;
+    u32 custom_textures_memory_budget = 0;
+    bool build_custom_texture_pack = false;
+    bool fast_texture_hash = false;
+    bool incremental_texture_hash = false;
+    u32 frame_stream_interval = 0;
 
     // Audio
     bool enable_dsp_lle = false;
@@ -238,6 +252,8 @@ struct Values {
 
     // Debugging
     bool record_frame_times = false;
+    bool record_subsystem_times = false;
+    bool record_trace = false;
     bool use_gdbstub = false;
     u16 gdbstub_port = 24689;
     std::unordered_map<std::string, bool> lle_modules = {
@@ -0,0 +1,81 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <set>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/fast_hash.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+#include "tests/common/test_data.h"
+
+namespace {
+
+/// XXH3 reads long inputs in stripes of this many bytes
+constexpr std::size_t STRIPE_SIZE = 64;
+
+/// Generates the data of the xxHash sanity checks
+std::vector<u8> GenerateSanityData(std::size_t size) {
+    std::vector<u8> data(size);
+    u64 generator = 0x9E3779B1;
+    for (u8& byte : data) {
+        byte = static_cast<u8>(generator >> 56);
+        generator *= 0x9E3779B185EBCA87;
+    }
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ComputeFastHash64 computes XXH3", "[common]") {
+    // Computed with xxhash-rust, an independent implementation of XXH3, at the lengths where XXH3
+    // changes how it reads the data
+    constexpr std::pair<std::size_t, u64> reference_hashes[]{
+        {0, 0x2D06800538D394C2},     {1, 0xC44BDFF4074EECDB},    {3, 0x3F968B83E9A87DC3},
+        {16, 0x027B4CB04C597E4B},    {17, 0x0E1175449B89E26F},   {128, 0xE774EFC8B7526505},
+        {129, 0xFD683CD797A1F6F8},   {240, 0xC0D6647A0E620F7E},  {241, 0x281410FD53152172},
+        {1024, 0x95C63C696323768E},  {4096, 0x862B1EAAB93D2798}, {99991, 0x64CB27AD8CD09391},
+    };
+    const std::vector<u8> data = GenerateSanityData(100000);
+    for (const auto& [size, hash] : reference_hashes) {
+        INFO("size " << size);
+        REQUIRE(Common::ComputeFastHash64(data.data(), size) == hash);
+    }
+}
+
+TEST_CASE("ComputeFastHash64 depends on every byte and their order", "[common]") {
+    // Lengths around the stripe and block sizes
+    for (const std::size_t size : {1, 63, 64, 65, 1023, 1024, 1025, 4096, 70000}) {
+        std::vector<u8> data = TestData::GenerateData(size);
+        std::set<u64> hashes{Common::ComputeFastHash64(data.data(), size)};
+        for (std::size_t i = 0; i < size; i += 61) {
+            data[i] ^= 1;
+            INFO("size " << size << " byte " << i);
+            REQUIRE(hashes.insert(Common::ComputeFastHash64(data.data(), size)).second);
+            data[i] ^= 1;
+        }
+        if (size >= 2 * STRIPE_SIZE) {
+            // Swapped stripes
+            std::swap_ranges(data.begin(), data.begin() + STRIPE_SIZE, data.begin() + STRIPE_SIZE);
+            REQUIRE(hashes.insert(Common::ComputeFastHash64(data.data(), size)).second);
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("ComputeFastHash64 SIMD implementations match the generic one", "[common]") {
+    const std::vector<u8> data = TestData::GenerateData(70000);
+    // Every length up to the ones read in stripes
+    for (std::size_t size = 0; size < data.size(); size += size < 256 ? 1 : 997) {
+        INFO("size " << size);
+        const u64 hash = Common::FastHash::HashGeneric(data.data(), size);
+        REQUIRE(Common::FastHash::HashSSE2(data.data(), size) == hash);
+        if (Common::GetCPUCaps().avx2) {
+            REQUIRE(Common::FastHash::HashAVX2(data.data(), size) == hash);
+        }
+    }
+}
+#endif
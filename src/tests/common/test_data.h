@@ -0,0 +1,24 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "common/common_types.h"
+
+namespace TestData {
+
+/// Generates random bytes, the same ones for every call with the same size
+inline std::vector<u8> GenerateData(std::size_t size) {
+    std::mt19937 rng(1234);
+    std::vector<u8> data(size);
+    for (u8& byte : data) {
+        byte = static_cast<u8>(rng());
+    }
+    return data;
+}
+
+} // namespace TestData
@@ -0,0 +1,81 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <thread>
+#include <catch2/catch.hpp>
+#include <json.hpp>
+#include "common/trace.h"
+
+namespace {
+
+/// Returns the events of the thread with the name in the dump
+std::vector<nlohmann::json> GetThreadEvents(const nlohmann::json& trace, const std::string& name) {
+    int tid = -1;
+    for (const nlohmann::json& event : trace["traceEvents"]) {
+        if (event["ph"] == "M" && event["args"]["name"] == name) {
+            tid = event["tid"].get<int>();
+        }
+    }
+
+    std::vector<nlohmann::json> events;
+    for (const nlohmann::json& event : trace["traceEvents"]) {
+        if (event["tid"] == tid && event["ph"] != "M") {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Trace dumps the events of each thread", "[common]") {
+    Common::Trace::SetEnabled(true);
+    std::thread([] {
+        Common::Trace::SetThreadName("Trace test");
+        // Ends without a beginning are dropped
+        Common::Trace::End();
+        {
+            Common::Trace::Scope outer("Outer");
+            Common::Trace::Scope inner("Inner \"quoted\"");
+            Common::Trace::Counter("Count", 42);
+        }
+        Common::Trace::SetEnabled(false);
+        Common::Trace::Begin("Disabled");
+    }).join();
+
+    const nlohmann::json trace = nlohmann::json::parse(Common::Trace::Dump());
+    const std::vector<nlohmann::json> events = GetThreadEvents(trace, "Trace test");
+    REQUIRE(events.size() == 5);
+    REQUIRE(events[0]["ph"] == "B");
+    REQUIRE(events[0]["name"] == "Outer");
+    REQUIRE(events[1]["name"] == "Inner \"quoted\"");
+    REQUIRE(events[2]["ph"] == "C");
+    REQUIRE(events[2]["args"]["Count"] == 42);
+    REQUIRE(events[3]["ph"] == "E");
+    REQUIRE(events[4]["ph"] == "E");
+    for (std::size_t i = 1; i < events.size(); ++i) {
+        REQUIRE(events[i]["ts"].get<double>() >= events[i - 1]["ts"].get<double>());
+    }
+}
+
+TEST_CASE("Trace keeps the newest events of a thread", "[common]") {
+    Common::Trace::SetEnabled(true);
+    std::thread([] {
+        Common::Trace::SetThreadName("Trace ring test");
+        Common::Trace::Begin("Overwritten");
+        for (std::size_t i = 0; i < Common::Trace::EVENTS_PER_THREAD; ++i) {
+            Common::Trace::Counter("Index", static_cast<s64>(i));
+        }
+        Common::Trace::End();
+    }).join();
+    Common::Trace::SetEnabled(false);
+
+    const nlohmann::json trace = nlohmann::json::parse(Common::Trace::Dump());
+    const std::vector<nlohmann::json> events = GetThreadEvents(trace, "Trace ring test");
+    // The end of the overwritten slice is dropped too
+    REQUIRE(events.size() == Common::Trace::EVENTS_PER_THREAD - 1);
+    REQUIRE(events.front()["args"]["Index"] == 1);
+    REQUIRE(events.back()["args"]["Index"] == Common::Trace::EVENTS_PER_THREAD - 1);
+}
@@ -0,0 +1,60 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/stb_image_write.h"
+#include "core/custom_tex_cache.h"
+
+TEST_CASE("Texture packs load the textures they were built from", "[core]") {
+    const std::string test_path = *FileUtil::GetCurrentDir() + "/custom_tex_cache_test/";
+    const std::string load_path = test_path + "textures/";
+    const std::string pack_path = test_path + "textures.pack";
+    REQUIRE(FileUtil::CreateFullPath(load_path));
+
+    // More textures than a batch of the thread pool, in sizes that aren't square
+    constexpr std::array<std::array<u32, 2>, 3> sizes{{{4, 4}, {8, 2}, {1, 16}}};
+    std::vector<u64> hashes;
+    std::mt19937 rng(1234);
+    for (u64 i = 0; i < 100; ++i) {
+        const auto [width, height] = sizes[i % sizes.size()];
+        std::vector<u8> pixels(width * height * 4);
+        for (u8& byte : pixels) {
+            byte = static_cast<u8>(rng());
+        }
+        const u64 hash = 0x0123456789ABCDEF ^ (i << 32);
+        const std::string path =
+            fmt::format("{}tex1_{}x{}_{:016X}_13.png", load_path, width, height, hash);
+        REQUIRE(stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4) != 0);
+        hashes.push_back(hash);
+    }
+
+    Core::CustomTexCache files_cache;
+    files_cache.FindCustomTextures(load_path, pack_path);
+    files_cache.PreloadTextures();
+    files_cache.BuildTexturePack();
+
+    // The texture pack is used without the texture files
+    REQUIRE(FileUtil::DeleteDirRecursively(load_path));
+    Core::CustomTexCache pack_cache;
+    pack_cache.FindCustomTextures(load_path, pack_path);
+    pack_cache.PreloadTextures();
+
+    for (const u64 hash : hashes) {
+        REQUIRE(pack_cache.CustomTextureExists(hash));
+        const auto from_files = files_cache.LookupTexture(hash);
+        const auto from_pack = pack_cache.LookupTexture(hash);
+        REQUIRE(from_files != nullptr);
+        REQUIRE(from_pack != nullptr);
+        REQUIRE(from_pack->width == from_files->width);
+        REQUIRE(from_pack->height == from_files->height);
+        REQUIRE(from_pack->tex == from_files->tex);
+    }
+
+    REQUIRE(FileUtil::DeleteDirRecursively(test_path));
+}
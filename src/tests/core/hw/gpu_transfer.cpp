@@ -0,0 +1,148 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hw/gpu_transfer.h"
+#include "tests/common/test_data.h"
+
+namespace {
+
+using GPU::Regs;
+
+constexpr Regs::PixelFormat FORMATS[]{
+    Regs::PixelFormat::RGBA8,  Regs::PixelFormat::RGB8,  Regs::PixelFormat::RGB565,
+    Regs::PixelFormat::RGB5A1, Regs::PixelFormat::RGBA4,
+};
+
+Regs::DisplayTransferConfig MakeConfig(Regs::PixelFormat input_format,
+                                       Regs::PixelFormat output_format, u32 width, u32 height) {
+    Regs::DisplayTransferConfig config{};
+    config.input_width.Assign(width);
+    config.input_height.Assign(height);
+    config.output_width.Assign(width);
+    config.output_height.Assign(height);
+    config.input_format.Assign(input_format);
+    config.output_format.Assign(output_format);
+    return config;
+}
+
+/// Checks the row converters against the per pixel converter
+void CheckDisplayTransfer(const Regs::DisplayTransferConfig& config) {
+    const std::vector<u8> source = TestData::GenerateData(config.input_width * config.input_height *
+                                                Regs::BytesPerPixel(config.input_format));
+    const std::size_t output_size =
+        config.output_width * config.output_height * Regs::BytesPerPixel(config.output_format);
+    std::vector<u8> expected(output_size);
+    std::vector<u8> result(output_size);
+
+    GPU::DisplayTransferPixels(source.data(), expected.data(), config);
+    REQUIRE(GPU::DisplayTransferRows(source.data(), result.data(), config));
+    REQUIRE(result == expected);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DisplayTransferRows matches DisplayTransferPixels", "[core][hw][gpu]") {
+    for (const auto input_format : FORMATS) {
+        for (const auto output_format : FORMATS) {
+            for (u32 layout = 0; layout < 4; ++layout) {
+                for (u32 flip = 0; flip < 2; ++flip) {
+                    auto config = MakeConfig(input_format, output_format, 64, 48);
+                    config.input_linear.Assign(layout & 1);
+                    config.dont_swizzle.Assign(layout >> 1);
+                    config.flip_vertically.Assign(flip);
+                    INFO("formats " << static_cast<u32>(input_format) << " to "
+                                    << static_cast<u32>(output_format) << " flags "
+                                    << config.flags);
+                    CheckDisplayTransfer(config);
+
+                    // Scaling is only implemented for tiled input
+                    if (!config.input_linear) {
+                        config.scaling.Assign(Regs::DisplayTransferConfig::ScaleX);
+                        CheckDisplayTransfer(config);
+                        config.scaling.Assign(Regs::DisplayTransferConfig::ScaleXY);
+                        CheckDisplayTransfer(config);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("FillMemory fills whole values", "[core][hw][gpu]") {
+    Regs::MemoryFillConfig config{};
+    config.value_32bit = 0x12345678;
+    std::vector<u8> memory(104, 0xAA);
+
+    config.fill_24bit.Assign(1);
+    GPU::FillMemory(memory.data(), memory.data() + 100, config);
+    for (std::size_t i = 0; i < 102; ++i) {
+        REQUIRE(memory[i] == static_cast<u8>(0x345678 >> (8 * (i % 3))));
+    }
+    REQUIRE(memory[102] == 0xAA);
+
+    config.fill_24bit.Assign(0);
+    config.fill_32bit.Assign(1);
+    std::fill(memory.begin(), memory.end(), 0xAA);
+    GPU::FillMemory(memory.data(), memory.data() + 98, config);
+    for (std::size_t i = 0; i < 96; ++i) {
+        REQUIRE(memory[i] == static_cast<u8>(0x12345678 >> (8 * (i % 4))));
+    }
+    REQUIRE(memory[96] == 0xAA);
+
+    config.fill_32bit.Assign(0);
+    std::fill(memory.begin(), memory.end(), 0xAA);
+    GPU::FillMemory(memory.data(), memory.data() + 99, config);
+    for (std::size_t i = 0; i < 100; ++i) {
+        REQUIRE(memory[i] == static_cast<u8>(0x5678 >> (8 * (i % 2))));
+    }
+    REQUIRE(memory[100] == 0xAA);
+}
+
+TEST_CASE("DisplayTransfer throughput", "[.benchmark][core][hw][gpu]") {
+    constexpr u32 WIDTH = 240;
+    constexpr u32 HEIGHT = 400;
+    constexpr int NUM_ITERATIONS = 20;
+
+    for (const auto input_format : FORMATS) {
+        for (const auto output_format : FORMATS) {
+            // Tiled to linear, like copying a rendered frame to a framebuffer
+            const auto config = MakeConfig(input_format, output_format, WIDTH, HEIGHT);
+            const std::vector<u8> source =
+                TestData::GenerateData(WIDTH * HEIGHT * Regs::BytesPerPixel(input_format));
+            std::vector<u8> dest(WIDTH * HEIGHT * Regs::BytesPerPixel(output_format));
+
+            const auto Run = [&](auto transfer) {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < NUM_ITERATIONS; ++i) {
+                    transfer(source.data(), dest.data(), config);
+                }
+                const std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now() - start;
+                return WIDTH * HEIGHT * NUM_ITERATIONS / elapsed.count() / 1000000;
+            };
+
+            const double pixels = Run(GPU::DisplayTransferPixels);
+            const double rows = Run(GPU::DisplayTransferRows);
+            WARN("formats " << static_cast<u32>(input_format) << " to "
+                            << static_cast<u32>(output_format) << ": " << pixels
+                            << " Mpixels/s pixel by pixel, " << rows
+                            << " Mpixels/s a row at a time");
+        }
+    }
+
+    Regs::MemoryFillConfig config{};
+    config.fill_24bit.Assign(1);
+    std::vector<u8> memory(WIDTH * HEIGHT * 3);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_ITERATIONS; ++i) {
+        GPU::FillMemory(memory.data(), memory.data() + memory.size(), config);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    WARN("24 bit fill: " << memory.size() * NUM_ITERATIONS / elapsed.count() / (1024 * 1024)
+                         << " MB/s");
+}
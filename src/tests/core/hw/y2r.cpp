@@ -0,0 +1,179 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hw/y2r.h"
+#include "tests/common/test_data.h"
+
+namespace {
+
+using namespace Service::Y2R;
+
+constexpr u32 WIDTH = 64;
+
+bool Is16Bit(InputFormat format) {
+    return format == InputFormat::YUV422_Indiv16 || format == InputFormat::YUV420_Indiv16;
+}
+
+bool Is420(InputFormat format) {
+    return format == InputFormat::YUV420_Indiv8 || format == InputFormat::YUV420_Indiv16;
+}
+
+u32 BytesPerPixel(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+/// Planes of a linear image, with one transfer per line
+struct Image {
+    Image(InputFormat input_format, OutputFormat output_format, u32 width, u32 lines) {
+        const u32 N = Is16Bit(input_format) ? 2 : 1;
+        const u32 chroma_lines = Is420(input_format) ? (lines + 1) / 2 : lines;
+        if (input_format == InputFormat::YUYV422_Interleaved) {
+            Y = TestData::GenerateData(width * lines * 2);
+        } else {
+            Y = TestData::GenerateData(width * lines * N);
+            U = TestData::GenerateData(width / 2 * chroma_lines * N);
+            V = TestData::GenerateData(width / 2 * chroma_lines * N);
+            std::reverse(V.begin(), V.end());
+        }
+        dst.resize(width * lines * BytesPerPixel(output_format));
+
+        ConversionConfiguration& config = conversion.config;
+        config.input_format = input_format;
+        config.output_format = output_format;
+        config.rotation = Rotation::None;
+        config.block_alignment = BlockAlignment::Linear;
+        config.input_line_width = static_cast<u16>(width);
+        config.input_lines = static_cast<u16>(lines);
+        config.alpha = 0xA5;
+        const bool is_yuyv = input_format == InputFormat::YUYV422_Interleaved;
+        config.src_Y.transfer_unit = width * (is_yuyv ? 2 : N);
+        config.src_YUYV.transfer_unit = config.src_Y.transfer_unit;
+        config.src_U.transfer_unit = width / 2 * N;
+        config.src_V.transfer_unit = width / 2 * N;
+        config.dst.transfer_unit = width * BytesPerPixel(output_format);
+
+        for (u32 y = 0; y < lines; y += 8) {
+            HW::Y2R::StripBuffers strip;
+            strip.src_Y = &Y[y * config.src_Y.transfer_unit];
+            if (!is_yuyv) {
+                const u32 chroma_y = Is420(input_format) ? y / 2 : y;
+                strip.src_U = &U[chroma_y * config.src_U.transfer_unit];
+                strip.src_V = &V[chroma_y * config.src_V.transfer_unit];
+            }
+            strip.dst = &dst[y * config.dst.transfer_unit];
+            conversion.strips.push_back(strip);
+        }
+    }
+
+    std::vector<u8> Y, U, V, dst;
+    HW::Y2R::Conversion conversion;
+};
+
+/// The hardware's calculation, one pixel at a time
+std::array<u8, 3> ReferencePixel(const Image& image, u32 x, u32 y) {
+    const ConversionConfiguration& config = image.conversion.config;
+    const u32 width = config.input_line_width;
+    const u32 N = Is16Bit(config.input_format) ? 2 : 1;
+    s32 Y, U, V;
+    if (config.input_format == InputFormat::YUYV422_Interleaved) {
+        Y = image.Y[(y * width + x) * 2];
+        U = image.Y[(y * width + x / 2 * 2) * 2 + 1];
+        V = image.Y[(y * width + x / 2 * 2) * 2 + 3];
+    } else {
+        const u32 chroma_y = Is420(config.input_format) ? y / 2 : y;
+        Y = image.Y[(y * width + x) * N];
+        U = image.U[(chroma_y * width / 2 + x / 2) * N];
+        V = image.V[(chroma_y * width / 2 + x / 2) * N];
+    }
+
+    const CoefficientSet& c = config.coefficients;
+    const s32 cY = c[0] * Y;
+    const s32 rgb[3]{cY + c[1] * V, cY - c[2] * V - c[3] * U, cY + c[4] * U};
+    std::array<u8, 3> result;
+    for (int i = 0; i < 3; ++i) {
+        result[i] = static_cast<u8>(std::clamp(((rgb[i] >> 3) + c[5 + i] + 0x18) >> 5, 0, 0xFF));
+    }
+    return result;
+}
+
+void CheckConversion(InputFormat input_format, u32 lines, const CoefficientSet& coefficients) {
+    Image image(input_format, OutputFormat::RGBA8, WIDTH, lines);
+    image.conversion.config.coefficients = coefficients;
+    HW::Y2R::PerformConversion(image.conversion);
+
+    for (u32 y = 0; y < lines; ++y) {
+        for (u32 x = 0; x < WIDTH; ++x) {
+            const std::array<u8, 3> rgb = ReferencePixel(image, x, y);
+            const u8* pixel = &image.dst[(y * WIDTH + x) * 4];
+            REQUIRE(pixel[3] == rgb[0]);
+            REQUIRE(pixel[2] == rgb[1]);
+            REQUIRE(pixel[1] == rgb[2]);
+            REQUIRE(pixel[0] == 0xA5);
+        }
+    }
+}
+
+constexpr InputFormat INPUT_FORMATS[]{
+    InputFormat::YUV422_Indiv8,  InputFormat::YUV420_Indiv8,       InputFormat::YUV422_Indiv16,
+    InputFormat::YUV420_Indiv16, InputFormat::YUYV422_Interleaved,
+};
+
+} // Anonymous namespace
+
+TEST_CASE("Y2R conversion matches the per pixel calculation", "[core][hw][y2r]") {
+    // ITU_Rec601, ITU_Rec709_Scaling and the extremes of the coefficient range
+    const CoefficientSet coefficient_sets[]{
+        {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}},
+        {{0x12A, 0x1CA, 0x88, 0x36, 0x21C, -0x1F04, 0x99C, -0x2421}},
+        {{-0x8000, 0x7FFF, -0x8000, 0x7FFF, -0x8000, 0x7FFF, -0x8000, 0x7FFF}},
+    };
+    for (const InputFormat input_format : INPUT_FORMATS) {
+        for (const CoefficientSet& coefficients : coefficient_sets) {
+            // The second size ends with a partial strip
+            CheckConversion(input_format, 24, coefficients);
+            CheckConversion(input_format, 20, coefficients);
+        }
+    }
+}
+
+TEST_CASE("Y2R conversion throughput", "[.benchmark][core][hw][y2r]") {
+    constexpr int NUM_ITERATIONS = 50;
+    const auto Run = [](InputFormat input_format, OutputFormat output_format) {
+        Image image(input_format, output_format, 400, 240);
+        image.conversion.config.coefficients = {
+            {0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            HW::Y2R::PerformConversion(image.conversion);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return 400 * 240 * NUM_ITERATIONS / elapsed.count() / 1000000;
+    };
+
+    const char* input_names[]{"YUV422_Indiv8", "YUV420_Indiv8", "YUV422_Indiv16",
+                              "YUV420_Indiv16", "YUYV422_Interleaved"};
+    for (int i = 0; i < 5; ++i) {
+        WARN(input_names[i] << " to RGBA8: " << Run(INPUT_FORMATS[i], OutputFormat::RGBA8)
+                            << " Mpixels/s");
+    }
+    const OutputFormat output_formats[]{OutputFormat::RGB8, OutputFormat::RGB5A1,
+                                        OutputFormat::RGB565};
+    const char* output_names[]{"RGB8", "RGB5A1", "RGB565"};
+    for (int i = 0; i < 3; ++i) {
+        WARN("YUV420_Indiv8 to " << output_names[i] << ": "
+                                 << Run(InputFormat::YUV420_Indiv8, output_formats[i])
+                                 << " Mpixels/s");
+    }
+}
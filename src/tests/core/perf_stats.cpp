@@ -0,0 +1,56 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/perf_stats.h"
+
+TEST_CASE("SubsystemTimer doesn't count nested timers twice", "[core]") {
+    using namespace std::chrono_literals;
+
+    Core::SetSubsystemTimesEnabled(true);
+    Core::ResetSubsystemTimes();
+    {
+        Core::SubsystemTimer cpu_timer(Core::Subsystem::CPU);
+        Core::SubsystemTimer hle_timer(Core::Subsystem::HLE);
+        {
+            Core::SubsystemTimer audio_timer(Core::Subsystem::Audio);
+            std::this_thread::sleep_for(20ms);
+        }
+    }
+
+    const Core::SubsystemTimes times = Core::GetSubsystemTimes();
+    REQUIRE(times[static_cast<std::size_t>(Core::Subsystem::Audio)] >= 20ms);
+    REQUIRE(times[static_cast<std::size_t>(Core::Subsystem::CPU)] < 10ms);
+    REQUIRE(times[static_cast<std::size_t>(Core::Subsystem::HLE)] < 10ms);
+    REQUIRE(times[static_cast<std::size_t>(Core::Subsystem::PICA)] == 0ns);
+
+    Core::ResetSubsystemTimes();
+    REQUIRE(Core::GetSubsystemTimes()[static_cast<std::size_t>(Core::Subsystem::Audio)] == 0ns);
+
+    Core::SetSubsystemTimesEnabled(false);
+    {
+        Core::SubsystemTimer audio_timer(Core::Subsystem::Audio);
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(Core::GetSubsystemTimes()[static_cast<std::size_t>(Core::Subsystem::Audio)] == 0ns);
+}
+
+TEST_CASE("SummarizeTimes uses nearest rank percentiles", "[core]") {
+    std::vector<double> times;
+    for (int i = 100; i >= 1; --i) {
+        times.push_back(i);
+    }
+
+    const Core::TimeSummary summary = Core::SummarizeTimes(times);
+    REQUIRE(summary.mean == 50.5);
+    REQUIRE(summary.p50 == 50.0);
+    REQUIRE(summary.p90 == 90.0);
+    REQUIRE(summary.p99 == 99.0);
+    REQUIRE(summary.max == 100.0);
+
+    REQUIRE(Core::SummarizeTimes({}).max == 0.0);
+}
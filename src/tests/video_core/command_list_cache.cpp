@@ -0,0 +1,100 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/command_list_cache.h"
+#include "video_core/regs.h"
+
+namespace {
+
+using Pica::CommandListCache;
+using Pica::CommandListWrite;
+
+constexpr u32 DEPTH_SCALE = PICA_REG_INDEX(rasterizer.viewport_depth_range);
+constexpr u32 DEPTH_OFFSET = PICA_REG_INDEX(rasterizer.viewport_depth_near_plane);
+constexpr u32 BOOL_UNIFORMS = PICA_REG_INDEX(vs.bool_uniforms);
+constexpr u32 JUMP = PICA_REG_INDEX(pipeline.command_buffer.trigger[0]);
+
+/// Appends a command, padded to 8 bytes like the commands games submit
+void AddCommand(std::vector<u32>& list, u32 id, u32 mask, std::vector<u32> values,
+                bool group = false) {
+    list.push_back(values[0]);
+    list.push_back(id | (mask << 16) | (static_cast<u32>(values.size() - 1) << 20) |
+                   (group ? 1u << 31 : 0));
+    list.insert(list.end(), values.begin() + 1, values.end());
+    if (list.size() % 2 != 0) {
+        list.push_back(0);
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CommandListCache merges writes without side effects", "[video_core]") {
+    std::vector<u32> list;
+    AddCommand(list, DEPTH_SCALE, 0xF, {0x11111111});
+    AddCommand(list, DEPTH_OFFSET, 0xF, {0x33333333, 0x44444444}, true);
+    AddCommand(list, DEPTH_SCALE, 0x2, {0x00002200});
+    AddCommand(list, BOOL_UNIFORMS, 0xF, {1});
+    AddCommand(list, DEPTH_SCALE, 0x1, {0x55});
+
+    std::vector<CommandListWrite> writes;
+    REQUIRE(CommandListCache::Decode(list.data(), list.size(), false, writes));
+    REQUIRE(writes.size() == 6);
+    REQUIRE(writes[2] == CommandListWrite{DEPTH_OFFSET + 1, 0xF, false, 0x44444444});
+
+    REQUIRE(CommandListCache::Decode(list.data(), list.size(), true, writes));
+    const std::vector<CommandListWrite> merged{
+        {DEPTH_SCALE, 0xF, false, 0x11112211},
+        {DEPTH_OFFSET, 0xF, false, 0x33333333},
+        {DEPTH_OFFSET + 1, 0xF, false, 0x44444444},
+        {BOOL_UNIFORMS, 0xF, true, 1},
+        {DEPTH_SCALE, 0x1, false, 0x55},
+    };
+    REQUIRE(writes == merged);
+}
+
+TEST_CASE("CommandListCache only replays lists the command processor stays within",
+          "[video_core]") {
+    std::vector<u32> list;
+    AddCommand(list, DEPTH_SCALE, 0xF, {1});
+    AddCommand(list, JUMP, 0xF, {1});
+    std::vector<CommandListWrite> writes;
+    REQUIRE(CommandListCache::Decode(list.data(), list.size(), true, writes));
+    REQUIRE(writes.back().id == JUMP);
+
+    // The command processor would keep reading from the list jumped to
+    std::vector<u32> jump_in_command;
+    AddCommand(jump_in_command, JUMP, 0xF, {1, 1});
+    REQUIRE(!CommandListCache::Decode(jump_in_command.data(), jump_in_command.size(), true,
+                                      writes));
+
+    // Extra data past the end of the list
+    REQUIRE(!CommandListCache::Decode(list.data(), 1, true, writes));
+    std::vector<u32> truncated;
+    AddCommand(truncated, DEPTH_OFFSET, 0xF, {1, 2, 3}, true);
+    REQUIRE(!CommandListCache::Decode(truncated.data(), 3, true, writes));
+}
+
+TEST_CASE("CommandListCache looks up lists by their contents", "[video_core]") {
+    CommandListCache cache;
+    std::vector<u32> list;
+    AddCommand(list, DEPTH_SCALE, 0xF, {1});
+    AddCommand(list, BOOL_UNIFORMS, 0xF, {2});
+
+    REQUIRE(cache.Get(list.data(), list.size()).replayable);
+    REQUIRE(cache.Get(list.data(), list.size()).writes.size() == 2);
+    REQUIRE(cache.GetHits() == 1);
+    REQUIRE(cache.GetMisses() == 1);
+
+    list[0] = 3;
+    REQUIRE(cache.Get(list.data(), list.size()).writes[0].value == 3);
+    REQUIRE(cache.GetMisses() == 2);
+
+    // A mismatching list is decoded again
+    cache.ReportMismatch(cache.Get(list.data(), list.size()));
+    REQUIRE(cache.GetMismatches() == 1);
+    cache.Get(list.data(), list.size());
+    REQUIRE(cache.GetMisses() == 3);
+}
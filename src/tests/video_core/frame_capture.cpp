@@ -0,0 +1,149 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/stb_image.h"
+#include "video_core/frame_capture.h"
+
+namespace {
+
+/// BGRA8 pixels from the bottom row, like the renderer reads them back
+std::vector<u8> GenerateScreens(u32 width, u32 height) {
+    std::mt19937 rng(1234);
+    std::vector<u8> bgra(width * height * 4);
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            u8* pixel = &bgra[(y * width + x) * 4];
+            // Flat areas with noise, like a game screen
+            const u8 base = static_cast<u8>((x / 16 + y / 16) * 20);
+            pixel[0] = base;
+            pixel[1] = static_cast<u8>(base + (rng() % 4 == 0 ? rng() % 8 : 0));
+            pixel[2] = static_cast<u8>(x);
+            pixel[3] = 255;
+        }
+    }
+    return bgra;
+}
+
+VideoCore::CapturedFrame MakeFrame(u32 width, u32 height) {
+    VideoCore::CapturedFrame frame{1, width, height, std::vector<u8>(width * height * 4)};
+    VideoCore::FlipAndSwizzleBGRA(GenerateScreens(width, height).data(), frame.pixels.data(),
+                                  width, height);
+    return frame;
+}
+
+std::vector<u8> DecodeQOI(const std::vector<u8>& data, u32 width, u32 height) {
+    std::vector<u8> pixels;
+    std::array<std::array<u8, 4>, 64> index{};
+    std::array<u8, 4> pixel{0, 0, 0, 255};
+    std::size_t position = 14;
+    while (pixels.size() < width * height * 4) {
+        const u8 op = data[position++];
+        int run = 1;
+        if (op == 0xFE) {
+            std::memcpy(pixel.data(), &data[position], 3);
+            position += 3;
+        } else if (op == 0xFF) {
+            std::memcpy(pixel.data(), &data[position], 4);
+            position += 4;
+        } else if ((op & 0xC0) == 0x00) {
+            pixel = index[op];
+        } else if ((op & 0xC0) == 0x40) {
+            pixel[0] += ((op >> 4) & 3) - 2;
+            pixel[1] += ((op >> 2) & 3) - 2;
+            pixel[2] += (op & 3) - 2;
+        } else if ((op & 0xC0) == 0x80) {
+            const int dg = (op & 0x3F) - 32;
+            const u8 next = data[position++];
+            pixel[0] += dg + ((next >> 4) & 0xF) - 8;
+            pixel[1] += dg;
+            pixel[2] += dg + (next & 0xF) - 8;
+        } else {
+            run = (op & 0x3F) + 1;
+        }
+        index[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64] = pixel;
+        for (int i = 0; i < run; ++i) {
+            pixels.insert(pixels.end(), pixel.begin(), pixel.end());
+        }
+    }
+    return pixels;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("FlipAndSwizzleBGRA flips rows and swaps red and blue", "[video_core]") {
+    // A width that isn't a multiple of the vectorized pixels
+    constexpr u32 WIDTH = 13;
+    constexpr u32 HEIGHT = 5;
+    const std::vector<u8> bgra = GenerateScreens(WIDTH, HEIGHT);
+    std::vector<u8> rgba(bgra.size());
+    VideoCore::FlipAndSwizzleBGRA(bgra.data(), rgba.data(), WIDTH, HEIGHT);
+    for (u32 y = 0; y < HEIGHT; ++y) {
+        for (u32 x = 0; x < WIDTH; ++x) {
+            const u8* in = &bgra[((HEIGHT - y - 1) * WIDTH + x) * 4];
+            const u8* out = &rgba[(y * WIDTH + x) * 4];
+            INFO("x " << x << " y " << y);
+            REQUIRE(out[0] == in[2]);
+            REQUIRE(out[1] == in[1]);
+            REQUIRE(out[2] == in[0]);
+            REQUIRE(out[3] == in[3]);
+        }
+    }
+}
+
+TEST_CASE("EncodeFrame is lossless", "[video_core]") {
+    const VideoCore::CapturedFrame frame = MakeFrame(400, 480);
+
+    REQUIRE(VideoCore::EncodeFrame(frame, VideoCore::CaptureFormat::RGBA) == frame.pixels);
+
+    const std::vector<u8> png = VideoCore::EncodeFrame(frame, VideoCore::CaptureFormat::PNG, 5);
+    int width, height, channels;
+    u8* decoded = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width,
+                                        &height, &channels, 4);
+    REQUIRE(decoded != nullptr);
+    REQUIRE(width == 400);
+    REQUIRE(height == 480);
+    REQUIRE(std::memcmp(decoded, frame.pixels.data(), frame.pixels.size()) == 0);
+    stbi_image_free(decoded);
+
+    const std::vector<u8> qoi = VideoCore::EncodeFrame(frame, VideoCore::CaptureFormat::QOI);
+    REQUIRE(std::memcmp(qoi.data(), "qoif", 4) == 0);
+    REQUIRE(DecodeQOI(qoi, 400, 480) == frame.pixels);
+}
+
+TEST_CASE("FrameCapture serves requests and keeps the newest frames", "[video_core]") {
+    VideoCore::FrameCapture capture;
+    const std::vector<u8> screens = GenerateScreens(8, 8);
+
+    REQUIRE_FALSE(capture.ShouldCapture(0));
+    std::shared_ptr<const VideoCore::CapturedFrame> requested;
+    capture.RequestFrame([&](auto frame) { requested = std::move(frame); });
+    REQUIRE(capture.ShouldCapture(1));
+
+    // Frames captured before the request don't serve it
+    capture.PushFrame(0, screens.data(), 8, 8);
+    REQUIRE(requested == nullptr);
+    capture.PushFrame(1, screens.data(), 8, 8);
+    REQUIRE(requested != nullptr);
+    REQUIRE(requested->number == 1);
+    REQUIRE_FALSE(capture.ShouldCapture(2));
+
+    for (u64 frame = 2; frame < 10; ++frame) {
+        capture.PushFrame(frame, screens.data(), 8, 8);
+    }
+    // The frame held by the reader was not reused
+    REQUIRE(requested->number == 1);
+    REQUIRE(capture.WaitForFrame(5, std::chrono::milliseconds(0))->number == 9);
+    REQUIRE(capture.WaitForFrame(9, std::chrono::milliseconds(0)) == nullptr);
+
+    bool dropped = false;
+    capture.RequestFrame([&](auto frame) { dropped = frame == nullptr; });
+    capture.Reset();
+    REQUIRE(dropped);
+    REQUIRE(capture.WaitForFrame(0, std::chrono::milliseconds(0)) == nullptr);
+}
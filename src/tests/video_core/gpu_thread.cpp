@@ -0,0 +1,62 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hle/service/gsp/gsp_gpu.h"
+#include "video_core/gpu_thread.h"
+
+TEST_CASE("GPUThread runs commands in order", "[video_core]") {
+    VideoCore::GPUThread gpu_thread;
+    std::vector<int> order;
+    bool on_gpu_thread = false;
+
+    for (int i = 0; i < 100; ++i) {
+        gpu_thread.PushCommand([&order, i] { order.push_back(i); });
+    }
+    const u64 fence = gpu_thread.PushCommand([&] {
+        on_gpu_thread = gpu_thread.IsGPUThread();
+        gpu_thread.DeferInterrupt(Service::GSP::InterruptId::P3D);
+    });
+    gpu_thread.PushCommand([&] { gpu_thread.DeferInterrupt(Service::GSP::InterruptId::PPF); });
+    gpu_thread.Synchronize("test");
+
+    REQUIRE(order.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(order[i] == i);
+    }
+    REQUIRE(on_gpu_thread);
+    REQUIRE_FALSE(gpu_thread.IsGPUThread());
+
+    // Interrupts are handed out up to the fence of the command that raised them
+    const auto interrupts = gpu_thread.TakeInterrupts(fence);
+    REQUIRE(interrupts.size() == 1);
+    REQUIRE(interrupts[0] == Service::GSP::InterruptId::P3D);
+    REQUIRE(gpu_thread.TakeInterrupts(fence + 1).size() == 1);
+    REQUIRE(gpu_thread.TakeInterrupts(fence + 1).empty());
+}
+
+TEST_CASE("GPUThread command overhead", "[.benchmark][video_core]") {
+    // Empty commands, so only the cost of queueing them and of waiting at sync points is timed
+    constexpr int NUM_SYNC_POINTS = 1000;
+    constexpr int COMMANDS_PER_SYNC_POINT = 100;
+
+    VideoCore::GPUThread gpu_thread;
+    int commands_run = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_SYNC_POINTS; ++i) {
+        for (int j = 0; j < COMMANDS_PER_SYNC_POINT; ++j) {
+            gpu_thread.PushCommand([&commands_run] { ++commands_run; });
+        }
+        gpu_thread.Synchronize("benchmark");
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    REQUIRE(commands_run == NUM_SYNC_POINTS * COMMANDS_PER_SYNC_POINT);
+    WARN(elapsed.count() / (NUM_SYNC_POINTS * COMMANDS_PER_SYNC_POINT)
+         << " us per command including its share of the sync points, "
+         << gpu_thread.GetSyncPointCount() << " waits at " << NUM_SYNC_POINTS << " sync points");
+}
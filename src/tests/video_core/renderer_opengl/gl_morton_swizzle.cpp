@@ -0,0 +1,87 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "tests/common/test_data.h"
+#include "video_core/renderer_opengl/gl_morton_swizzle.h"
+
+namespace {
+
+constexpr u32 STRIDE = 24;
+
+/// Checks a tile copy against a per pixel copy in both directions
+template <u32 bytes_per_pixel, u32 gl_bytes_per_pixel, bool is_d24s8>
+void CheckMortonCopyTile() {
+    constexpr u32 gl_offset = gl_bytes_per_pixel - bytes_per_pixel;
+    const std::vector<u8> tile = TestData::GenerateData(64 * bytes_per_pixel);
+
+    std::vector<u8> gl_buffer(8 * STRIDE * gl_bytes_per_pixel);
+    OpenGL::MortonCopyTile<true, bytes_per_pixel, gl_bytes_per_pixel, is_d24s8>(
+        STRIDE, const_cast<u8*>(tile.data()), gl_buffer.data() + gl_offset);
+
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            const u8* tile_pixel = &tile[VideoCore::MortonInterleave(x, y) * bytes_per_pixel];
+            const u8* gl_pixel = &gl_buffer[((7 - y) * STRIDE + x) * gl_bytes_per_pixel];
+            for (u32 i = 0; i < bytes_per_pixel; ++i) {
+                const u32 gl_byte = is_d24s8 ? (i + 1) % 4 : i + gl_offset;
+                REQUIRE(gl_pixel[gl_byte] == tile_pixel[i]);
+            }
+        }
+    }
+
+    std::vector<u8> round_trip(tile.size());
+    OpenGL::MortonCopyTile<false, bytes_per_pixel, gl_bytes_per_pixel, is_d24s8>(
+        STRIDE, round_trip.data(), gl_buffer.data() + gl_offset);
+    REQUIRE(round_trip == tile);
+}
+
+template <u32 bytes_per_pixel, u32 gl_bytes_per_pixel, bool is_d24s8>
+void BenchmarkMortonCopyTile(const char* name) {
+    constexpr u32 SIZE = 1024;
+    constexpr int NUM_ITERATIONS = 20;
+    std::vector<u8> tiles = TestData::GenerateData(SIZE * SIZE * bytes_per_pixel);
+    std::vector<u8> gl_buffer(SIZE * SIZE * gl_bytes_per_pixel);
+
+    const auto Run = [&](auto copy_tile) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            u8* tile = tiles.data();
+            for (u32 y = 0; y < SIZE; y += 8) {
+                for (u32 x = 0; x < SIZE; x += 8) {
+                    copy_tile(SIZE, tile, &gl_buffer[(y * SIZE + x) * gl_bytes_per_pixel]);
+                    tile += 64 * bytes_per_pixel;
+                }
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return tiles.size() * NUM_ITERATIONS / elapsed.count() / (1024 * 1024);
+    };
+
+    const double load =
+        Run(OpenGL::MortonCopyTile<true, bytes_per_pixel, gl_bytes_per_pixel, is_d24s8>);
+    const double flush =
+        Run(OpenGL::MortonCopyTile<false, bytes_per_pixel, gl_bytes_per_pixel, is_d24s8>);
+    WARN(name << ": " << load << " MB/s to OpenGL, " << flush << " MB/s to 3DS memory");
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopyTile matches per pixel copies", "[video_core][renderer_opengl]") {
+    CheckMortonCopyTile<4, 4, false>(); // RGBA8
+    CheckMortonCopyTile<3, 3, false>(); // RGB8
+    CheckMortonCopyTile<2, 2, false>(); // RGB5A1, RGB565, RGBA4, D16
+    CheckMortonCopyTile<3, 4, false>(); // D24
+    CheckMortonCopyTile<4, 4, true>();  // D24S8
+}
+
+TEST_CASE("MortonCopyTile throughput", "[.benchmark][video_core][renderer_opengl]") {
+    BenchmarkMortonCopyTile<4, 4, false>("RGBA8");
+    BenchmarkMortonCopyTile<3, 3, false>("RGB8");
+    BenchmarkMortonCopyTile<2, 2, false>("RGB5A1/RGB565/RGBA4/D16");
+    BenchmarkMortonCopyTile<3, 4, false>("D24");
+    BenchmarkMortonCopyTile<4, 4, true>("D24S8");
+}
@@ -0,0 +1,130 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+#include "video_core/regs.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace {
+
+/// Reads the raw entries of every transferable disk shader cache of the user directory
+std::vector<OpenGL::ShaderDiskCacheRaw> LoadTransferableCaches(const std::string& directory) {
+    std::vector<OpenGL::ShaderDiskCacheRaw> raws;
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, directory,
+        [&raws](u64*, const std::string& directory, const std::string& virtual_name) {
+            FileUtil::IOFile file(directory + "/" + virtual_name, "rb");
+            u8 version;
+            if (!file.IsOpen() || file.ReadBytes(&version, sizeof(version)) != sizeof(version)) {
+                return true;
+            }
+            // Every entry is a raw entry, of kind 0
+            u8 kind;
+            OpenGL::ShaderDiskCacheRaw raw;
+            while (file.ReadBytes(&kind, sizeof(kind)) == sizeof(kind) && kind == 0 &&
+                   raw.Load(file)) {
+                raws.push_back(raw);
+            }
+            return true;
+        });
+    return raws;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GenerateFragmentShader gives the same code with and without the snippet cache",
+          "[video_core][renderer_opengl]") {
+    constexpr std::size_t NUM_BASES = 8;
+    constexpr int NUM_CONFIGS = 1000;
+    constexpr int MAX_SWAPPED_REGS = 64;
+
+    // Random registers, then configs made of one of them with a few registers from another, so
+    // that the configs share most of their TEV stages, lighting and procedural texture with
+    // configs generated before and differ in the rest
+    std::mt19937 rng(1234);
+    std::vector<Pica::Regs> bases(NUM_BASES);
+    for (Pica::Regs& regs : bases) {
+        for (u32& reg : regs.reg_array) {
+            reg = static_cast<u32>(rng());
+        }
+    }
+
+    for (int i = 0; i < NUM_CONFIGS; ++i) {
+        Pica::Regs regs = bases[rng() % NUM_BASES];
+        const Pica::Regs& other = bases[rng() % NUM_BASES];
+        const int num_swapped_regs = static_cast<int>(rng() % (MAX_SWAPPED_REGS + 1));
+        for (int j = 0; j < num_swapped_regs; ++j) {
+            const std::size_t index = rng() % Pica::Regs::NUM_REGS;
+            regs.reg_array[index] = other.reg_array[index];
+        }
+        const auto config = OpenGL::PicaFSConfig::BuildFromRegs(regs);
+
+        OpenGL::SetFragmentShaderSnippetCacheEnabled(false);
+        const std::string expected = OpenGL::GenerateFragmentShader(config, true).code;
+        OpenGL::SetFragmentShaderSnippetCacheEnabled(true);
+        INFO("config " << i);
+        REQUIRE(OpenGL::GenerateFragmentShader(config, true).code == expected);
+    }
+}
+
+TEST_CASE("GLSL generation of the disk shader cache configurations",
+          "[.benchmark][video_core][renderer_opengl]") {
+    // Generated by playing with the disk shader cache enabled
+    const std::string directory =
+        FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) + "opengl/transferable";
+    const std::vector<OpenGL::ShaderDiskCacheRaw> raws = LoadTransferableCaches(directory);
+    if (raws.empty()) {
+        WARN("No disk shader cache in " << directory);
+        return;
+    }
+
+    const auto Run = [&](OpenGL::ProgramType type) {
+        std::size_t count = 0;
+        std::size_t size = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const OpenGL::ShaderDiskCacheRaw& raw : raws) {
+            if (raw.GetProgramType() != type) {
+                continue;
+            }
+            if (type == OpenGL::ProgramType::FS) {
+                const auto config = OpenGL::PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+                size += OpenGL::GenerateFragmentShader(config, true).code.size();
+            } else {
+                const auto& code = raw.GetProgramCode();
+                Pica::Shader::ShaderSetup setup;
+                std::copy_n(code.begin(), setup.program_code.size(), setup.program_code.begin());
+                std::copy_n(code.begin() + setup.program_code.size(), setup.swizzle_data.size(),
+                            setup.swizzle_data.begin());
+                const OpenGL::PicaVSConfig config(raw.GetRawShaderConfig().vs, setup);
+                const auto result = OpenGL::GenerateVertexShader(setup, config, true);
+                size += result ? result->code.size() : 0;
+            }
+            ++count;
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return std::make_tuple(count, size, elapsed.count());
+    };
+
+    // The first pass starts with empty snippet caches, like a cache miss during gameplay, while
+    // the second one only generates what isn't memoized
+    for (const char* pass : {"first pass", "second pass"}) {
+        for (const auto type : {OpenGL::ProgramType::FS, OpenGL::ProgramType::VS}) {
+            const auto [count, size, elapsed] = Run(type);
+            if (count == 0) {
+                continue;
+            }
+            WARN((type == OpenGL::ProgramType::FS ? "Fragment" : "Vertex")
+                 << " shaders, " << pass << ": " << count << " shaders, " << size / count
+                 << " bytes and " << elapsed / count << " us each");
+        }
+    }
+}
@@ -0,0 +1,128 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include <catch2/catch.hpp>
+#include "video_core/renderer_opengl/gl_surface_page_index.h"
+
+namespace {
+
+struct FakeSurface {
+    PAddr addr;
+    PAddr end;
+};
+
+using FakeSurfacePtr = std::shared_ptr<FakeSurface>;
+using Interval = boost::icl::right_open_interval<PAddr>;
+using MarkCall = std::tuple<PAddr, u32, bool>;
+
+/// The interval maps RasterizerCacheOpenGL used before the page index
+struct IntervalMapIndex {
+    boost::icl::interval_map<PAddr, std::set<FakeSurfacePtr>, boost::icl::partial_absorber,
+                             std::less, boost::icl::inplace_plus, boost::icl::inter_section,
+                             Interval>
+        surfaces;
+    boost::icl::interval_map<u32, int> cached_pages;
+
+    std::vector<FakeSurfacePtr> GetOverlapping(PAddr begin, PAddr end) const {
+        std::vector<FakeSurfacePtr> result;
+        for (const auto& pair : boost::make_iterator_range(surfaces.equal_range({begin, end}))) {
+            for (const FakeSurfacePtr& surface : pair.second) {
+                if (std::find(result.begin(), result.end(), surface) == result.end()) {
+                    result.push_back(surface);
+                }
+            }
+        }
+        return result;
+    }
+
+    void UpdateCachedCount(PAddr addr, u32 size, int delta, std::vector<MarkCall>& calls) {
+        const u32 page_start = addr >> Memory::PAGE_BITS;
+        const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+        const auto pages_interval =
+            boost::icl::interval_map<u32, int>::interval_type::right_open(page_start, page_end);
+        if (delta > 0)
+            cached_pages.add({pages_interval, delta});
+        for (const auto& pair :
+             boost::make_iterator_range(cached_pages.equal_range(pages_interval))) {
+            const auto interval = pair.first & pages_interval;
+            const PAddr start = boost::icl::first(interval) << Memory::PAGE_BITS;
+            const PAddr end = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+            if (delta > 0 && pair.second == delta)
+                calls.emplace_back(start, end - start, true);
+            else if (delta < 0 && pair.second == -delta)
+                calls.emplace_back(start, end - start, false);
+        }
+        if (delta < 0)
+            cached_pages.add({pages_interval, delta});
+    }
+};
+
+} // Anonymous namespace
+
+TEST_CASE("SurfacePageIndex matches the interval maps", "[video_core][renderer_opengl]") {
+    std::mt19937 rng(1234);
+    // Surfaces in VRAM and at the start of FCRAM, so they often overlap
+    const auto RandomAddress = [&rng] {
+        return (rng() % 2 ? 0x18000000 : 0x20000000) + (rng() % 0x100000 & ~0xF);
+    };
+
+    auto index = std::make_unique<OpenGL::SurfacePageIndex<FakeSurfacePtr>>();
+    IntervalMapIndex reference;
+    std::vector<FakeSurfacePtr> surfaces;
+    std::vector<MarkCall> calls;
+    std::vector<MarkCall> reference_calls;
+
+    for (int step = 0; step < 2000; ++step) {
+        if (surfaces.empty() || rng() % 3 != 0) {
+            const PAddr addr = RandomAddress();
+            const u32 size = 0x10 + (rng() % (rng() % 4 == 0 ? 0x40000 : 0x4000) & ~0xF);
+            auto surface = std::make_shared<FakeSurface>(FakeSurface{addr, addr + size});
+            index->Add(surface);
+            index->UpdateCachedCount(addr, size, 1, [&](PAddr start, u32 size, bool cached) {
+                calls.emplace_back(start, size, cached);
+            });
+            reference.surfaces.add({Interval(addr, addr + size), {surface}});
+            reference.UpdateCachedCount(addr, size, 1, reference_calls);
+            surfaces.push_back(std::move(surface));
+        } else {
+            const std::size_t i = rng() % surfaces.size();
+            const FakeSurfacePtr surface = surfaces[i];
+            surfaces.erase(surfaces.begin() + i);
+            const u32 size = surface->end - surface->addr;
+            index->UpdateCachedCount(surface->addr, size, -1,
+                                     [&](PAddr start, u32 size, bool cached) {
+                                         calls.emplace_back(start, size, cached);
+                                     });
+            index->Remove(surface);
+            reference.UpdateCachedCount(surface->addr, size, -1, reference_calls);
+            reference.surfaces.subtract({Interval(surface->addr, surface->end), {surface}});
+        }
+        INFO("step " << step);
+        REQUIRE(calls == reference_calls);
+
+        for (int lookup = 0; lookup < 4; ++lookup) {
+            const PAddr begin = RandomAddress();
+            const PAddr end = begin + 1 + rng() % (lookup == 0 ? 0x100000 : 0x2000);
+            const auto result = index->GetOverlapping(begin, end);
+            const auto expected = reference.GetOverlapping(begin, end);
+            REQUIRE(std::vector<FakeSurfacePtr>(result.begin(), result.end()) == expected);
+        }
+    }
+
+    // Lookups larger than the number of pages visit every surface instead
+    const auto result = index->GetOverlapping(0, 0xFFFFFFFF);
+    REQUIRE(std::vector<FakeSurfacePtr>(result.begin(), result.end()) ==
+            reference.GetOverlapping(0, 0xFFFFFFFF));
+
+    while (!index->Empty()) {
+        index->Remove(index->Front());
+    }
+    REQUIRE(index->GetOverlapping(0x18000000, 0x30000000).empty());
+}
@@ -0,0 +1,58 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/renderer_software/renderer_software.h"
+
+namespace {
+
+GPU::Regs::FramebufferConfig MakeFramebuffer(u32 width, u32 height, GPU::Regs::PixelFormat format,
+                                             u32 stride) {
+    GPU::Regs::FramebufferConfig framebuffer{};
+    framebuffer.width.Assign(width);
+    framebuffer.height.Assign(height);
+    framebuffer.color_format.Assign(format);
+    framebuffer.stride = stride;
+    return framebuffer;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DecodeLCDFramebuffer turns the framebuffer upright", "[video_core]") {
+    // A 3x2 screen, stored as 3 rows of 2 pixels, each row being a column from the bottom
+    constexpr u32 STRIDE = 2 * 3 + 2;
+    const auto framebuffer = MakeFramebuffer(2, 3, GPU::Regs::PixelFormat::RGB8, STRIDE);
+    std::vector<u8> source(STRIDE * 3);
+    for (u8 column = 0; column < 3; ++column) {
+        for (u8 row = 0; row < 2; ++row) {
+            // RGB8 is stored as BGR, the red channel has the screen position
+            u8* pixel = &source[column * STRIDE + (1 - row) * 3];
+            pixel[0] = 0;
+            pixel[1] = 0;
+            pixel[2] = static_cast<u8>(row * 3 + column);
+        }
+    }
+
+    std::vector<u8> dest(3 * 2 * 4);
+    REQUIRE(VideoCore::DecodeLCDFramebuffer(framebuffer, source.data(), dest.data(), 3 * 4, 3, 2));
+    for (u32 i = 0; i < 6; ++i) {
+        INFO("pixel " << i);
+        REQUIRE(dest[i * 4] == i);
+        REQUIRE(dest[i * 4 + 3] == 255);
+    }
+}
+
+TEST_CASE("DecodeLCDFramebuffer stretches the framebuffer", "[video_core]") {
+    // A single red RGB565 pixel stretched to 2x2
+    const auto framebuffer = MakeFramebuffer(1, 1, GPU::Regs::PixelFormat::RGB565, 2);
+    const std::vector<u8> source{0x00, 0xF8};
+    std::vector<u8> dest(2 * 2 * 4);
+    REQUIRE(VideoCore::DecodeLCDFramebuffer(framebuffer, source.data(), dest.data(), 2 * 4, 2, 2));
+    for (u32 i = 0; i < 4; ++i) {
+        REQUIRE(dest[i * 4] == 255);
+        REQUIRE(dest[i * 4 + 1] == 0);
+        REQUIRE(dest[i * 4 + 2] == 0);
+    }
+}
@@ -0,0 +1,138 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/hash.h"
+#include "core/memory.h"
+#include "tests/video_core/swrasterizer/swrasterizer_fixtures.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+using Pica::float24;
+using Pica::Shader::OutputVertex;
+
+using SWRasterizerFixtures::ClearBuffers;
+using SWRasterizerFixtures::ReadBuffers;
+
+void SetupRegisters() {
+    SWRasterizerFixtures::SetupRegisters();
+
+    // 128.0 as a raw float24, so that the viewport covers the framebuffer
+    auto& rasterizer_regs = Pica::g_state.regs.rasterizer;
+    rasterizer_regs.viewport_size_x.Assign(0x460000);
+    rasterizer_regs.viewport_size_y.Assign(0x460000);
+}
+
+/// Generates triangles in clip space, with vertices inside and outside of every clipping plane
+std::vector<OutputVertex> GenerateTriangles(std::size_t count, float scale) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-scale, scale);
+    std::uniform_real_distribution<float> depth(-scale, 0.5f);
+    std::uniform_real_distribution<float> w(-0.25f, 2.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<OutputVertex> vertices(count * 3);
+    for (OutputVertex& vertex : vertices) {
+        const float vertex_w = w(rng);
+        vertex.pos = Common::MakeVec(float24::FromFloat32(position(rng) * vertex_w),
+                                     float24::FromFloat32(position(rng) * vertex_w),
+                                     float24::FromFloat32(depth(rng) * vertex_w),
+                                     float24::FromFloat32(vertex_w));
+        vertex.color =
+            Common::MakeVec(float24::FromFloat32(unit(rng)), float24::FromFloat32(unit(rng)),
+                            float24::FromFloat32(unit(rng)), float24::FromFloat32(unit(rng)));
+    }
+    return vertices;
+}
+
+/// Shrinks the triangles around their first vertex, so most are entirely visible or off screen
+void ShrinkTriangles(std::vector<OutputVertex>& vertices, float size) {
+    for (std::size_t i = 0; i < vertices.size(); i += 3) {
+        const float24 offset = vertices[i].pos.w * float24::FromFloat32(size);
+        vertices[i + 1].pos = vertices[i].pos;
+        vertices[i + 1].pos.x += offset;
+        vertices[i + 2].pos = vertices[i].pos;
+        vertices[i + 2].pos.y += offset;
+    }
+}
+
+std::vector<u8> DrawTriangles(Memory::MemorySystem& memory,
+                              const std::vector<OutputVertex>& vertices, bool batched) {
+    ClearBuffers(memory);
+    if (batched) {
+        Pica::Clipper::ProcessTriangles(vertices.data(), vertices.size() / 3);
+    } else {
+        for (std::size_t i = 0; i < vertices.size(); i += 3) {
+            Pica::Clipper::ProcessTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+        }
+    }
+    Pica::Rasterizer::FlushTriangles();
+    return ReadBuffers(memory);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Clipper matches the reference output", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    // Hashes of the buffers drawn by the clipper before it clipped triangles in batches, for
+    // large and small triangles without and with the custom clipping plane
+    constexpr std::array<std::array<u64, 2>, 2> reference_hashes{{
+        {0xB5C631A868EEB2BE, 0xF147D7612D77E0B1},
+        {0x196EA370DFB56ECF, 0x12725E3B7B9F00C6},
+    }};
+
+    std::vector<OutputVertex> vertices = GenerateTriangles(1000, 1.5f);
+    for (const bool small : {false, true}) {
+        if (small) {
+            ShrinkTriangles(vertices, 0.1f);
+        }
+
+        for (const bool clip_enable : {false, true}) {
+            // Custom clipping plane x + 0.5 * w >= 0
+            auto& rasterizer_regs = Pica::g_state.regs.rasterizer;
+            rasterizer_regs.clip_enable.Assign(clip_enable);
+            rasterizer_regs.clip_coef[0].Assign(0x3F0000);
+            rasterizer_regs.clip_coef[3].Assign(0x3E0000);
+
+            const std::vector<u8> one_at_a_time = DrawTriangles(memory, vertices, false);
+            REQUIRE(Common::ComputeHash64(one_at_a_time.data(), one_at_a_time.size()) ==
+                    reference_hashes[small][clip_enable]);
+            REQUIRE(DrawTriangles(memory, vertices, true) == one_at_a_time);
+        }
+    }
+}
+
+TEST_CASE("Clipper triangle throughput", "[.benchmark][video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    // Most triangles of a scene are small, and either entirely visible or entirely off screen
+    std::vector<OutputVertex> vertices = GenerateTriangles(100000, 1.05f);
+    ShrinkTriangles(vertices, 0.02f);
+    constexpr int NUM_ITERATIONS = 10;
+
+    for (const bool batched : {false, true}) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            DrawTriangles(memory, vertices, batched);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        WARN((batched ? "batched: " : "one at a time: ")
+             << vertices.size() / 3 * NUM_ITERATIONS / elapsed.count() / 1e6
+             << " million triangles/s");
+    }
+}
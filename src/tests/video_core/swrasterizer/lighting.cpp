@@ -0,0 +1,214 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/hash.h"
+#include "video_core/swrasterizer/lighting.h"
+
+namespace {
+
+using Pica::LightingRegs;
+
+struct LightingFragment {
+    Common::Quaternion<float> normquat;
+    Common::Vec3<float> view;
+    std::array<Common::Vec4<u8>, 4> texture_color;
+};
+
+/// Generates random registers, with valid values for the fields the lighting depends on
+LightingRegs GenerateRegisters(std::mt19937& rng) {
+    LightingRegs regs;
+    u32* words = reinterpret_cast<u32*>(&regs);
+    for (std::size_t i = 0; i < sizeof(regs) / sizeof(u32); ++i) {
+        words[i] = static_cast<u32>(rng());
+    }
+
+    constexpr LightingRegs::LightingConfig configs[]{
+        LightingRegs::LightingConfig::Config0, LightingRegs::LightingConfig::Config1,
+        LightingRegs::LightingConfig::Config2, LightingRegs::LightingConfig::Config3,
+        LightingRegs::LightingConfig::Config4, LightingRegs::LightingConfig::Config5,
+        LightingRegs::LightingConfig::Config6, LightingRegs::LightingConfig::Config7,
+    };
+    regs.disable.Assign(0);
+    regs.config0.config.Assign(configs[rng() % 8]);
+    regs.config0.bump_mode.Assign(static_cast<LightingRegs::LightingBumpMode>(rng() % 3));
+    regs.lut_input.d0.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.d1.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.sp.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.fr.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.rb.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.rg.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    regs.lut_input.rr.Assign(static_cast<LightingRegs::LightingLutInput>(rng() % 6));
+    return regs;
+}
+
+void GenerateLuts(Pica::State::Lighting& lighting_state, std::mt19937& rng) {
+    for (auto& lut : lighting_state.luts) {
+        for (auto& entry : lut) {
+            entry.raw = static_cast<u32>(rng());
+        }
+    }
+}
+
+std::vector<LightingFragment> GenerateFragments(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+
+    std::vector<LightingFragment> fragments(count);
+    for (LightingFragment& fragment : fragments) {
+        fragment.normquat =
+            Common::Quaternion<float>{{unit(rng), unit(rng), unit(rng)}, unit(rng)}.Normalized();
+        fragment.view = {position(rng), position(rng), position(rng)};
+        for (auto& color : fragment.texture_color) {
+            color = Common::MakeVec(rng(), rng(), rng(), rng()).Cast<u8>();
+        }
+    }
+    return fragments;
+}
+
+void ComputeColors(const Pica::LightingSetup& setup, const std::vector<LightingFragment>& fragments,
+                   bool simd, std::vector<Common::Vec4<u8>>& colors) {
+    colors.resize(fragments.size() * 2);
+    std::size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; simd && i + 4 <= fragments.size(); i += 4) {
+        const LightingFragment* group = &fragments[i];
+        const Common::Quaternion<float> normquat[4]{group[0].normquat, group[1].normquat,
+                                                    group[2].normquat, group[3].normquat};
+        const Common::Vec3<float> view[4]{group[0].view, group[1].view, group[2].view,
+                                          group[3].view};
+        const std::array<Common::Vec4<u8>, 4>* const texture_color[4]{
+            &group[0].texture_color, &group[1].texture_color, &group[2].texture_color,
+            &group[3].texture_color};
+        Common::Vec4<u8> primary_color[4];
+        Common::Vec4<u8> secondary_color[4];
+        Pica::ComputeFragmentsColors4(setup, normquat, view, texture_color, primary_color,
+                                      secondary_color);
+        for (std::size_t j = 0; j < 4; ++j) {
+            colors[(i + j) * 2] = primary_color[j];
+            colors[(i + j) * 2 + 1] = secondary_color[j];
+        }
+    }
+#endif
+    for (; i < fragments.size(); ++i) {
+        std::tie(colors[i * 2], colors[i * 2 + 1]) = Pica::ComputeFragmentsColors(
+            setup, fragments[i].normquat, fragments[i].view, fragments[i].texture_color);
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Lighting matches the reference output", "[video_core][swrasterizer]") {
+    std::mt19937 rng(1234);
+    auto lighting_state = std::make_unique<Pica::State::Lighting>();
+    auto setup = std::make_unique<Pica::LightingSetup>();
+    GenerateLuts(*lighting_state, rng);
+    const std::vector<LightingFragment> fragments = GenerateFragments(64, rng);
+
+    // Hashes of the colors computed before the registers were decoded once per draw, for four
+    // groups of 50 random configurations
+    constexpr std::array<u64, 4> reference_hashes{
+        0xF2EC9167A4572305,
+        0xF78186CCC6DB3228,
+        0x4601EB9B562A9D87,
+        0x5B8BC211A18117AC,
+    };
+
+    std::vector<Common::Vec4<u8>> colors;
+    std::vector<Common::Vec4<u8>> group_colors;
+    for (const u64 reference_hash : reference_hashes) {
+        group_colors.clear();
+        for (int i = 0; i < 50; ++i) {
+            Pica::ConfigureLighting(*setup, GenerateRegisters(rng), *lighting_state);
+            ComputeColors(*setup, fragments, false, colors);
+            group_colors.insert(group_colors.end(), colors.begin(), colors.end());
+        }
+        REQUIRE(Common::ComputeHash64(group_colors.data(),
+                                      group_colors.size() * sizeof(Common::Vec4<u8>)) ==
+                reference_hash);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("Lighting of four fragments matches the scalar computation",
+          "[video_core][swrasterizer]") {
+    std::mt19937 rng(1234);
+    auto lighting_state = std::make_unique<Pica::State::Lighting>();
+    auto setup = std::make_unique<Pica::LightingSetup>();
+    GenerateLuts(*lighting_state, rng);
+    const std::vector<LightingFragment> fragments = GenerateFragments(64, rng);
+
+    std::vector<Common::Vec4<u8>> scalar;
+    std::vector<Common::Vec4<u8>> vectorized;
+    for (int i = 0; i < 500; ++i) {
+        Pica::ConfigureLighting(*setup, GenerateRegisters(rng), *lighting_state);
+        ComputeColors(*setup, fragments, false, scalar);
+        ComputeColors(*setup, fragments, true, vectorized);
+        REQUIRE(std::memcmp(scalar.data(), vectorized.data(),
+                            scalar.size() * sizeof(Common::Vec4<u8>)) == 0);
+    }
+}
+#endif
+
+TEST_CASE("Lighting fragments per second", "[.benchmark][video_core][swrasterizer]") {
+    std::mt19937 rng(1234);
+    auto lighting_state = std::make_unique<Pica::State::Lighting>();
+    auto setup = std::make_unique<Pica::LightingSetup>();
+    GenerateLuts(*lighting_state, rng);
+    const std::vector<LightingFragment> fragments = GenerateFragments(4096, rng);
+
+    LightingRegs regs{};
+    regs.light_enable.slot_1.Assign(1);
+    regs.light_enable.slot_2.Assign(2);
+    regs.light_enable.slot_3.Assign(3);
+
+    const auto Run = [&](const char* name) {
+        Pica::ConfigureLighting(*setup, regs, *lighting_state);
+        constexpr int NUM_ITERATIONS = 100;
+        std::vector<Common::Vec4<u8>> colors;
+        for (const bool simd : {false, true}) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_ITERATIONS; ++i) {
+                ComputeColors(*setup, fragments, simd, colors);
+            }
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            WARN(name << (simd ? ", four at a time: " : ": ")
+                      << fragments.size() * NUM_ITERATIONS / elapsed.count() / 1e6
+                      << " million fragments/s");
+        }
+    };
+
+    // Diffuse only
+    regs.config1.raw = 0xFFFFFFFF;
+    Run("1 light, diffuse");
+
+    // Specular highlights of a few point lights, as most games use them
+    regs.max_light_index.Assign(3);
+    regs.config0.config.Assign(LightingRegs::LightingConfig::Config0);
+    regs.config1.disable_lut_d0.Assign(0);
+    regs.config1.disable_lut_rr.Assign(0);
+    regs.config1.disable_dist_atten.Assign(0);
+    regs.lut_input.d0.Assign(LightingRegs::LightingLutInput::NH);
+    regs.lut_input.rr.Assign(LightingRegs::LightingLutInput::VH);
+    Run("4 lights, D0, RR and distance attenuation");
+
+    // Everything a fragment can use
+    regs.config0.config.Assign(LightingRegs::LightingConfig::Config7);
+    regs.config0.bump_mode.Assign(LightingRegs::LightingBumpMode::NormalMap);
+    regs.config0.enable_shadow.Assign(1);
+    regs.config0.shadow_primary.Assign(1);
+    regs.config1.raw = 0;
+    regs.lut_input.d1.Assign(LightingRegs::LightingLutInput::LN);
+    regs.lut_input.fr.Assign(LightingRegs::LightingLutInput::NV);
+    regs.lut_input.sp.Assign(LightingRegs::LightingLutInput::SP);
+    regs.lut_input.rg.Assign(LightingRegs::LightingLutInput::CP);
+    Run("4 lights, configuration 7 with all LUTs, bump mapping and shadows");
+}
@@ -0,0 +1,130 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/swrasterizer/proctex.h"
+
+namespace {
+
+using Pica::TexturingRegs;
+
+/// Fills a value LUT with a random smooth curve, like the ones games use
+void GenerateValueLut(std::array<Pica::State::ProcTex::ValueEntry, 128>& lut, std::mt19937& rng) {
+    std::uniform_real_distribution<float> slope(-2.0f, 2.0f);
+    std::array<int, 129> values;
+    float value = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    for (int& entry : values) {
+        entry = static_cast<int>(std::clamp(value, 0.0f, 1.0f) * 4095);
+        value += slope(rng) / 128;
+    }
+    for (std::size_t i = 0; i < lut.size(); ++i) {
+        lut[i].raw = 0;
+        lut[i].value.Assign(values[i]);
+        lut[i].difference.Assign(std::clamp(values[i + 1] - values[i], -2048, 2047));
+    }
+}
+
+void GenerateColorLut(Pica::State::ProcTex& state, std::mt19937& rng) {
+    std::uniform_int_distribution<int> step(-4, 4);
+    std::array<Common::Vec4<int>, 257> colors;
+    Common::Vec4<int> color =
+        Common::MakeVec(rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF).Cast<int>();
+    for (auto& entry : colors) {
+        entry = color;
+        for (std::size_t i = 0; i < 4; ++i) {
+            color[i] = std::clamp(color[i] + step(rng), 0, 255);
+        }
+    }
+    for (std::size_t i = 0; i < state.color_table.size(); ++i) {
+        const auto difference = (colors[i + 1] - colors[i]) / 2;
+        state.color_table[i].raw = 0;
+        state.color_table[i].r.Assign(colors[i].r());
+        state.color_table[i].g.Assign(colors[i].g());
+        state.color_table[i].b.Assign(colors[i].b());
+        state.color_table[i].a.Assign(colors[i].a());
+        state.color_diff_table[i].raw = 0;
+        state.color_diff_table[i].r.Assign(difference.r());
+        state.color_diff_table[i].g.Assign(difference.g());
+        state.color_diff_table[i].b.Assign(difference.b());
+        state.color_diff_table[i].a.Assign(difference.a());
+    }
+}
+
+/// Encodes a float16 in [1, 2) * 2^exponent
+u32 RandomFloat16(int exponent, std::mt19937& rng) {
+    return static_cast<u32>((15 + exponent) << 10) | (rng() & 0x3FF);
+}
+
+void GenerateRegisters(TexturingRegs& regs, std::mt19937& rng) {
+    regs.proctex.u_clamp.Assign(static_cast<TexturingRegs::ProcTexClamp>(rng() % 5));
+    regs.proctex.v_clamp.Assign(static_cast<TexturingRegs::ProcTexClamp>(rng() % 5));
+    regs.proctex.color_combiner.Assign(static_cast<TexturingRegs::ProcTexCombiner>(rng() % 10));
+    regs.proctex.alpha_combiner.Assign(static_cast<TexturingRegs::ProcTexCombiner>(rng() % 10));
+    regs.proctex.separate_alpha.Assign(rng() % 2);
+    regs.proctex.u_shift.Assign(static_cast<TexturingRegs::ProcTexShift>(rng() % 3));
+    regs.proctex.v_shift.Assign(static_cast<TexturingRegs::ProcTexShift>(rng() % 3));
+
+    regs.proctex.noise_enable.Assign(rng() % 2);
+    regs.proctex_noise_u.amplitude.Assign(static_cast<s32>(rng() % 0x800));
+    regs.proctex_noise_v.amplitude.Assign(static_cast<s32>(rng() % 0x800));
+    regs.proctex_noise_u.phase.Assign(RandomFloat16(-1, rng));
+    regs.proctex_noise_v.phase.Assign(RandomFloat16(-1, rng));
+    regs.proctex_noise_frequency.u.Assign(RandomFloat16(-1, rng));
+    regs.proctex_noise_frequency.v.Assign(RandomFloat16(-1, rng));
+
+    regs.proctex_lut.filter.Assign(rng() % 2 ? TexturingRegs::ProcTexFilter::Linear
+                                             : TexturingRegs::ProcTexFilter::Nearest);
+    regs.proctex_lut.width.Assign(128);
+    regs.proctex_lut_offset.level0.Assign(rng() % 128);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Cached procedural textures match ProcTex", "[video_core][swrasterizer]") {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-8.0f, 8.0f);
+    auto regs = std::make_unique<TexturingRegs>();
+    auto state = std::make_unique<Pica::State::ProcTex>();
+
+    for (int i = 0; i < 50; ++i) {
+        *regs = {};
+        GenerateRegisters(*regs, rng);
+        GenerateValueLut(state->noise_table, rng);
+        GenerateValueLut(state->color_map_table, rng);
+        GenerateValueLut(state->alpha_map_table, rng);
+        GenerateColorLut(*state, rng);
+        Pica::Rasterizer::InvalidateProcTexCache();
+
+        // Filtering only differs from the exact value next to discontinuities (clamping, shifts,
+        // nearest LUT filtering), so most samples must be close, and all of them on average
+        constexpr int NUM_SAMPLES = 20000;
+        std::vector<int> errors;
+        errors.reserve(NUM_SAMPLES * 4);
+        for (int sample = 0; sample < NUM_SAMPLES; ++sample) {
+            const float u = coordinate(rng);
+            const float v = coordinate(rng);
+            const auto expected = Pica::Rasterizer::ProcTex(u, v, *regs, *state);
+            const auto cached = Pica::Rasterizer::GetCachedProcTex(u, v, *regs, *state);
+            for (std::size_t component = 0; component < 4; ++component) {
+                errors.push_back(std::abs(expected[component] - cached[component]));
+            }
+        }
+
+        std::sort(errors.begin(), errors.end());
+        double mean_error = 0.0;
+        for (const int error : errors) {
+            mean_error += error;
+        }
+        mean_error /= errors.size();
+        INFO("configuration " << i);
+        REQUIRE(mean_error < 0.5);
+        REQUIRE(errors[errors.size() * 99 / 100] <= 4);
+    }
+}
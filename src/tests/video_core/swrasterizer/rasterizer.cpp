@@ -0,0 +1,179 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "core/settings.h"
+#include "tests/video_core/swrasterizer/swrasterizer_fixtures.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+using Pica::FramebufferRegs;
+using Pica::Rasterizer::Vertex;
+
+using SWRasterizerFixtures::ClearBuffers;
+using SWRasterizerFixtures::FRAMEBUFFER_SIZE;
+using SWRasterizerFixtures::ReadBuffers;
+
+void SetupRegisters() {
+    SWRasterizerFixtures::SetupRegisters();
+
+    auto& output_merger = Pica::g_state.regs.framebuffer.output_merger;
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::GreaterThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+}
+
+std::vector<std::array<Vertex, 3>> GenerateTriangles(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(0.0f, FRAMEBUFFER_SIZE - 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const auto MakeVertex = [&] {
+        Vertex vertex(Pica::Shader::OutputVertex{});
+        // The rasterizer expects the vertex after perspective divide, with pos.w = 1/w
+        vertex.pos.w = Pica::float24::FromFloat32(1.0f);
+        vertex.screenpos = Common::MakeVec(Pica::float24::FromFloat32(position(rng)),
+                                           Pica::float24::FromFloat32(position(rng)),
+                                           Pica::float24::FromFloat32(unit(rng)));
+        vertex.color = Common::MakeVec(
+            Pica::float24::FromFloat32(unit(rng)), Pica::float24::FromFloat32(unit(rng)),
+            Pica::float24::FromFloat32(unit(rng)), Pica::float24::FromFloat32(unit(rng)));
+        return vertex;
+    };
+
+    std::vector<std::array<Vertex, 3>> triangles;
+    triangles.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        triangles.push_back({MakeVertex(), MakeVertex(), MakeVertex()});
+    }
+    return triangles;
+}
+
+void DrawTriangles(const std::vector<std::array<Vertex, 3>>& triangles) {
+    for (const auto& triangle : triangles) {
+        Pica::Rasterizer::ProcessTriangle(triangle[0], triangle[1], triangle[2]);
+    }
+    Pica::Rasterizer::FlushTriangles();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Rasterizer tile binning matches serial rasterization", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    const bool multithread = Settings::values.enable_software_renderer_multithread;
+    const auto triangles = GenerateTriangles(500);
+
+    Settings::values.enable_software_renderer_multithread = false;
+    ClearBuffers(memory);
+    DrawTriangles(triangles);
+    const std::vector<u8> serial = ReadBuffers(memory);
+
+    Settings::values.enable_software_renderer_multithread = true;
+    ClearBuffers(memory);
+    DrawTriangles(triangles);
+    const std::vector<u8> binned = ReadBuffers(memory);
+
+    Settings::values.enable_software_renderer_multithread = multithread;
+
+    REQUIRE(serial == binned);
+}
+
+TEST_CASE("Rasterizer SIMD spans match scalar rasterization", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    const bool simd = Settings::values.enable_software_renderer_simd;
+    const auto triangles = GenerateTriangles(500);
+
+    for (const auto depth_buffering :
+         {Pica::RasterizerRegs::DepthBuffering::WBuffering,
+          Pica::RasterizerRegs::DepthBuffering::ZBuffering}) {
+        Pica::g_state.regs.rasterizer.depthmap_enable.Assign(depth_buffering);
+
+        Settings::values.enable_software_renderer_simd = false;
+        ClearBuffers(memory);
+        DrawTriangles(triangles);
+        const std::vector<u8> scalar = ReadBuffers(memory);
+
+        Settings::values.enable_software_renderer_simd = true;
+        ClearBuffers(memory);
+        DrawTriangles(triangles);
+        const std::vector<u8> vectorized = ReadBuffers(memory);
+
+        REQUIRE(scalar == vectorized);
+    }
+
+    Settings::values.enable_software_renderer_simd = simd;
+}
+
+TEST_CASE("Rasterizer frames per second", "[.benchmark][video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    const bool multithread = Settings::values.enable_software_renderer_multithread;
+    const auto triangles = GenerateTriangles(2000);
+    constexpr int NUM_FRAMES = 30;
+
+    for (const bool enable : {false, true}) {
+        Settings::values.enable_software_renderer_multithread = enable;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+            ClearBuffers(memory);
+            DrawTriangles(triangles);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        WARN((enable ? "binned: " : "serial: ") << NUM_FRAMES / elapsed.count() << " FPS");
+    }
+
+    Settings::values.enable_software_renderer_multithread = multithread;
+}
+
+TEST_CASE("Rasterizer triangle throughput", "[.benchmark][video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegisters();
+
+    const bool simd = Settings::values.enable_software_renderer_simd;
+
+    // Small triangles stress the per-triangle setup and span code rather than the fragment stages
+    std::vector<std::array<Vertex, 3>> triangles = GenerateTriangles(100000);
+    for (auto& triangle : triangles) {
+        for (std::size_t i = 1; i < triangle.size(); ++i) {
+            triangle[i].screenpos.x = triangle[0].screenpos.x +
+                                      (triangle[i].screenpos.x - triangle[0].screenpos.x) *
+                                          Pica::float24::FromFloat32(1.0f / 16.0f);
+            triangle[i].screenpos.y = triangle[0].screenpos.y +
+                                      (triangle[i].screenpos.y - triangle[0].screenpos.y) *
+                                          Pica::float24::FromFloat32(1.0f / 16.0f);
+        }
+    }
+
+    for (const bool enable : {false, true}) {
+        Settings::values.enable_software_renderer_simd = enable;
+
+        ClearBuffers(memory);
+        const auto start = std::chrono::steady_clock::now();
+        DrawTriangles(triangles);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        WARN((enable ? "SIMD: " : "scalar: ") << triangles.size() / elapsed.count()
+                                              << " triangles/s");
+    }
+
+    Settings::values.enable_software_renderer_simd = simd;
+}
@@ -0,0 +1,73 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+
+namespace SWRasterizerFixtures {
+
+constexpr u32 FRAMEBUFFER_SIZE = 256;
+constexpr PAddr COLOR_BUFFER_ADDRESS = Memory::VRAM_PADDR;
+constexpr PAddr DEPTH_BUFFER_ADDRESS = Memory::VRAM_PADDR + 0x100000;
+constexpr u32 BUFFER_SIZE = FRAMEBUFFER_SIZE * FRAMEBUFFER_SIZE * 4;
+
+/// Clears the registers, then sets up an RGBA8 and D24S8 framebuffer with alpha blending, drawn
+/// with the primary color
+inline void SetupRegisters() {
+    using Pica::FramebufferRegs;
+
+    auto& regs = Pica::g_state.regs;
+    std::memset(&regs, 0, sizeof(regs));
+
+    // 1.0 as a raw float24, so that the depth equals the interpolated z
+    regs.rasterizer.viewport_depth_range.Assign(0x3F0000);
+
+    auto& framebuffer = regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(1);
+    framebuffer.allow_depth_stencil_write.Assign(1);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+    framebuffer.color_buffer_address.Assign(COLOR_BUFFER_ADDRESS / 8);
+    framebuffer.depth_buffer_address.Assign(DEPTH_BUFFER_ADDRESS / 8);
+    framebuffer.width.Assign(FRAMEBUFFER_SIZE);
+    framebuffer.height.Assign(FRAMEBUFFER_SIZE - 1);
+
+    // Blending makes the result depend on the order in which triangles are drawn
+    auto& output_merger = regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(
+        FramebufferRegs::BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(
+        FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+    output_merger.alpha_blending.factor_dest_a.Assign(FramebufferRegs::BlendFactor::Zero);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+
+    // All TEV stages pass the primary color through
+    regs.lighting.disable.Assign(1);
+}
+
+inline void ClearBuffers(Memory::MemorySystem& memory) {
+    std::memset(memory.GetPhysicalPointer(COLOR_BUFFER_ADDRESS), 0, BUFFER_SIZE);
+    std::memset(memory.GetPhysicalPointer(DEPTH_BUFFER_ADDRESS), 0, BUFFER_SIZE);
+}
+
+/// Returns the color buffer followed by the depth buffer
+inline std::vector<u8> ReadBuffers(Memory::MemorySystem& memory) {
+    std::vector<u8> data(BUFFER_SIZE * 2);
+    std::memcpy(data.data(), memory.GetPhysicalPointer(COLOR_BUFFER_ADDRESS), BUFFER_SIZE);
+    std::memcpy(data.data() + BUFFER_SIZE, memory.GetPhysicalPointer(DEPTH_BUFFER_ADDRESS),
+                BUFFER_SIZE);
+    return data;
+}
+
+} // namespace SWRasterizerFixtures
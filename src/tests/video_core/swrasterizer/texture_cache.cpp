@@ -0,0 +1,67 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+TEST_CASE("Decoded textures match LookupTexture", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+
+    const auto format = GENERATE(Pica::TexturingRegs::TextureFormat::RGBA8,
+                                 Pica::TexturingRegs::TextureFormat::RGB565,
+                                 Pica::TexturingRegs::TextureFormat::IA8,
+                                 Pica::TexturingRegs::TextureFormat::ETC1A4);
+
+    Pica::Texture::TextureInfo info;
+    info.physical_address = Memory::VRAM_PADDR;
+    info.width = 64;
+    info.height = 32;
+    info.format = format;
+    info.SetDefaultStride();
+
+    u8* source = memory.GetPhysicalPointer(info.physical_address);
+    const std::size_t size = info.stride * info.height / 8;
+    std::mt19937 rng(1234);
+    const auto Randomize = [&] {
+        for (std::size_t i = 0; i < size; ++i) {
+            source[i] = static_cast<u8>(rng());
+        }
+    };
+    const auto CheckTexels = [&](const Common::Vec4<u8>* texels) {
+        REQUIRE(texels != nullptr);
+        for (u32 y = 0; y < info.height; ++y) {
+            for (u32 x = 0; x < info.width; ++x) {
+                const auto texel = Pica::Texture::LookupTexture(source, x, y, info);
+                const auto& decoded = texels[y * info.width + x];
+                REQUIRE(decoded.r() == texel.r());
+                REQUIRE(decoded.g() == texel.g());
+                REQUIRE(decoded.b() == texel.b());
+                REQUIRE(decoded.a() == texel.a());
+            }
+        }
+    };
+
+    Randomize();
+    const Common::Vec4<u8>* texels = Pica::Rasterizer::GetDecodedTexture(info);
+    CheckTexels(texels);
+    REQUIRE(Pica::Rasterizer::GetDecodedTexture(info) == texels);
+
+    // Writes must be followed by an invalidation for the cache to pick them up
+    Randomize();
+    Pica::Rasterizer::InvalidateDecodedTextures(info.physical_address + size - 1, 1);
+    CheckTexels(Pica::Rasterizer::GetDecodedTexture(info));
+
+    // Writes before the memory is marked as cached are caught when committing
+    Randomize();
+    Pica::Rasterizer::CommitDecodedTextures();
+    CheckTexels(Pica::Rasterizer::GetDecodedTexture(info));
+
+    Pica::Rasterizer::ClearDecodedTextures();
+    Pica::Rasterizer::CommitDecodedTextures();
+}
@@ -0,0 +1,120 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "tests/common/test_data.h"
+#include "video_core/texture/texture_decode.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#include "video_core/texture/texture_decode_x64.h"
+#endif
+
+namespace {
+
+using Pica::TexturingRegs;
+
+constexpr TexturingRegs::TextureFormat FORMATS[]{
+    TexturingRegs::TextureFormat::RGBA8,  TexturingRegs::TextureFormat::RGB8,
+    TexturingRegs::TextureFormat::RGB5A1, TexturingRegs::TextureFormat::RGB565,
+    TexturingRegs::TextureFormat::RGBA4,  TexturingRegs::TextureFormat::IA8,
+    TexturingRegs::TextureFormat::RG8,    TexturingRegs::TextureFormat::I8,
+    TexturingRegs::TextureFormat::A8,     TexturingRegs::TextureFormat::IA4,
+    TexturingRegs::TextureFormat::I4,     TexturingRegs::TextureFormat::A4,
+    TexturingRegs::TextureFormat::ETC1,   TexturingRegs::TextureFormat::ETC1A4,
+};
+
+Pica::Texture::TextureInfo MakeTextureInfo(TexturingRegs::TextureFormat format, u32 width,
+                                           u32 height) {
+    Pica::Texture::TextureInfo info{};
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+std::vector<u8> GenerateTextureData(const Pica::Texture::TextureInfo& info) {
+    return TestData::GenerateData(info.stride * info.height / 8);
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Checks the tile decoder against the generic one of the format on random tiles
+void CheckTileDecoder(Pica::Texture::TileDecoder decoder, TexturingRegs::TextureFormat format) {
+    constexpr std::size_t NUM_TILES = 256;
+    const Pica::Texture::TileDecoder generic = Pica::Texture::GetTileDecoderGeneric(format);
+    REQUIRE(generic != nullptr);
+
+    const std::size_t tile_size = Pica::Texture::CalculateTileSize(format);
+    const std::vector<u8> tiles = TestData::GenerateData(tile_size * NUM_TILES);
+    std::array<u8, 64 * 4> expected;
+    std::array<u8, 64 * 4> texels;
+    for (std::size_t i = 0; i < NUM_TILES; ++i) {
+        generic(&tiles[i * tile_size], expected.data());
+        decoder(&tiles[i * tile_size], texels.data());
+        INFO("format " << static_cast<u32>(format) << " tile " << i);
+        REQUIRE(texels == expected);
+    }
+}
+#endif
+
+} // Anonymous namespace
+
+TEST_CASE("DecodeTexture matches LookupTexture", "[video_core][texture]") {
+    for (const auto format : FORMATS) {
+        const auto info = MakeTextureInfo(format, 64, 32);
+        const std::vector<u8> source = GenerateTextureData(info);
+        std::vector<u8> decoded(info.width * info.height * 4);
+        Pica::Texture::DecodeTexture(source.data(), decoded.data(), info.width, info.height,
+                                     format);
+
+        for (u32 y = 0; y < info.height; ++y) {
+            for (u32 x = 0; x < info.width; ++x) {
+                auto texel = Pica::Texture::LookupTexture(source.data(), x, y, info);
+                INFO("format " << static_cast<u32>(format) << " x " << x << " y " << y);
+                REQUIRE(std::memcmp(texel.AsArray(), &decoded[(y * info.width + x) * 4], 4) == 0);
+            }
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("Tile decoder SIMD implementations match the generic ones", "[video_core][texture]") {
+    const auto& caps = Common::GetCPUCaps();
+    for (const auto format : FORMATS) {
+        const auto ssse3 = Pica::Texture::GetTileDecoderSSSE3(format);
+        if (ssse3 != nullptr && caps.ssse3) {
+            CheckTileDecoder(ssse3, format);
+        }
+        const auto avx2 = Pica::Texture::GetTileDecoderAVX2(format);
+        if (avx2 != nullptr && caps.avx2) {
+            CheckTileDecoder(avx2, format);
+        }
+    }
+}
+#endif
+
+TEST_CASE("DecodeTexture throughput", "[.benchmark][video_core][texture]") {
+    constexpr u32 SIZE = 1024;
+    constexpr int NUM_ITERATIONS = 50;
+
+    for (const auto format : FORMATS) {
+        const auto info = MakeTextureInfo(format, SIZE, SIZE);
+        const std::vector<u8> source = GenerateTextureData(info);
+        std::vector<u8> decoded(SIZE * SIZE * 4);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            Pica::Texture::DecodeTexture(source.data(), decoded.data(), SIZE, SIZE, format);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        WARN("format " << static_cast<u32>(format) << ": "
+                       << decoded.size() * NUM_ITERATIONS / elapsed.count() / (1024 * 1024)
+                       << " MB/s decoded");
+    }
+}
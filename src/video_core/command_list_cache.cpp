@@ -0,0 +1,187 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <bitset>
+#include <cstring>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "video_core/command_list_cache.h"
+#include "video_core/command_processor.h"
+#include "video_core/regs.h"
+
+namespace Pica {
+
+/// Registers that WritePicaReg in the command processor handles specially
+static bool HasSideEffects(u32 id) {
+    if (id >= Regs::NUM_REGS) {
+        // Logged as an error by the command processor
+        return true;
+    }
+
+    static const std::bitset<Regs::NUM_REGS> registers = [] {
+        std::bitset<Regs::NUM_REGS> registers;
+        const auto add = [&registers](std::size_t first, std::size_t count = 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                registers.set(first + i);
+            }
+        };
+        add(PICA_REG_INDEX(trigger_irq));
+        add(PICA_REG_INDEX(pipeline.triangle_topology));
+        add(PICA_REG_INDEX(pipeline.restart_primitive));
+        add(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.index));
+        add(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.set_value[0]), 3);
+        add(PICA_REG_INDEX(pipeline.command_buffer.trigger[0]), 2);
+        add(PICA_REG_INDEX(pipeline.trigger_draw));
+        add(PICA_REG_INDEX(pipeline.trigger_draw_indexed));
+        add(PICA_REG_INDEX(gs.bool_uniforms));
+        add(PICA_REG_INDEX(gs.int_uniforms[0]), 4);
+        add(PICA_REG_INDEX(gs.uniform_setup.set_value[0]), 8);
+        add(PICA_REG_INDEX(gs.program.set_word[0]), 8);
+        add(PICA_REG_INDEX(gs.swizzle_patterns.set_word[0]), 8);
+        add(PICA_REG_INDEX(vs.bool_uniforms));
+        add(PICA_REG_INDEX(vs.int_uniforms[0]), 4);
+        add(PICA_REG_INDEX(vs.uniform_setup.set_value[0]), 8);
+        add(PICA_REG_INDEX(vs.program.set_word[0]), 8);
+        add(PICA_REG_INDEX(vs.swizzle_patterns.set_word[0]), 8);
+        add(PICA_REG_INDEX(lighting.lut_data[0]), 8);
+        add(PICA_REG_INDEX(texturing.fog_lut_data[0]), 8);
+        add(PICA_REG_INDEX(texturing.proctex_lut_data[0]), 8);
+        return registers;
+    }();
+    return registers[id];
+}
+
+static bool IsCommandListJump(u32 id) {
+    return id == PICA_REG_INDEX(pipeline.command_buffer.trigger[0]) ||
+           id == PICA_REG_INDEX(pipeline.command_buffer.trigger[1]);
+}
+
+/// Expands a mask with one bit per byte to a mask of the bytes
+static u32 ExpandMask(u32 mask) {
+    u32 result = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        if (mask & (1 << i)) {
+            result |= 0xFFu << (i * 8);
+        }
+    }
+    return result;
+}
+
+bool CommandListCache::Decode(const u32* list, std::size_t length, bool merge,
+                              std::vector<CommandListWrite>& writes) {
+    writes.clear();
+
+    // Position of the write to each register in the current run of writes without side effects
+    std::vector<s32> run_positions(merge ? Regs::NUM_REGS : 0, -1);
+    std::size_t run_start = 0;
+    const auto end_run = [&] {
+        for (std::size_t i = run_start; i < writes.size(); ++i) {
+            run_positions[writes[i].id] = -1;
+        }
+    };
+
+    const u32* current = list;
+    const u32* const end = list + length;
+    while (current < end) {
+        // Align read pointer to 8 bytes
+        if ((list - current) % 2 != 0) {
+            ++current;
+        }
+        if (end - current < 2) {
+            // The command processor would read past the end of the list
+            return false;
+        }
+
+        const u32 value = *current++;
+        const CommandProcessor::CommandHeader header = {*current++};
+        if (static_cast<std::size_t>(end - current) < header.extra_data_length) {
+            return false;
+        }
+
+        for (u32 i = 0; i <= header.extra_data_length; ++i) {
+            const u32 id = header.cmd_id + (header.group_commands ? i : 0);
+            const CommandListWrite write{static_cast<u16>(id),
+                                         static_cast<u8>(header.parameter_mask.Value()),
+                                         HasSideEffects(id), i == 0 ? value : *current++};
+
+            if (IsCommandListJump(id)) {
+                // The command processor continues with the next word of the new list, so a jump
+                // can only be replayed at the end of a command
+                if (i != header.extra_data_length) {
+                    return false;
+                }
+                writes.push_back(write);
+                return true;
+            }
+
+            if (!merge) {
+                writes.push_back(write);
+                continue;
+            }
+            if (write.has_side_effects) {
+                end_run();
+                writes.push_back(write);
+                run_start = writes.size();
+                continue;
+            }
+
+            s32& position = run_positions[id];
+            if (position == -1) {
+                position = static_cast<s32>(writes.size());
+                writes.push_back(write);
+            } else {
+                CommandListWrite& merged = writes[position];
+                const u32 write_mask = ExpandMask(write.mask);
+                merged.value = (merged.value & ~write_mask) | (write.value & write_mask);
+                merged.mask |= write.mask;
+            }
+        }
+    }
+    return true;
+}
+
+const CommandListCache::Entry& CommandListCache::Get(const u32* list, std::size_t length) {
+    const std::size_t size = length * sizeof(u32);
+    const u64 hash = Common::ComputeHash64(list, size);
+
+    auto it = entries.find(hash);
+    if (it != entries.end() && it->second.list.size() == length &&
+        std::memcmp(it->second.list.data(), list, size) == 0) {
+        ++hits;
+        return it->second;
+    }
+
+    ++misses;
+    if (it == entries.end()) {
+        if (entries.size() >= MAX_ENTRIES) {
+            entries.clear();
+        }
+        it = entries.emplace(hash, Entry{}).first;
+    }
+    Entry& entry = it->second;
+    entry.list.assign(list, list + length);
+    entry.replayable = Decode(list, length, true, entry.writes);
+    return entry;
+}
+
+void CommandListCache::ReportMismatch(const Entry& entry) {
+    LOG_ERROR(HW_GPU, "Cached command list of {} words doesn't match the command processor",
+              entry.list.size());
+    ++mismatches;
+    entries.erase(Common::ComputeHash64(entry.list.data(), entry.list.size() * sizeof(u32)));
+}
+
+u64 CommandListCache::GetHits() const {
+    return hits;
+}
+
+u64 CommandListCache::GetMisses() const {
+    return misses;
+}
+
+u64 CommandListCache::GetMismatches() const {
+    return mismatches;
+}
+
+} // namespace Pica
@@ -0,0 +1,75 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Pica {
+
+/// A register write of a command list
+struct CommandListWrite {
+    u16 id;
+    /// Bytes of the register that are written, one bit per byte
+    u8 mask;
+    /// The command processor does more than storing the value (uniform and LUT uploads, draws,
+    /// jumps to other command lists...), so the write must go through it in order
+    bool has_side_effects;
+    u32 value;
+
+    bool operator==(const CommandListWrite& other) const {
+        return id == other.id && mask == other.mask &&
+               has_side_effects == other.has_side_effects && value == other.value;
+    }
+};
+
+/**
+ * Caches decoded command lists by their contents, since games submit the same lists every frame.
+ * Writes are merged within runs of writes without side effects, so that each register is only
+ * written and notified to the rasterizer once per run.
+ */
+class CommandListCache {
+public:
+    struct Entry {
+        std::vector<u32> list;
+        std::vector<CommandListWrite> writes;
+        /// False if the list can't be replayed from the cache and must go through the command
+        /// processor, like a list that reads past its end
+        bool replayable;
+    };
+
+    /**
+     * Decodes a command list the way the command processor does, up to the end of the list or to
+     * a jump to another list.
+     * @param merge Merge the writes within runs of writes without side effects
+     * @returns false if the list can't be replayed
+     */
+    static bool Decode(const u32* list, std::size_t length, bool merge,
+                       std::vector<CommandListWrite>& writes);
+
+    /// Gets the decoded command list with the same contents, decoding it on a miss
+    const Entry& Get(const u32* list, std::size_t length);
+
+    /// Removes a cached command list whose replay didn't match the command processor
+    void ReportMismatch(const Entry& entry);
+
+    u64 GetHits() const;
+    u64 GetMisses() const;
+    u64 GetMismatches() const;
+
+private:
+    /// The cache is cleared when it holds more lists than this
+    static constexpr std::size_t MAX_ENTRIES = 1024;
+
+    std::unordered_map<u64, Entry> entries;
+    std::atomic<u64> hits{0};
+    std::atomic<u64> misses{0};
+    std::atomic<u64> mismatches{0};
+};
+
+} // namespace Pica
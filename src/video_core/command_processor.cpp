@@ -6,15 +6,20 @@
 #include <cstddef>
 #include <future>
 #include <memory>
+#include <optional>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
 #include "core/settings.h"
+#include "video_core/command_list_cache.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica_state.h"
@@ -107,6 +112,77 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/// Number of triangles assembled before they are handed to the rasterizer
+constexpr std::size_t TRIANGLE_BATCH_SIZE = 64;
+
+/// Vertices of the assembled triangles that weren't handed to the rasterizer yet
+static std::vector<Shader::OutputVertex> triangle_batch;
+
+/// A write that WritePicaReg handled specially, recorded while verifying a cached command list
+struct SideEffect {
+    u32 id;
+    u32 value;
+    u32 mask;
+    /// Hash of the registers before the write was handled
+    u64 regs_hash;
+    /// Registers changed by handling the write, with their new values
+    std::vector<std::pair<u32, u32>> changed_regs;
+};
+
+/**
+ * A cached command list checked against the command processor. The list is processed normally
+ * while the side effects of its writes are recorded. When the command processor leaves it, the
+ * cached list is replayed from the same registers, with the recorded side effects applied instead
+ * of performed, and must perform the same side effects and leave the same registers.
+ */
+struct CommandListVerification {
+    const CommandListCache::Entry* entry;
+    std::array<u32, Regs::NUM_REGS> start_regs;
+    std::vector<SideEffect> side_effects;
+    /// Registers before the write being handled
+    std::array<u32, Regs::NUM_REGS> regs_before_write;
+    /// Index of the next side effect while the list is replayed
+    std::optional<std::size_t> replay_position;
+    bool mismatch = false;
+};
+
+static std::optional<CommandListVerification> verification;
+
+static u64 HashRegisters(const std::array<u32, Regs::NUM_REGS>& reg_array) {
+    return Common::ComputeHash64(reg_array.data(), sizeof(reg_array));
+}
+
+static void RecordSideEffect(u32 id, u32 value, u32 mask) {
+    const auto& reg_array = g_state.regs.reg_array;
+    SideEffect side_effect{id, value, mask, HashRegisters(verification->regs_before_write), {}};
+    for (u32 i = 0; i < Regs::NUM_REGS; ++i) {
+        if (reg_array[i] != verification->regs_before_write[i]) {
+            side_effect.changed_regs.emplace_back(i, reg_array[i]);
+        }
+    }
+    verification->side_effects.push_back(std::move(side_effect));
+}
+
+/// Applies the recorded side effect of a write of the replayed command list, if it matches
+static void ReplaySideEffect(u32 id, u32 value, u32 mask) {
+    auto& reg_array = g_state.regs.reg_array;
+    std::size_t& position = *verification->replay_position;
+    if (position >= verification->side_effects.size()) {
+        verification->mismatch = true;
+        return;
+    }
+
+    const SideEffect& side_effect = verification->side_effects[position++];
+    if (side_effect.id != id || side_effect.value != value || side_effect.mask != mask ||
+        side_effect.regs_hash != HashRegisters(reg_array)) {
+        verification->mismatch = true;
+        return;
+    }
+    for (const auto& [changed_id, changed_value] : side_effect.changed_regs) {
+        reg_array[changed_id] = changed_value;
+    }
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -125,6 +201,14 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
 
+    if (verification) {
+        if (verification->replay_position) {
+            ReplaySideEffect(id, value, mask);
+            return;
+        }
+        verification->regs_before_write = regs.reg_array;
+    }
+
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
         DebugUtils::OnPicaRegWrite({(u16)id, (u16)mask, regs.reg_array[id]});
@@ -134,6 +218,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandLoaded,
                                  reinterpret_cast<void*>(&id));
 
+    bool has_side_effects = true;
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
@@ -237,7 +322,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     // TODO: If drawing after every immediate mode triangle kills performance,
                     // change it to flush triangles whenever a drawing config register changes
                     // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+                    {
+                        Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+                        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+                    }
                     if (g_debug_context) {
                         g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
                                                  nullptr);
@@ -250,6 +338,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     case PICA_REG_INDEX(pipeline.gpu_mode):
         // This register likely just enables vertex processing and doesn't need any special handling
+        has_side_effects = false;
         break;
 
     case PICA_REG_INDEX(pipeline.command_buffer.trigger[0]):
@@ -435,10 +524,24 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             ASSERT(is_indexed);
         }
 
-        const auto AddTriangle =
-            [rasterizer = VideoCore::g_renderer->Rasterizer()](
-                const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
-                const Pica::Shader::OutputVertex& v2) { rasterizer->AddTriangle(v0, v1, v2); };
+        // Assembled triangles are handed to the rasterizer in batches
+        VideoCore::RasterizerInterface* rasterizer = VideoCore::g_renderer->Rasterizer();
+        const auto FlushTriangleBatch = [rasterizer] {
+            if (!triangle_batch.empty()) {
+                rasterizer->AddTriangles(triangle_batch.data(), triangle_batch.size() / 3);
+                triangle_batch.clear();
+            }
+        };
+        const auto AddTriangle = [&FlushTriangleBatch](const Pica::Shader::OutputVertex& v0,
+                                                       const Pica::Shader::OutputVertex& v1,
+                                                       const Pica::Shader::OutputVertex& v2) {
+            triangle_batch.push_back(v0);
+            triangle_batch.push_back(v1);
+            triangle_batch.push_back(v2);
+            if (triangle_batch.size() == TRIANGLE_BATCH_SIZE * 3) {
+                FlushTriangleBatch();
+            }
+        };
 
         for (u32 index = 0; index < regs.pipeline.num_vertices; ++index) {
             const u32 vertex = VertexIndex(index);
@@ -463,12 +566,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 primitive_assembler.SubmitVertex(cached_vertex.output_vertex, AddTriangle);
             }
         }
+        FlushTriangleBatch();
 
         for (std::future<void>& future : futures) {
             future.get();
         }
 
-        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        {
+            Core::SubsystemTimer timer(Core::Subsystem::Rasterizer);
+            VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        }
         if (g_debug_context) {
             g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
         }
@@ -681,9 +788,14 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         break;
     }
     default:
+        has_side_effects = false;
         break;
     }
 
+    if (verification && has_side_effects) {
+        RecordSideEffect(id, value, mask);
+    }
+
     VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
 
     if (g_debug_context)
@@ -691,11 +803,105 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                                  reinterpret_cast<void*>(&id));
 } // namespace CommandProcessor
 
+static CommandListCache command_list_cache;
+
+/**
+ * Performs the writes of a cached command list. Writes without side effects are stored directly,
+ * and the rasterizer is notified of them at the end of their run, unless the list is verified.
+ */
+static void ReplayCommandList(const std::vector<CommandListWrite>& writes) {
+    auto& regs = g_state.regs;
+    VideoCore::RasterizerInterface* rasterizer = VideoCore::g_renderer->Rasterizer();
+
+    for (std::size_t i = 0; i < writes.size();) {
+        if (writes[i].has_side_effects) {
+            WritePicaReg(writes[i].id, writes[i].value, writes[i].mask);
+            ++i;
+            continue;
+        }
+
+        std::size_t run_end = i;
+        for (; run_end < writes.size() && !writes[run_end].has_side_effects; ++run_end) {
+            const CommandListWrite& write = writes[run_end];
+            const u32 write_mask = expand_bits_to_bytes[write.mask];
+            regs.reg_array[write.id] =
+                (regs.reg_array[write.id] & ~write_mask) | (write.value & write_mask);
+        }
+        if (verification) {
+            // The command processor notified the rasterizer already
+            i = run_end;
+            continue;
+        }
+        for (; i < run_end; ++i) {
+            rasterizer->NotifyPicaRegisterChanged(writes[i].id);
+        }
+    }
+}
+
+/// Replays the verified command list once the command processor left it, and compares the results
+static void FinishCommandListVerification() {
+    if (!verification) {
+        return;
+    }
+
+    auto& reg_array = g_state.regs.reg_array;
+    const std::array<u32, Regs::NUM_REGS> end_regs = reg_array;
+    reg_array = verification->start_regs;
+    verification->replay_position = 0;
+    ReplayCommandList(verification->entry->writes);
+
+    const bool matches = !verification->mismatch &&
+                         *verification->replay_position == verification->side_effects.size() &&
+                         reg_array == end_regs;
+    reg_array = end_regs;
+    if (!matches) {
+        command_list_cache.ReportMismatch(*verification->entry);
+    }
+    verification.reset();
+}
+
+/**
+ * Processes the current command list from the cache.
+ * @returns false if the command list must be decoded instead
+ */
+static bool ProcessCachedCommandList() {
+    if (!Settings::values.use_command_list_cache || g_debug_context ||
+        DebugUtils::IsPicaTracing()) {
+        return false;
+    }
+
+    const CommandListCache::Entry& entry =
+        command_list_cache.Get(g_state.cmd_list.head_ptr, g_state.cmd_list.length);
+    if (!entry.replayable) {
+        return false;
+    }
+    if (Settings::values.command_list_cache_verify) {
+        // The list is processed normally so that mismatches don't affect emulation
+        verification.emplace();
+        verification->entry = &entry;
+        verification->start_regs = g_state.regs.reg_array;
+        return false;
+    }
+
+    // A jump at the end of the list sets up the next one
+    g_state.cmd_list.current_ptr = g_state.cmd_list.head_ptr + g_state.cmd_list.length;
+    ReplayCommandList(entry.writes);
+    return true;
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
+    Core::SubsystemTimer timer(Core::Subsystem::PICA);
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
 
     while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
+        if (g_state.cmd_list.current_ptr == g_state.cmd_list.head_ptr) {
+            // A jump left the previous list
+            FinishCommandListVerification();
+            if (ProcessCachedCommandList()) {
+                continue;
+            }
+        }
 
         // Align read pointer to 8 bytes
         if ((g_state.cmd_list.head_ptr - g_state.cmd_list.current_ptr) % 2 != 0)
@@ -711,6 +917,12 @@ void ProcessCommandList(const u32* list, u32 size) {
             WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
         }
     }
+    FinishCommandListVerification();
+}
+
+CommandListCacheStats GetCommandListCacheStats() {
+    return {command_list_cache.GetHits(), command_list_cache.GetMisses(),
+            command_list_cache.GetMismatches()};
 }
 
 } // namespace Pica::CommandProcessor
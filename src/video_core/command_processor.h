@@ -34,4 +34,13 @@ static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect
 
 void ProcessCommandList(const u32* list, u32 size);
 
+struct CommandListCacheStats {
+    u64 hits;
+    u64 misses;
+    /// Cached command lists found to differ from their contents by the verification mode
+    u64 mismatches;
+};
+
+CommandListCacheStats GetCommandListCacheStats();
+
 } // namespace Pica::CommandProcessor
@@ -0,0 +1,291 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+#include "common/stb_image_write.h"
+#include "core/settings.h"
+#include "video_core/frame_capture.h"
+
+namespace VideoCore {
+
+namespace {
+
+u32 SwizzleBGRA(u32 pixel) {
+    return (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16);
+}
+
+void AppendU32BE(std::vector<u8>& out, u32 value) {
+    out.push_back(static_cast<u8>(value >> 24));
+    out.push_back(static_cast<u8>(value >> 16));
+    out.push_back(static_cast<u8>(value >> 8));
+    out.push_back(static_cast<u8>(value));
+}
+
+/// Guards the PNG settings of stb_image_write, which are globals
+std::mutex png_settings_mutex;
+
+std::vector<u8> EncodePNG(const CapturedFrame& frame, int level) {
+    std::vector<u8> out;
+    const auto append = [](void* context, void* data, int size) {
+        auto& buffer = *static_cast<std::vector<u8>*>(context);
+        const u8* const bytes = static_cast<const u8*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    };
+    const int width = static_cast<int>(frame.width);
+    const int height = static_cast<int>(frame.height);
+
+    std::lock_guard lock(png_settings_mutex);
+    const int previous_level = stbi_write_png_compression_level;
+    const int previous_filter = stbi_write_force_png_filter;
+    stbi_write_png_compression_level = level;
+    // Every row uses the Up filter, which is cheap and works well for the screens
+    stbi_write_force_png_filter = 2;
+    const int result =
+        stbi_write_png_to_func(append, &out, width, height, 4, frame.pixels.data(), width * 4);
+    stbi_write_png_compression_level = previous_level;
+    stbi_write_force_png_filter = previous_filter;
+    if (result == 0) {
+        return {};
+    }
+    return out;
+}
+
+std::vector<u8> EncodeQOI(const CapturedFrame& frame) {
+    constexpr u8 QOI_OP_INDEX = 0x00;
+    constexpr u8 QOI_OP_DIFF = 0x40;
+    constexpr u8 QOI_OP_LUMA = 0x80;
+    constexpr u8 QOI_OP_RUN = 0xC0;
+    constexpr u8 QOI_OP_RGB = 0xFE;
+    constexpr u8 QOI_OP_RGBA = 0xFF;
+    constexpr int MAX_RUN = 62;
+
+    std::vector<u8> out{'q', 'o', 'i', 'f'};
+    // The worst case, where every pixel is a QOI_OP_RGBA
+    out.reserve(14 + frame.pixels.size() / 4 * 5 + 8);
+    AppendU32BE(out, frame.width);
+    AppendU32BE(out, frame.height);
+    // RGBA, sRGB with linear alpha
+    out.insert(out.end(), {4, 0});
+
+    std::array<std::array<u8, 4>, 64> index{};
+    std::array<u8, 4> previous{0, 0, 0, 255};
+    int run = 0;
+    const std::size_t num_pixels = frame.pixels.size() / 4;
+    for (std::size_t i = 0; i < num_pixels; ++i) {
+        std::array<u8, 4> pixel;
+        std::memcpy(pixel.data(), &frame.pixels[i * 4], 4);
+        if (pixel == previous) {
+            if (++run == MAX_RUN || i == num_pixels - 1) {
+                out.push_back(static_cast<u8>(QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<u8>(QOI_OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const std::size_t index_position =
+            (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+        if (index[index_position] == pixel) {
+            out.push_back(static_cast<u8>(QOI_OP_INDEX | index_position));
+        } else {
+            index[index_position] = pixel;
+            if (pixel[3] == previous[3]) {
+                const int dr = static_cast<s8>(pixel[0] - previous[0]);
+                const int dg = static_cast<s8>(pixel[1] - previous[1]);
+                const int db = static_cast<s8>(pixel[2] - previous[2]);
+                const int dr_dg = dr - dg;
+                const int db_dg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back(
+                        static_cast<u8>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                } else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 &&
+                           db_dg <= 7) {
+                    out.push_back(static_cast<u8>(QOI_OP_LUMA | (dg + 32)));
+                    out.push_back(static_cast<u8>((dr_dg + 8) << 4 | (db_dg + 8)));
+                } else {
+                    out.insert(out.end(), {QOI_OP_RGB, pixel[0], pixel[1], pixel[2]});
+                }
+            } else {
+                out.insert(out.end(), {QOI_OP_RGBA, pixel[0], pixel[1], pixel[2], pixel[3]});
+            }
+        }
+        previous = pixel;
+    }
+
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+}
+
+} // Anonymous namespace
+
+void FrameCapture::RequestFrame(FrameCallback callback) {
+    std::lock_guard lock(mutex);
+    requests.push_back({next_frame, std::move(callback)});
+}
+
+bool FrameCapture::ShouldCapture(u64 frame_number) {
+    std::lock_guard lock(mutex);
+    next_frame = frame_number + 1;
+    if (std::any_of(requests.begin(), requests.end(),
+                    [frame_number](const Request& request) {
+                        return request.first_frame <= frame_number;
+                    })) {
+        return true;
+    }
+    const u32 interval = Settings::values.frame_stream_interval;
+    return interval != 0 && frame_number % interval == 0;
+}
+
+void FrameCapture::PushFrame(u64 frame_number, const u8* bgra, u32 width, u32 height) {
+    std::shared_ptr<CapturedFrame> frame = AcquireFrame();
+    frame->number = frame_number;
+    frame->width = width;
+    frame->height = height;
+    frame->pixels.resize(width * height * 4);
+    FlipAndSwizzleBGRA(bgra, frame->pixels.data(), width, height);
+    StoreFrame(std::move(frame));
+}
+
+void FrameCapture::PushFrameRGBA(u64 frame_number, const u8* rgba, u32 width, u32 height) {
+    std::shared_ptr<CapturedFrame> frame = AcquireFrame();
+    frame->number = frame_number;
+    frame->width = width;
+    frame->height = height;
+    frame->pixels.assign(rgba, rgba + width * height * 4);
+    StoreFrame(std::move(frame));
+}
+
+std::shared_ptr<CapturedFrame> FrameCapture::AcquireFrame() {
+    std::lock_guard lock(mutex);
+    std::shared_ptr<CapturedFrame> frame = std::move(ring[next_slot]);
+    if (frame == nullptr || frame.use_count() != 1) {
+        frame = std::make_shared<CapturedFrame>();
+    }
+    return frame;
+}
+
+void FrameCapture::StoreFrame(std::shared_ptr<CapturedFrame> frame) {
+    const u64 frame_number = frame->number;
+    std::vector<Request> served;
+    {
+        std::lock_guard lock(mutex);
+        ring[next_slot] = frame;
+        next_slot = (next_slot + 1) % RING_SIZE;
+        const auto end = std::stable_partition(
+            requests.begin(), requests.end(),
+            [frame_number](const Request& request) { return request.first_frame > frame_number; });
+        std::move(end, requests.end(), std::back_inserter(served));
+        requests.erase(end, requests.end());
+    }
+    frame_pushed.notify_all();
+
+    for (Request& request : served) {
+        request.callback(frame);
+    }
+}
+
+std::shared_ptr<const CapturedFrame> FrameCapture::WaitForFrame(
+    u64 after, std::chrono::milliseconds timeout) {
+    std::shared_ptr<const CapturedFrame> newest;
+    std::unique_lock lock(mutex);
+    frame_pushed.wait_for(lock, timeout, [&] {
+        for (const auto& frame : ring) {
+            if (frame != nullptr && frame->number > after &&
+                (newest == nullptr || frame->number > newest->number)) {
+                newest = frame;
+            }
+        }
+        return newest != nullptr;
+    });
+    return newest;
+}
+
+void FrameCapture::Reset() {
+    std::vector<Request> dropped;
+    {
+        std::lock_guard lock(mutex);
+        ring = {};
+        next_slot = 0;
+        next_frame = 0;
+        dropped = std::move(requests);
+        requests.clear();
+    }
+    for (Request& request : dropped) {
+        request.callback(nullptr);
+    }
+}
+
+void FlipAndSwizzleBGRA(const u8* source, u8* dest, u32 width, u32 height) {
+    const std::size_t row_size = width * 4;
+    for (u32 y = 0; y < height; ++y) {
+        const u8* in = source + (height - y - 1) * row_size;
+        u8* out = dest + y * row_size;
+        u32 x = 0;
+#ifdef ARCHITECTURE_x86_64
+        // 4 pixels at once, swapping the blue and red bytes of each
+        const __m128i green_alpha = _mm_set1_epi32(0xFF00FF00);
+        const __m128i low_byte = _mm_set1_epi32(0xFF);
+        for (; x + 4 <= width; x += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4));
+            const __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte);
+            const __m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, low_byte), 16);
+            const __m128i swizzled =
+                _mm_or_si128(_mm_and_si128(pixels, green_alpha), _mm_or_si128(red, blue));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), swizzled);
+        }
+#endif
+        for (; x < width; ++x) {
+            u32 pixel;
+            std::memcpy(&pixel, in + x * 4, 4);
+            pixel = SwizzleBGRA(pixel);
+            std::memcpy(out + x * 4, &pixel, 4);
+        }
+    }
+}
+
+std::optional<CaptureFormat> ParseCaptureFormat(std::string_view name) {
+    if (name == "rgba") {
+        return CaptureFormat::RGBA;
+    }
+    if (name == "png") {
+        return CaptureFormat::PNG;
+    }
+    if (name == "qoi") {
+        return CaptureFormat::QOI;
+    }
+    return std::nullopt;
+}
+
+const char* GetCaptureFormatMimeType(CaptureFormat format) {
+    switch (format) {
+    case CaptureFormat::PNG:
+        return "image/png";
+    case CaptureFormat::QOI:
+        return "image/qoi";
+    default:
+        return "application/octet-stream";
+    }
+}
+
+std::vector<u8> EncodeFrame(const CapturedFrame& frame, CaptureFormat format, int png_level) {
+    switch (format) {
+    case CaptureFormat::PNG:
+        return EncodePNG(frame, png_level);
+    case CaptureFormat::QOI:
+        return EncodeQOI(frame);
+    default:
+        return frame.pixels;
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,107 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/// A frame of the screens, in RGBA8 from the top row
+struct CapturedFrame {
+    u64 number = 0; ///< Number of the frame since the renderer started
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<u8> pixels;
+};
+
+enum class CaptureFormat {
+    RGBA, ///< The pixels as they are
+    PNG,
+    QOI, ///< Quite OK Image format, much faster to encode than PNG
+};
+
+/**
+ * Frames captured by the renderer for screenshots and streaming. The renderer reads the screens
+ * back asynchronously and stores them in a ring buffer shared with the readers, who get the frames
+ * without copying them or waiting for the renderer.
+ */
+class FrameCapture {
+public:
+    /// Called with the requested frame, or nullptr if the renderer stopped before capturing it
+    using FrameCallback = std::function<void(std::shared_ptr<const CapturedFrame>)>;
+
+    /// Number of frames kept for the readers
+    static constexpr std::size_t RING_SIZE = 4;
+
+    /// Requests a capture of the next frame, the callback is called by the renderer thread
+    void RequestFrame(FrameCallback callback);
+
+    /// Returns whether the renderer should capture the frame, called once per frame
+    bool ShouldCapture(u64 frame_number);
+
+    /// Stores a frame read back by the renderer, given in BGRA8 from the bottom row
+    void PushFrame(u64 frame_number, const u8* bgra, u32 width, u32 height);
+
+    /// Stores a frame composed in memory by the renderer, given in RGBA8 from the top row
+    void PushFrameRGBA(u64 frame_number, const u8* rgba, u32 width, u32 height);
+
+    /**
+     * Returns the newest frame with a number greater than after, waiting for one up to the
+     * timeout. Returns nullptr if there is none.
+     */
+    std::shared_ptr<const CapturedFrame> WaitForFrame(u64 after,
+                                                      std::chrono::milliseconds timeout);
+
+    /// Drops the frames and the requests, when the renderer stops
+    void Reset();
+
+private:
+    struct Request {
+        u64 first_frame; ///< Frames captured before the request are too old
+        FrameCallback callback;
+    };
+
+    /// Returns the oldest frame of the ring buffer to reuse, or a new one if a reader holds it
+    std::shared_ptr<CapturedFrame> AcquireFrame();
+
+    /// Stores the frame in the ring buffer and serves the requests it satisfies
+    void StoreFrame(std::shared_ptr<CapturedFrame> frame);
+
+    std::mutex mutex;
+    std::condition_variable frame_pushed;
+    std::array<std::shared_ptr<CapturedFrame>, RING_SIZE> ring;
+    std::size_t next_slot = 0;
+    std::vector<Request> requests;
+    u64 next_frame = 0;
+};
+
+/// Converts rows of BGRA8 pixels from the bottom to rows of RGBA8 pixels from the top
+void FlipAndSwizzleBGRA(const u8* source, u8* dest, u32 width, u32 height);
+
+/// Returns the format with the name ("rgba", "png" or "qoi")
+std::optional<CaptureFormat> ParseCaptureFormat(std::string_view name);
+
+/// Returns the MIME type of the format
+const char* GetCaptureFormatMimeType(CaptureFormat format);
+
+/// Lowest PNG compression level, stb_image_write uses it for the levels under it
+constexpr int MIN_PNG_LEVEL = 5;
+
+/**
+ * Encodes the frame, returns an empty vector on failure.
+ * @param png_level Compression level of stb_image_write for PNG, at least MIN_PNG_LEVEL
+ */
+std::vector<u8> EncodeFrame(const CapturedFrame& frame, CaptureFormat format, int png_level = 8);
+
+} // namespace VideoCore
@@ -0,0 +1,114 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "common/trace.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+GPUThread::GPUThread() : thread(&GPUThread::ThreadLoop, this) {}
+
+GPUThread::~GPUThread() {
+    // An empty command stops the thread once everything before it has run
+    queue.Push(QueuedCommand{});
+    thread.join();
+}
+
+u64 GPUThread::PushCommand(Command command) {
+    const u64 fence = ++last_fence;
+    queue.Push(QueuedCommand{std::move(command), fence});
+
+    // Running one command at a time tells missing sync points apart from other bugs
+    if (Settings::values.gpu_thread_sync_debug) {
+        WaitForFence(fence);
+    }
+
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (completed_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+
+    Common::Trace::Scope trace_scope("Wait for GPU thread");
+    std::unique_lock lock(fence_mutex);
+    fence_condition.wait(
+        lock, [&] { return completed_fence.load(std::memory_order_acquire) >= fence; });
+}
+
+void GPUThread::Synchronize(const char* reason) {
+    if (IsGPUThread() || completed_fence.load(std::memory_order_acquire) >= last_fence) {
+        return;
+    }
+
+    ++sync_points;
+
+    if (!Settings::values.gpu_thread_sync_debug) {
+        WaitForFence(last_fence);
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    WaitForFence(last_fence);
+    const std::chrono::duration<double, std::micro> waited = std::chrono::steady_clock::now() - start;
+    LOG_INFO(HW_GPU, "GPU thread sync point: {}, waited {:.0f} us", reason, waited.count());
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+void GPUThread::DeferInterrupt(Service::GSP::InterruptId interrupt_id) {
+    std::lock_guard lock(interrupt_mutex);
+    interrupts.emplace_back(current_fence, interrupt_id);
+}
+
+std::vector<Service::GSP::InterruptId> GPUThread::TakeInterrupts(u64 fence) {
+    std::vector<Service::GSP::InterruptId> raised;
+
+    std::lock_guard lock(interrupt_mutex);
+    const auto end = std::find_if(interrupts.begin(), interrupts.end(),
+                                  [fence](const auto& pair) { return pair.first > fence; });
+    for (auto it = interrupts.begin(); it != end; ++it) {
+        raised.push_back(it->second);
+    }
+    interrupts.erase(interrupts.begin(), end);
+
+    return raised;
+}
+
+u64 GPUThread::GetSyncPointCount() const {
+    return sync_points.load();
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPU");
+
+    while (true) {
+        QueuedCommand queued = queue.PopWait();
+        if (!queued.command) {
+            break;
+        }
+
+        current_fence = queued.fence;
+        {
+            Common::Trace::Scope trace_scope("GPU command");
+            queued.command();
+        }
+
+        {
+            std::lock_guard lock(fence_mutex);
+            completed_fence.store(queued.fence, std::memory_order_release);
+        }
+        fence_condition.notify_all();
+    }
+}
+
+} // namespace VideoCore
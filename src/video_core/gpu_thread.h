@@ -0,0 +1,83 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Service::GSP {
+enum class InterruptId : u8;
+} // namespace Service::GSP
+
+namespace VideoCore {
+
+/**
+ * Runs GPU commands (PICA command lists, memory fills, display transfers and texture copies) in
+ * order on a thread of its own, so the emulated CPU keeps running while the GPU works. The
+ * emulation thread waits for the queued commands at sync points, where the guest could observe
+ * their results.
+ */
+class GPUThread {
+public:
+    using Command = std::function<void()>;
+
+    GPUThread();
+    ~GPUThread();
+
+    /// Queues a command and returns its fence, which is reached once the command has run
+    u64 PushCommand(Command command);
+
+    /// Waits until the command with the given fence has run
+    void WaitForFence(u64 fence);
+
+    /**
+     * Waits until every queued command has run. Does nothing on the GPU thread itself.
+     * @param reason Why the guest may observe the results, logged in sync point debug mode
+     */
+    void Synchronize(const char* reason);
+
+    /// Returns whether the caller is running on the GPU thread
+    bool IsGPUThread() const;
+
+    /// Records an interrupt raised on the GPU thread by the running command
+    void DeferInterrupt(Service::GSP::InterruptId interrupt_id);
+
+    /// Returns the interrupts raised by the commands up to the given fence, which must be reached
+    std::vector<Service::GSP::InterruptId> TakeInterrupts(u64 fence);
+
+    /// Returns the number of times the emulation thread had to wait for the GPU thread
+    u64 GetSyncPointCount() const;
+
+private:
+    struct QueuedCommand {
+        Command command;
+        u64 fence = 0;
+    };
+
+    void ThreadLoop();
+
+    Common::SPSCQueue<QueuedCommand> queue;
+    u64 last_fence = 0;    ///< Only used by the emulation thread
+    u64 current_fence = 0; ///< Only used by the GPU thread
+    std::atomic<u64> completed_fence{0};
+    std::atomic<u64> sync_points{0};
+
+    std::mutex fence_mutex;
+    std::condition_variable fence_condition;
+
+    std::mutex interrupt_mutex;
+    std::vector<std::pair<u64, Service::GSP::InterruptId>> interrupts;
+
+    std::thread thread;
+};
+
+} // namespace VideoCore
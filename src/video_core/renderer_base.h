@@ -45,6 +45,10 @@ public:
         return rasterizer.get();
     }
 
+    bool IsOpenGLRasterizerActive() const {
+        return opengl_rasterizer_active;
+    }
+
     Frontend::EmuWindow& GetRenderWindow() {
         return render_window;
     }
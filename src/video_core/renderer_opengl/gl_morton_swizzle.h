@@ -0,0 +1,169 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstring>
+#include "common/common_types.h"
+#include "video_core/utils.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace OpenGL {
+
+namespace MortonSwizzle {
+
+#ifdef ARCHITECTURE_x86_64
+// In Morton order, the four texels starting at an even row and a multiple of 2 on the x axis form
+// a 2x2 block, so two rows are handled at once. These are the offsets of rows 0, 2, 4 and 6.
+constexpr u32 ROW_PAIR_OFFSETS[4]{0x00, 0x08, 0x20, 0x28};
+
+inline __m128i Load(const u8* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+inline void Store(u8* dest, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+}
+
+/// Converts D24S8 from the PICA's layout (stencil in the high byte) to OpenGL's and back
+template <bool morton_to_gl>
+inline __m128i RotateStencil(__m128i value) {
+    if (morton_to_gl) {
+        return _mm_or_si128(_mm_slli_epi32(value, 8), _mm_srli_epi32(value, 24));
+    }
+    return _mm_or_si128(_mm_srli_epi32(value, 8), _mm_slli_epi32(value, 24));
+}
+
+template <bool morton_to_gl, bool is_d24s8>
+inline void CopyTile32(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* tile = tile_buffer + ROW_PAIR_OFFSETS[y / 2] * 4;
+        u8* gl_row0 = gl_buffer + (7 - y) * stride * 4;
+        u8* gl_row1 = gl_buffer + (6 - y) * stride * 4;
+        if (morton_to_gl) {
+            // Each load holds the 2x2 blocks at x = 0, 2, 4 and 6 of the two rows
+            __m128i blocks[4]{Load(tile), Load(tile + 16), Load(tile + 64), Load(tile + 80)};
+            if (is_d24s8) {
+                for (__m128i& block : blocks) {
+                    block = RotateStencil<true>(block);
+                }
+            }
+            Store(gl_row0, _mm_unpacklo_epi64(blocks[0], blocks[1]));
+            Store(gl_row0 + 16, _mm_unpacklo_epi64(blocks[2], blocks[3]));
+            Store(gl_row1, _mm_unpackhi_epi64(blocks[0], blocks[1]));
+            Store(gl_row1 + 16, _mm_unpackhi_epi64(blocks[2], blocks[3]));
+        } else {
+            const __m128i row0_low = Load(gl_row0);
+            const __m128i row0_high = Load(gl_row0 + 16);
+            const __m128i row1_low = Load(gl_row1);
+            const __m128i row1_high = Load(gl_row1 + 16);
+            __m128i blocks[4]{
+                _mm_unpacklo_epi64(row0_low, row1_low), _mm_unpackhi_epi64(row0_low, row1_low),
+                _mm_unpacklo_epi64(row0_high, row1_high), _mm_unpackhi_epi64(row0_high, row1_high)};
+            if (is_d24s8) {
+                for (__m128i& block : blocks) {
+                    block = RotateStencil<false>(block);
+                }
+            }
+            Store(tile, blocks[0]);
+            Store(tile + 16, blocks[1]);
+            Store(tile + 64, blocks[2]);
+            Store(tile + 80, blocks[3]);
+        }
+    }
+}
+
+template <bool morton_to_gl>
+inline void CopyTile16(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* tile = tile_buffer + ROW_PAIR_OFFSETS[y / 2] * 2;
+        u8* gl_row0 = gl_buffer + (7 - y) * stride * 2;
+        u8* gl_row1 = gl_buffer + (6 - y) * stride * 2;
+        // A load holds two 2x2 blocks, as pairs of texels of row 0, row 1, row 0, row 1. Swapping
+        // the middle pairs groups them by row, and is its own inverse.
+        constexpr int GROUP_ROWS = _MM_SHUFFLE(3, 1, 2, 0);
+        if (morton_to_gl) {
+            const __m128i low = _mm_shuffle_epi32(Load(tile), GROUP_ROWS);
+            const __m128i high = _mm_shuffle_epi32(Load(tile + 32), GROUP_ROWS);
+            Store(gl_row0, _mm_unpacklo_epi64(low, high));
+            Store(gl_row1, _mm_unpackhi_epi64(low, high));
+        } else {
+            const __m128i row0 = Load(gl_row0);
+            const __m128i row1 = Load(gl_row1);
+            Store(tile, _mm_shuffle_epi32(_mm_unpacklo_epi64(row0, row1), GROUP_ROWS));
+            Store(tile + 32, _mm_shuffle_epi32(_mm_unpackhi_epi64(row0, row1), GROUP_ROWS));
+        }
+    }
+}
+#endif
+
+template <bool morton_to_gl, u32 bytes_per_pixel, u32 gl_bytes_per_pixel, bool is_d24s8>
+inline void CopyTileGeneric(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    for (u32 y = 0; y < 8; ++y) {
+        u8* gl_row = gl_buffer + (7 - y) * stride * gl_bytes_per_pixel;
+        // Horizontally adjacent pairs of texels starting at even x are adjacent in Morton order
+        for (u32 x = 0; x < 8; x += 2) {
+            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
+            u8* gl_ptr = gl_row + x * gl_bytes_per_pixel;
+            if (bytes_per_pixel == gl_bytes_per_pixel && !is_d24s8) {
+                if (morton_to_gl) {
+                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel * 2);
+                } else {
+                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel * 2);
+                }
+                continue;
+            }
+            for (u32 i = 0; i < 2; ++i) {
+                u8* tile_pixel = tile_ptr + i * bytes_per_pixel;
+                u8* gl_pixel = gl_ptr + i * gl_bytes_per_pixel;
+                if (morton_to_gl) {
+                    if (is_d24s8) {
+                        gl_pixel[0] = tile_pixel[3];
+                        std::memcpy(gl_pixel + 1, tile_pixel, 3);
+                    } else {
+                        std::memcpy(gl_pixel, tile_pixel, bytes_per_pixel);
+                    }
+                } else {
+                    if (is_d24s8) {
+                        std::memcpy(tile_pixel, gl_pixel + 1, 3);
+                        tile_pixel[3] = gl_pixel[0];
+                    } else {
+                        std::memcpy(tile_pixel, gl_pixel, bytes_per_pixel);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace MortonSwizzle
+
+/**
+ * Copies an 8x8 tile between the PICA's Morton order and OpenGL's linear layout.
+ * @param stride Width of the OpenGL buffer in pixels
+ * @param tile_buffer Pointer to the tile in Morton order
+ * @param gl_buffer Pointer to the bottom left pixel of the tile in the OpenGL buffer, whose rows
+ *                  go from bottom to top. Formats narrower than their OpenGL counterpart (D24)
+ *                  are copied to the highest bytes of each pixel, so the caller must offset it.
+ * @param is_d24s8 The stencil is moved from the highest byte to the lowest byte for OpenGL
+ */
+template <bool morton_to_gl, u32 bytes_per_pixel, u32 gl_bytes_per_pixel, bool is_d24s8>
+inline void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (bytes_per_pixel == 4 && gl_bytes_per_pixel == 4) {
+        MortonSwizzle::CopyTile32<morton_to_gl, is_d24s8>(stride, tile_buffer, gl_buffer);
+        return;
+    } else if constexpr (bytes_per_pixel == 2 && gl_bytes_per_pixel == 2) {
+        MortonSwizzle::CopyTile16<morton_to_gl>(stride, tile_buffer, gl_buffer);
+        return;
+    }
+#endif
+    MortonSwizzle::CopyTileGeneric<morton_to_gl, bytes_per_pixel, gl_bytes_per_pixel, is_d24s8>(
+        stride, tile_buffer, gl_buffer);
+}
+
+} // namespace OpenGL
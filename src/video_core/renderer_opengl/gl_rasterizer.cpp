@@ -136,6 +136,9 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
                           (GLvoid*)offsetof(HardwareVertex, view));
     glEnableVertexAttribArray(ATTRIBUTE_VIEW);
 
+    // Software shader triangles are drawn indexed, to share vertices
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
+
     // Create render framebuffer
     framebuffer.Create();
 
@@ -240,9 +243,82 @@ static bool AreQuaternionsOpposite(Common::Vec4<Pica::float24> qa, Common::Vec4<
 void RasterizerOpenGL::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                    const Pica::Shader::OutputVertex& v1,
                                    const Pica::Shader::OutputVertex& v2) {
-    vertex_batch.emplace_back(v0, false);
-    vertex_batch.emplace_back(v1, AreQuaternionsOpposite(v0.quat, v1.quat));
-    vertex_batch.emplace_back(v2, AreQuaternionsOpposite(v0.quat, v2.quat));
+    constexpr std::size_t max_vertices = VERTEX_STREAM_SIZE / sizeof(HardwareVertex);
+    constexpr std::size_t max_indices = INDEX_STREAM_SIZE / sizeof(u16);
+    static_assert(max_vertices <= 0x10000, "Vertex stream too large for u16 indices");
+
+    if (vertex_stream.active && (vertex_stream.num_vertices + 3 > max_vertices ||
+                                 vertex_stream.num_indices + 3 > max_indices)) {
+        DrawTriangles();
+    }
+    if (!vertex_stream.active) {
+        BeginVertexStream();
+    }
+
+    const std::array<const Pica::Shader::OutputVertex*, 3> vertices{&v0, &v1, &v2};
+    const std::array<bool, 3> flips{false, AreQuaternionsOpposite(v0.quat, v1.quat),
+                                    AreQuaternionsOpposite(v0.quat, v2.quat)};
+    std::array<u16, 3> indices;
+    for (std::size_t i = 0; i < 3; ++i) {
+        // Strips and fans share vertices with the previous triangle
+        const std::size_t num_previous = vertex_stream.num_indices != 0 ? 3 : 0;
+        std::size_t j = 0;
+        while (j < num_previous &&
+               (vertex_stream.last_flips[j] != flips[i] ||
+                std::memcmp(&vertex_stream.last_vertices[j], vertices[i],
+                            sizeof(Pica::Shader::OutputVertex)) != 0)) {
+            ++j;
+        }
+        if (j < num_previous) {
+            indices[i] = vertex_stream.last_indices[j];
+        } else {
+            indices[i] = static_cast<u16>(vertex_stream.num_vertices++);
+            vertex_stream.vertices[indices[i]] = HardwareVertex(*vertices[i], flips[i]);
+        }
+    }
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        vertex_stream.indices[vertex_stream.num_indices++] = indices[i];
+        vertex_stream.last_vertices[i] = *vertices[i];
+    }
+    vertex_stream.last_flips = flips;
+    vertex_stream.last_indices = indices;
+}
+
+void RasterizerOpenGL::AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                                    std::size_t num_triangles) {
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+        AddTriangle(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+    }
+}
+
+void RasterizerOpenGL::BeginVertexStream() {
+    state.draw.vertex_array = sw_vao.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.Apply();
+
+    u8* vertices;
+    u8* indices;
+    std::tie(vertices, vertex_stream.vertex_offset, std::ignore) =
+        vertex_buffer.Map(VERTEX_STREAM_SIZE, sizeof(HardwareVertex));
+    std::tie(indices, vertex_stream.index_offset, std::ignore) =
+        index_buffer.Map(INDEX_STREAM_SIZE, sizeof(u16));
+    vertex_stream.vertices = reinterpret_cast<HardwareVertex*>(vertices);
+    vertex_stream.indices = reinterpret_cast<u16*>(indices);
+    vertex_stream.num_vertices = 0;
+    vertex_stream.num_indices = 0;
+    vertex_stream.active = true;
+}
+
+void RasterizerOpenGL::EndVertexStream(bool commit) {
+    // The index buffer is bound through the VAO
+    state.draw.vertex_array = sw_vao.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.Apply();
+
+    vertex_buffer.Unmap(commit ? vertex_stream.num_vertices * sizeof(HardwareVertex) : 0);
+    index_buffer.Unmap(commit ? vertex_stream.num_indices * sizeof(u16) : 0);
+    vertex_stream.active = false;
 }
 
 static constexpr std::array<GLenum, 4> vs_attrib_types{
@@ -401,6 +477,11 @@ bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
         }
     }
 
+    // Software shader triangles that were never drawn are dropped
+    if (vertex_stream.active) {
+        EndVertexStream(false);
+    }
+
     return SetupVertexShader() && SetupGeometryShader() && Draw(true, is_indexed);
 }
 
@@ -469,7 +550,7 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
 }
 
 void RasterizerOpenGL::DrawTriangles() {
-    if (vertex_batch.empty()) {
+    if (!vertex_stream.active) {
         return;
     }
     Draw(false, false);
@@ -478,6 +559,14 @@ void RasterizerOpenGL::DrawTriangles() {
 bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     const Pica::Regs& regs = Pica::g_state.regs;
 
+    // The software shader triangles of a skipped draw are dropped, so that the stream buffers are
+    // unmapped whichever way the draw ends
+    SCOPE_EXIT({
+        if (vertex_stream.active) {
+            EndVertexStream(false);
+        }
+    });
+
     bool shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
                             Pica::FramebufferRegs::FragmentOperationMode::Shadow;
 
@@ -781,23 +870,20 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         shader_program_manager->ApplyTo(state);
         state.Apply();
 
-        std::size_t max_vertices = 3 * (VERTEX_BUFFER_SIZE / (3 * sizeof(HardwareVertex)));
-        for (std::size_t base_vertex = 0; base_vertex < vertex_batch.size();
-             base_vertex += max_vertices) {
-            std::size_t vertices = std::min(max_vertices, vertex_batch.size() - base_vertex);
-            std::size_t vertex_size = vertices * sizeof(HardwareVertex);
-            u8* vbo;
-            GLintptr offset;
-            std::tie(vbo, offset, std::ignore) =
-                vertex_buffer.Map(vertex_size, sizeof(HardwareVertex));
-            std::memcpy(vbo, vertex_batch.data() + base_vertex, vertex_size);
-            vertex_buffer.Unmap(vertex_size);
-            glDrawArrays(GL_TRIANGLES, offset / sizeof(HardwareVertex), (GLsizei)vertices);
+        const std::size_t num_vertices = vertex_stream.num_vertices;
+        const std::size_t num_indices = vertex_stream.num_indices;
+        const GLintptr index_offset = vertex_stream.index_offset;
+        const GLint base_vertex =
+            static_cast<GLint>(vertex_stream.vertex_offset / sizeof(HardwareVertex));
+        EndVertexStream(true);
+        if (num_indices != 0) {
+            glDrawRangeElementsBaseVertex(GL_TRIANGLES, 0, static_cast<GLuint>(num_vertices - 1),
+                                          static_cast<GLsizei>(num_indices), GL_UNSIGNED_SHORT,
+                                          reinterpret_cast<const void*>(index_offset),
+                                          base_vertex);
         }
     }
 
-    vertex_batch.clear();
-
     // Reset textures in rasterizer state context because the rasterizer cache might delete them
     for (unsigned texture_index = 0; texture_index < pica_textures.size(); ++texture_index) {
         state.texture_units[texture_index].texture_2d = 0;
@@ -47,6 +47,8 @@ public:
 
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
+    void AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                      std::size_t num_triangles) override;
     void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override;
@@ -239,6 +241,12 @@ private:
     /// Generic draw function for DrawTriangles and AccelerateDrawBatch
     bool Draw(bool accelerate, bool is_indexed);
 
+    /// Maps the vertex and index buffers to write the triangles of the software shader path into
+    void BeginVertexStream();
+
+    /// Unmaps the vertex and index buffers, keeping the written triangles if commit is true
+    void EndVertexStream(bool commit);
+
     /// Internal implementation for AccelerateDrawBatch
     bool AccelerateDrawBatchInternal(bool is_indexed);
 
@@ -270,7 +278,20 @@ private:
 
     Frontend::EmuWindow& emu_window;
 
-    std::vector<HardwareVertex> vertex_batch;
+    /// Triangles of the software shader path, written directly into the mapped vertex and index
+    /// buffers. A vertex shared with the previous triangle is only written once.
+    struct {
+        bool active = false;
+        HardwareVertex* vertices = nullptr;
+        GLintptr vertex_offset = 0;
+        std::size_t num_vertices = 0;
+        u16* indices = nullptr;
+        GLintptr index_offset = 0;
+        std::size_t num_indices = 0;
+        std::array<Pica::Shader::OutputVertex, 3> last_vertices;
+        std::array<bool, 3> last_flips{};
+        std::array<u16, 3> last_indices{};
+    } vertex_stream;
 
     bool shader_dirty;
 
@@ -295,6 +316,10 @@ private:
     static constexpr std::size_t UNIFORM_BUFFER_SIZE = 2 * 1024 * 1024;
     static constexpr std::size_t TEXTURE_BUFFER_SIZE = 1 * 1024 * 1024;
 
+    // Space reserved for the triangles of one software shader draw, small enough for u16 indices
+    static constexpr std::size_t VERTEX_STREAM_SIZE = VERTEX_BUFFER_SIZE / 4;
+    static constexpr std::size_t INDEX_STREAM_SIZE = INDEX_BUFFER_SIZE / 4;
+
     OGLVertexArray sw_vao; // VAO for software shader draw
     OGLVertexArray hw_vao; // VAO for hardware shader / accelerate draw
     std::array<bool, 16> hw_vao_enabled_attributes{};
@@ -12,17 +12,18 @@
 #include <unordered_set>
 #include <utility>
 #include <vector>
+#include <boost/container/small_vector.hpp>
 #include <boost/range/iterator_range.hpp>
 #include <glad/glad.h>
 #include "common/alignment.h"
 #include "common/bit_field.h"
 #include "common/color.h"
+#include "common/fast_hash.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/scope_exit.h"
-#include "common/stb_image.h"
-#include "common/stb_image_write.h"
-#include "common/texture.h"
+#include "common/trace.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/custom_tex_cache.h"
@@ -32,8 +33,10 @@
 #include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_morton_swizzle.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_manager.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
@@ -58,6 +61,9 @@ static constexpr std::array<FormatTuple, 4> depth_format_tuples = {{
     {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8}, // D24S8
 }};
 
+/// Size of the memory chunks hashed separately by incremental texture hashing
+static constexpr u32 TEXTURE_HASH_CHUNK_SIZE = Memory::PAGE_SIZE;
+
 const FormatTuple& GetFormatTuple(PixelFormat pixel_format) {
     const SurfaceType type = SurfaceParams::GetFormatType(pixel_format);
     if (type == SurfaceType::Color) {
@@ -75,97 +81,11 @@ const FormatTuple& GetFormatTuple(PixelFormat pixel_format) {
  * Hack: obtain the pixels by attaching the texture to a framebuffer.
  * Originally from https://github.com/apitrace/apitrace/blob/master/retrace/glstate_images.cpp
  */
-static inline void GetTexImage(GLenum target, GLint level, GLenum format, GLenum type, GLint height,
-                               GLint width, GLint depth, GLubyte* pixels, GLuint size) {
-    std::memset(pixels, 0x80, size);
-
-    OpenGLState cur_state = OpenGLState::GetCurState();
-    OpenGLState state;
-
-    GLenum texture_binding = GL_NONE;
-    switch (target) {
-    case GL_TEXTURE_2D:
-        texture_binding = GL_TEXTURE_BINDING_2D;
-        break;
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
-        texture_binding = GL_TEXTURE_BINDING_CUBE_MAP;
-        break;
-    default:
-        return;
-    }
-
-    GLint texture = 0;
-    glGetIntegerv(texture_binding, &texture);
-    if (!texture) {
-        return;
-    }
-
-    OGLFramebuffer fbo;
-    fbo.Create();
-    state.draw.read_framebuffer = fbo.handle;
-    state.Apply();
-
-    switch (target) {
-    case GL_TEXTURE_2D:
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
-    case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
-    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z: {
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture,
-                               level);
-        GLenum status = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            LOG_DEBUG(Render_OpenGL, "Framebuffer is incomplete, status: {:X}", status);
-        }
-        glReadPixels(0, 0, width, height, format, type, pixels);
-        break;
-    }
-    }
-
-    cur_state.Apply();
-
-    fbo.Release();
-}
-
 template <typename Map, typename Interval>
 constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
-template <bool morton_to_gl, PixelFormat format>
-static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
-    constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if (morton_to_gl) {
-                if (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
-            }
-        }
-    }
-}
-
 template <bool morton_to_gl, PixelFormat format>
 static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end) {
     constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
@@ -173,6 +93,8 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
     static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
+    constexpr auto copy_tile = MortonCopyTile<morton_to_gl, bytes_per_pixel, gl_bytes_per_pixel,
+                                              format == PixelFormat::D24S8>;
     gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
 
     const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
@@ -200,7 +122,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     if (start < aligned_start && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
         std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
                     std::min(aligned_start, end) - start);
 
@@ -218,7 +140,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
             LOG_ERROR(Render_OpenGL, "Out of bound texture");
             break;
         }
-        MortonCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
+        copy_tile(stride, tile_buffer, gl_buffer);
         tile_buffer += tile_size;
         current_paddr += tile_size;
         glbuf_next_tile();
@@ -226,7 +148,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
         std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
     }
 }
@@ -576,6 +498,18 @@ bool SurfaceParams::CanTexCopy(const SurfaceParams& texcopy_params) const {
     return FromInterval(texcopy_params.GetInterval()).GetInterval() == texcopy_params.GetInterval();
 }
 
+std::size_t CachedSurface::GetTextureMemorySize() const {
+    if (type == SurfaceType::Fill) {
+        return 0;
+    }
+    // Custom textures replace the texture of the surface when it isn't scaled
+    const std::size_t size =
+        is_custom && res_scale == 1
+            ? std::size_t{custom_tex_width} * custom_tex_height * 4
+            : std::size_t{GetScaledWidth()} * GetScaledHeight() * GetGLBytesPerPixel(pixel_format);
+    return max_level == 0 ? size : size + size / 3;
+}
+
 bool CachedSurface::CanFill(const SurfaceParams& dest_surface,
                             SurfaceInterval fill_interval) const {
     if (type == SurfaceType::Fill && IsRegionValid(fill_interval) &&
@@ -730,13 +664,19 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
+            // Decode the tile rows covering the rect, then copy it with the rows flipped for GL
+            const u32 first_row = Common::AlignDown(height - rect.top, 8);
+            const u32 end_row = Common::AlignUp(height - rect.bottom, 8);
+            std::vector<u8> decoded(width * (end_row - first_row) * 4);
+            Pica::Texture::DecodeTexture(texture_src_data + (first_row / 8) * tex_info.stride,
+                                         decoded.data(), width, end_row - first_row,
+                                         tex_info.format);
+
             for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
-                }
+                const std::size_t src_offset =
+                    ((height - 1 - y - first_row) * width + rect.left) * 4;
+                const std::size_t offset = (rect.left + (width * y)) * 4;
+                std::memcpy(&gl_buffer[offset], &decoded[src_offset], (rect.right - rect.left) * 4);
             }
         } else {
             morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
@@ -790,41 +730,14 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
     }
 }
 
-bool CachedSurface::LoadCustomTexture(u64 tex_hash, Core::CustomTexInfo& tex_info) {
-    bool result = false;
+std::shared_ptr<const Core::CustomTexInfo> CachedSurface::LoadCustomTexture(u64 tex_hash) {
     Core::CustomTexCache& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-
-    if (custom_tex_cache.IsTextureCached(tex_hash)) {
-        tex_info = custom_tex_cache.LookupTexture(tex_hash);
-        result = true;
-    } else if (custom_tex_cache.CustomTextureExists(tex_hash)) {
-        const Core::CustomTexPathInfo& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-        unsigned char* image =
-            stbi_load(path_info.path.c_str(), reinterpret_cast<int*>(&tex_info.width),
-                      reinterpret_cast<int*>(&tex_info.height), nullptr, 4);
-        if (image != nullptr) {
-            tex_info.tex.resize(tex_info.width * tex_info.height * 4);
-            std::memcpy(tex_info.tex.data(), image, tex_info.tex.size());
-            free(image);
-
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                custom_tex_cache.CacheTexture(path_info.hash, tex_info.tex, tex_info.width,
-                                              tex_info.height);
-                result = true;
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-            }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
-        }
+    auto tex_info = custom_tex_cache.LookupTexture(tex_hash);
+    if (tex_info == nullptr && custom_tex_cache.CustomTextureExists(tex_hash)) {
+        // The original texture is used until the custom one is decoded
+        pending_custom_tex_hash = tex_hash;
     }
-
-    return result;
+    return tex_info;
 }
 
 void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
@@ -841,36 +754,27 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
     dump_path += fmt::format("tex1_{}x{}_{:016X}_{}.png", width, height, tex_hash,
                              static_cast<u32>(pixel_format));
     if (!custom_tex_cache.IsTextureDumped(tex_hash) && !FileUtil::Exists(dump_path)) {
-        custom_tex_cache.SetTextureDumped(tex_hash);
-
-        LOG_INFO(Render_OpenGL, "Dumping texture to {}", dump_path);
-        std::vector<u8> decoded_texture;
-        decoded_texture.resize(width * height * 4);
-        glBindTexture(GL_TEXTURE_2D, target_tex);
         /*
-           GetTexImage is used to work around a small issue that
-           happens if using custom textures with texture dumping at the same.
+           Only the width x height region of the texture is dumped to work around a small issue
+           that happens if using custom textures with texture dumping at the same.
            Let's say there's 2 textures that are both 32x32 and one of them gets replaced with a
            higher quality 256x256 texture. If the 256x256 texture is displayed first and the 32x32
            texture gets uploaded to the same underlying OpenGL texture, the 32x32 texture will
            appear in the corner of the 256x256 texture.
            If texture dumping is enabled and the 32x32 is undumped, vvctre will attempt to dump it.
-           Since the underlying OpenGL texture is still 256x256, vvctre crashes because it thinks
-           the texture is only 32x32. GetTexImage conveniently only dumps the specified region.
+           Since the underlying OpenGL texture is still 256x256, vvctre would crash if it dumped
+           the whole texture, thinking the texture is only 32x32.
         */
-        GetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, height, width, 0,
-                    &decoded_texture[0], decoded_texture.size());
-        glBindTexture(GL_TEXTURE_2D, 0);
-        Common::FlipRGBA8Texture(decoded_texture, width, height);
-        if (stbi_write_png(dump_path.c_str(), static_cast<int>(width), static_cast<int>(height), 4,
-                           decoded_texture.data(), static_cast<int>(width) * 4) == 0) {
-            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
+        if (TextureDumper::GetInstance().Dump(target_tex, width, height, dump_path)) {
+            // Dumps refused because too many are queued are retried the next time
+            custom_tex_cache.SetTextureDumped(tex_hash);
+            LOG_INFO(Render_OpenGL, "Dumping texture to {}", dump_path);
         }
     }
 }
 
 void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle,
-                                    GLuint draw_fb_handle) {
+                                    GLuint draw_fb_handle, u64 tex_hash) {
     if (type == SurfaceType::Fill) {
         return;
     }
@@ -878,14 +782,16 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
     ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
 
     std::string dump_path; // Has to be declared here for logging later
-    u64 tex_hash = 0;
-
-    if (Settings::values.dump_textures || Settings::values.custom_textures) {
-        tex_hash = Common::ComputeHash64(gl_buffer.data(), gl_buffer.size());
-    }
 
+    std::shared_ptr<const Core::CustomTexInfo> custom_tex_info;
+    pending_custom_tex_hash.reset();
     if (Settings::values.custom_textures) {
-        is_custom = LoadCustomTexture(tex_hash, custom_tex_info);
+        custom_tex_info = LoadCustomTexture(tex_hash);
+        is_custom = custom_tex_info != nullptr;
+    }
+    if (is_custom) {
+        custom_tex_width = custom_tex_info->width;
+        custom_tex_height = custom_tex_info->height;
     }
 
     TextureFilterInterface* const texture_filter =
@@ -910,7 +816,7 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
         unscaled_tex.Create();
         if (is_custom) {
             AllocateSurfaceTexture(unscaled_tex.handle, GetFormatTuple(PixelFormat::RGBA8),
-                                   custom_tex_info.width, custom_tex_info.height);
+                                   custom_tex_width, custom_tex_height);
         } else {
             AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth() * default_scale,
                                    rect.GetHeight() * default_scale);
@@ -929,17 +835,17 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
     if (is_custom) {
         if (res_scale == 1) {
             AllocateSurfaceTexture(texture.handle, GetFormatTuple(PixelFormat::RGBA8),
-                                   custom_tex_info.width, custom_tex_info.height);
+                                   custom_tex_width, custom_tex_height);
             cur_state.texture_units[0].texture_2d = texture.handle;
             cur_state.Apply();
         }
 
         // Always going to be using RGBA8
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(custom_tex_info.width));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(custom_tex_width));
 
         glActiveTexture(GL_TEXTURE0);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, custom_tex_info.width, custom_tex_info.height,
-                        GL_RGBA, GL_UNSIGNED_BYTE, custom_tex_info.tex.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, custom_tex_width, custom_tex_height, GL_RGBA,
+                        GL_UNSIGNED_BYTE, custom_tex_info->tex.data());
     } else if (texture_filter) {
         if (res_scale == default_scale) {
             AllocateSurfaceTexture(texture.handle, GetFormatTuple(pixel_format),
@@ -975,7 +881,7 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
         auto from_rect =
-            is_custom ? Common::Rectangle<u32>{0, custom_tex_info.height, custom_tex_info.width, 0}
+            is_custom ? Common::Rectangle<u32>{0, custom_tex_height, custom_tex_width, 0}
                       : Common::Rectangle<u32>{0, rect.GetHeight(), rect.GetWidth(), 0};
         BlitTextures(unscaled_tex.handle, from_rect, texture.handle, scaled_rect, type,
                      read_fb_handle, draw_fb_handle);
@@ -1079,81 +985,79 @@ Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params
     u32 match_scale = 0;
     SurfaceInterval match_interval{};
 
-    for (auto& pair : RangeFromInterval(surface_cache, params.GetInterval())) {
-        for (auto& surface : pair.second) {
-            bool res_scale_matched = match_scale_type == ScaleMatch::Exact
-                                         ? (params.res_scale == surface->res_scale)
-                                         : (params.res_scale <= surface->res_scale);
-            // validity will be checked in GetCopyableInterval
-            bool is_valid =
-                find_flags & MatchFlags::Copy
-                    ? true
-                    : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
-
-            if (!(find_flags & MatchFlags::Invalid) && !is_valid)
-                continue;
+    for (auto& surface : surface_cache.GetOverlapping(params.addr, params.end)) {
+        bool res_scale_matched = match_scale_type == ScaleMatch::Exact
+                                     ? (params.res_scale == surface->res_scale)
+                                     : (params.res_scale <= surface->res_scale);
+        // validity will be checked in GetCopyableInterval
+        bool is_valid =
+            find_flags & MatchFlags::Copy
+                ? true
+                : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
+
+        if (!(find_flags & MatchFlags::Invalid) && !is_valid)
+            continue;
 
-            auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
-                if (!(find_flags & check_type))
-                    return;
-
-                bool matched;
-                SurfaceInterval surface_interval;
-                std::tie(matched, surface_interval) = match_fn();
-                if (!matched)
-                    return;
-
-                if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
-                    surface->type != SurfaceType::Fill)
-                    return;
-
-                // Found a match, update only if this is better than the previous one
-                auto UpdateMatch = [&] {
-                    match_surface = surface;
-                    match_valid = is_valid;
-                    match_scale = surface->res_scale;
-                    match_interval = surface_interval;
-                };
-
-                if (surface->res_scale > match_scale) {
-                    UpdateMatch();
-                    return;
-                } else if (surface->res_scale < match_scale) {
-                    return;
-                }
+        auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
+            if (!(find_flags & check_type))
+                return;
+
+            bool matched;
+            SurfaceInterval surface_interval;
+            std::tie(matched, surface_interval) = match_fn();
+            if (!matched)
+                return;
+
+            if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
+                surface->type != SurfaceType::Fill)
+                return;
+
+            // Found a match, update only if this is better than the previous one
+            auto UpdateMatch = [&] {
+                match_surface = surface;
+                match_valid = is_valid;
+                match_scale = surface->res_scale;
+                match_interval = surface_interval;
+            };
 
-                if (is_valid && !match_valid) {
-                    UpdateMatch();
-                    return;
-                } else if (is_valid != match_valid) {
-                    return;
-                }
+            if (surface->res_scale > match_scale) {
+                UpdateMatch();
+                return;
+            } else if (surface->res_scale < match_scale) {
+                return;
+            }
 
-                if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
-                    UpdateMatch();
-                }
-            };
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
-                return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
-                return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
-                ASSERT(validate_interval);
-                auto copy_interval =
-                    params.FromInterval(*validate_interval).GetCopyableInterval(surface);
-                bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
-                               surface->CanCopy(params, copy_interval);
-                return std::make_pair(matched, copy_interval);
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
-                return std::make_pair(surface->CanExpand(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
-                return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
-            });
-        }
+            if (is_valid && !match_valid) {
+                UpdateMatch();
+                return;
+            } else if (is_valid != match_valid) {
+                return;
+            }
+
+            if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
+                UpdateMatch();
+            }
+        };
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
+            return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
+            return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
+            ASSERT(validate_interval);
+            auto copy_interval =
+                params.FromInterval(*validate_interval).GetCopyableInterval(surface);
+            bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
+                           surface->CanCopy(params, copy_interval);
+            return std::make_pair(matched, copy_interval);
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
+            return std::make_pair(surface->CanExpand(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
+            return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
+        });
     }
     return match_surface;
 }
@@ -1212,8 +1116,8 @@ void main() {
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
-    while (!surface_cache.empty())
-        UnregisterSurface(*surface_cache.begin()->second.begin());
+    while (!surface_cache.Empty())
+        UnregisterSurface(surface_cache.Front());
 }
 
 bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
@@ -1461,6 +1365,18 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
     if (!surface)
         return nullptr;
 
+    // Replace the original texture once its custom texture finished loading
+    if (surface->pending_custom_tex_hash &&
+        Core::System::GetInstance().CustomTexCache().IsTextureCached(
+            *surface->pending_custom_tex_hash)) {
+        FlushRegion(surface->addr, surface->size);
+        surface->LoadGLBuffer(surface->addr, surface->end);
+        surface->UploadGLTexture(surface->GetSubRect(*surface), read_framebuffer.handle,
+                                 draw_framebuffer.handle, GetTextureHash(surface));
+        // The new texture only has its base level
+        surface->max_level = 0;
+    }
+
     // Update mipmap if necessary
     if (max_level != 0) {
         if (max_level >= 8) {
@@ -1483,8 +1399,8 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
             u32 width;
             u32 height;
             if (surface->is_custom) {
-                width = surface->custom_tex_info.width;
-                height = surface->custom_tex_info.height;
+                width = surface->custom_tex_width;
+                height = surface->custom_tex_height;
             } else {
                 width = surface->GetScaledWidth();
                 height = surface->GetScaledHeight();
@@ -1594,6 +1510,7 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
         }
     }
 
+    u32 scaled_size = cube.res_scale * config.width;
     if (cube.texture.handle == 0) {
         for (const Face& face : faces) {
             if (face.watcher) {
@@ -1601,15 +1518,18 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
                 cube.res_scale = std::max(cube.res_scale, surface->res_scale);
             }
         }
+        scaled_size = cube.res_scale * config.width;
 
         cube.texture.Create();
         AllocateTextureCube(
             cube.texture.handle,
             GetFormatTuple(CachedSurface::PixelFormatFromTextureFormat(config.format)),
-            cube.res_scale * config.width);
+            scaled_size);
+        cube.memory_size = std::size_t{6} * scaled_size * scaled_size * 4;
+        cubes_memory_size += cube.memory_size;
+        UpdateMemoryStats();
     }
-
-    u32 scaled_size = cube.res_scale * config.width;
+    cube.last_used = ++cube_use_count;
 
     OpenGLState prev_state = OpenGLState::GetCurState();
     SCOPE_EXIT({ prev_state.Apply(); });
@@ -1659,11 +1579,15 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
         TextureFilterManager::GetInstance().Reset();
         resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
         FlushAll();
-        while (!surface_cache.empty())
-            UnregisterSurface(*surface_cache.begin()->second.begin());
+        while (!surface_cache.Empty())
+            UnregisterSurface(surface_cache.Front());
         texture_cube_cache.clear();
+        cubes_memory_size = 0;
     }
 
+    // Surfaces of the previous draws aren't in use anymore
+    EvictSurfaces();
+
     Common::Rectangle<u32> viewport_clamped{
         static_cast<u32>(std::clamp(viewport_rect.left, 0, static_cast<s32>(config.GetWidth()))),
         static_cast<u32>(std::clamp(viewport_rect.top, 0, static_cast<s32>(config.GetHeight()))),
@@ -1814,8 +1738,11 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
     if (size == 0)
         return;
 
+    Common::Trace::Scope trace_scope("Validate surface");
     const SurfaceInterval validate_interval(addr, addr + size);
 
+    TouchSurface(surface);
+
     if (surface->type == SurfaceType::Fill) {
         // Sanity check, fill surfaces will always be valid when used
         ASSERT(surface->IsRegionValid(validate_interval));
@@ -1878,7 +1805,7 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
         FlushRegion(params.addr, params.size);
         surface->LoadGLBuffer(params.addr, params.end);
         surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                 draw_framebuffer.handle);
+                                 draw_framebuffer.handle, GetTextureHash(surface));
         surface->invalid_regions.erase(params.GetInterval());
     }
 }
@@ -1887,6 +1814,7 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
     if (size == 0)
         return;
 
+    Common::Trace::Scope trace_scope("Flush surfaces");
     const SurfaceInterval flush_interval(addr, addr + size);
     SurfaceRegions flushed_intervals;
 
@@ -1909,6 +1837,7 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
                                        draw_framebuffer.handle);
         }
         surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
+        InvalidateChunkHashes(boost::icl::first(interval), boost::icl::length(interval));
         flushed_intervals += interval;
     }
     // Reset dirty regions
@@ -1924,6 +1853,7 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         return;
 
     const SurfaceInterval invalid_interval(addr, addr + size);
+    InvalidateChunkHashes(addr, size);
 
     if (region_owner != nullptr) {
         ASSERT(region_owner->type != SurfaceType::Texture);
@@ -1933,28 +1863,26 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         region_owner->invalid_regions.erase(invalid_interval);
     }
 
-    for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
-        for (auto& cached_surface : pair.second) {
-            if (cached_surface == region_owner)
-                continue;
+    for (auto& cached_surface : surface_cache.GetOverlapping(addr, addr + size)) {
+        if (cached_surface == region_owner)
+            continue;
 
-            // If cpu is invalidating this region we want to remove it
-            // to (likely) mark the memory pages as uncached
-            if (region_owner == nullptr && size <= 8) {
-                FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
-                remove_surfaces.emplace(cached_surface);
-                continue;
-            }
+        // If cpu is invalidating this region we want to remove it
+        // to (likely) mark the memory pages as uncached
+        if (region_owner == nullptr && size <= 8) {
+            FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
+            remove_surfaces.emplace(cached_surface);
+            continue;
+        }
 
-            const auto interval = cached_surface->GetInterval() & invalid_interval;
-            cached_surface->invalid_regions.insert(interval);
-            cached_surface->InvalidateAllWatcher();
+        const auto interval = cached_surface->GetInterval() & invalid_interval;
+        cached_surface->invalid_regions.insert(interval);
+        cached_surface->InvalidateAllWatcher();
 
-            // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
-            if (cached_surface->type == SurfaceType::Fill &&
-                cached_surface->IsSurfaceFullyInvalid()) {
-                remove_surfaces.emplace(cached_surface);
-            }
+        // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
+        if (cached_surface->type == SurfaceType::Fill &&
+            cached_surface->IsSurfaceFullyInvalid()) {
+            remove_surfaces.emplace(cached_surface);
         }
     }
 
@@ -2000,8 +1928,12 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = true;
-    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Add(surface);
     UpdatePagesCachedCount(surface->addr, surface->size, 1);
+    surface->lru_position = lru_surfaces.insert(lru_surfaces.begin(), surface);
+    surface->memory_size = surface->GetTextureMemorySize();
+    surfaces_memory_size += surface->memory_size;
+    UpdateMemoryStats();
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -2010,41 +1942,109 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
     }
     surface->registered = false;
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
-    surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Remove(surface);
+    surfaces_memory_size -= surface->memory_size;
+    UpdateMemoryStats();
+    // Last, as the list can hold the last reference to the surface
+    lru_surfaces.erase(surface->lru_position);
 }
 
 void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
-    const u32 num_pages =
-        ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
-    const u32 page_start = addr >> Memory::PAGE_BITS;
-    const u32 page_end = page_start + num_pages;
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0)
-        cached_pages.add({pages_interval, delta});
-
-    for (auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            true);
-        else if (delta < 0 && count == -delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            false);
-        else
-            ASSERT(count >= 0);
-    }
-
-    if (delta < 0)
-        cached_pages.add({pages_interval, delta});
+    surface_cache.UpdateCachedCount(addr, size, delta, [this](PAddr start, u32 size, bool cached) {
+        VideoCore::g_memory->RasterizerMarkRegionCached(start, size, cached);
+        if (!cached) {
+            InvalidateChunkHashes(start, size);
+        }
+    });
+}
+
+void RasterizerCacheOpenGL::TouchSurface(const Surface& surface) {
+    if (!surface->registered) {
+        return;
+    }
+    lru_surfaces.splice(lru_surfaces.begin(), lru_surfaces, surface->lru_position);
+    // Custom textures and mipmaps change the size of the texture after registration
+    const std::size_t memory_size = surface->GetTextureMemorySize();
+    if (memory_size != surface->memory_size) {
+        surfaces_memory_size += memory_size - surface->memory_size;
+        surface->memory_size = memory_size;
+        UpdateMemoryStats();
+    }
+}
+
+void RasterizerCacheOpenGL::EvictSurfaces() {
+    const std::size_t budget = std::size_t{Settings::values.surface_cache_memory_budget} << 20;
+    if (budget == 0) {
+        return;
+    }
+    while (surfaces_memory_size + cubes_memory_size > budget && !lru_surfaces.empty()) {
+        const Surface surface = lru_surfaces.back();
+        // Write back what only the surface has, so it can be loaded from memory again
+        FlushRegion(surface->addr, surface->size, surface);
+        UnregisterSurface(surface);
+        ++VideoCore::g_surface_cache_evictions;
+    }
+    while (surfaces_memory_size + cubes_memory_size > budget && !texture_cube_cache.empty()) {
+        const auto cube = std::min_element(
+            texture_cube_cache.begin(), texture_cube_cache.end(),
+            [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        cubes_memory_size -= cube->second.memory_size;
+        texture_cube_cache.erase(cube);
+        ++VideoCore::g_surface_cache_evictions;
+    }
+    UpdateMemoryStats();
+}
+
+u64 RasterizerCacheOpenGL::GetTextureHash(const Surface& surface) {
+    if (surface->type == SurfaceType::Fill ||
+        (!Settings::values.dump_textures && !Settings::values.custom_textures)) {
+        return 0;
+    }
+
+    const bool fast = Settings::values.fast_texture_hash;
+    const auto hash = fast ? Common::ComputeFastHash64 : Common::ComputeHash64;
+    const u8* const data = VideoCore::g_memory->GetPhysicalPointer(surface->addr);
+    if (!Settings::values.incremental_texture_hash || data == nullptr) {
+        return hash(surface->gl_buffer.data(), surface->gl_buffer.size());
+    }
+
+    if (fast != chunk_hashes_fast) {
+        chunk_hashes.clear();
+        chunk_hashes_fast = fast;
+    }
+
+    // The chunks start at the surface address, so a texture has the same hash wherever it is
+    boost::container::small_vector<u64, 64> hashes;
+    for (PAddr chunk = surface->addr; chunk < surface->end; chunk += TEXTURE_HASH_CHUNK_SIZE) {
+        const u32 size = std::min(TEXTURE_HASH_CHUNK_SIZE, surface->end - chunk);
+        const u8* const chunk_data = data + (chunk - surface->addr);
+        if (surface_cache.GetCachedCount(chunk) == 0 ||
+            surface_cache.GetCachedCount(chunk + size - 1) == 0) {
+            hashes.push_back(hash(chunk_data, size));
+            continue;
+        }
+        const auto [iter, inserted] = chunk_hashes.try_emplace(chunk);
+        if (inserted || iter->second.size != size) {
+            iter->second = {size, hash(chunk_data, size)};
+        }
+        hashes.push_back(iter->second.hash);
+    }
+    return Common::ComputeHash64(hashes.data(), hashes.size() * sizeof(u64));
+}
+
+void RasterizerCacheOpenGL::InvalidateChunkHashes(PAddr addr, u32 size) {
+    if (chunk_hashes.empty()) {
+        return;
+    }
+    // Chunks starting before the region can overlap it
+    const PAddr start = addr < TEXTURE_HASH_CHUNK_SIZE ? 0 : addr - TEXTURE_HASH_CHUNK_SIZE + 1;
+    chunk_hashes.erase(chunk_hashes.lower_bound(start), chunk_hashes.lower_bound(addr + size));
+}
+
+void RasterizerCacheOpenGL::UpdateMemoryStats() {
+    VideoCore::g_surface_cache_memory_used = surfaces_memory_size + cubes_memory_size;
+    Common::Trace::Counter("Surface cache memory",
+                           static_cast<s64>(surfaces_memory_size + cubes_memory_size));
 }
 
 } // namespace OpenGL
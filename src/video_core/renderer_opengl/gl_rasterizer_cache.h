@@ -6,7 +6,9 @@
 
 #include <array>
 #include <list>
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <tuple>
 #ifdef __GNUC__
@@ -30,6 +32,7 @@
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_surface_page_index.h"
 #include "video_core/texture/texture_decode.h"
 
 namespace OpenGL {
@@ -85,19 +88,14 @@ using SurfaceRegions = boost::icl::interval_set<PAddr, std::less, SurfaceInterva
 using SurfaceMap =
     boost::icl::interval_map<PAddr, Surface, boost::icl::partial_absorber, std::less,
                              boost::icl::inplace_plus, boost::icl::inter_section, SurfaceInterval>;
-using SurfaceCache =
-    boost::icl::interval_map<PAddr, SurfaceSet, boost::icl::partial_absorber, std::less,
-                             boost::icl::inplace_plus, boost::icl::inter_section, SurfaceInterval>;
+using SurfaceCache = SurfacePageIndex<Surface>;
 
-static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval_type>() &&
-                  std::is_same<SurfaceMap::interval_type, SurfaceCache::interval_type>(),
+static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceMap::interval_type>(),
               "incorrect interval types");
 
 using SurfaceRect_Tuple = std::tuple<Surface, Common::Rectangle<u32>>;
 using SurfaceSurfaceRect_Tuple = std::tuple<Surface, Surface, Common::Rectangle<u32>>;
 
-using PageMap = boost::icl::interval_map<u32, int>;
-
 enum class ScaleMatch {
     Exact,   // only accept same res scale
     Upscale, // only allow higher scale than params
@@ -357,6 +355,10 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     }
 
     bool registered = false;
+    /// Position in the least recently used list of the cache, while registered
+    std::list<Surface>::iterator lru_position;
+    /// Texture memory accounted for the surface while registered
+    std::size_t memory_size = 0;
     SurfaceRegions invalid_regions;
 
     u32 fill_size = 0; /// Number of bytes to read from fill_data
@@ -371,7 +373,13 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
 
     bool is_custom = false;
     bool is_filtered = false;
-    Core::CustomTexInfo custom_tex_info;
+    u32 custom_tex_width = 0;
+    u32 custom_tex_height = 0;
+    /// Custom texture loading in the background, uploaded instead of the original one when ready
+    std::optional<u64> pending_custom_tex_hash;
+
+    /// Returns the memory used by the texture of the surface, including its mipmaps
+    std::size_t GetTextureMemorySize() const;
 
     static constexpr unsigned int GetGLBytesPerPixel(PixelFormat format) {
         // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
@@ -389,11 +397,13 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     void FlushGLBuffer(PAddr flush_start, PAddr flush_end);
 
     // Custom texture loading and dumping
-    bool LoadCustomTexture(u64 tex_hash, Core::CustomTexInfo& tex_info);
+    std::shared_ptr<const Core::CustomTexInfo> LoadCustomTexture(u64 tex_hash);
     void DumpTexture(GLuint target_tex, u64 tex_hash);
 
-    // Upload/Download data in gl_buffer in/to this surface's texture
-    void UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle, GLuint draw_fb_handle);
+    // Upload/Download data in gl_buffer in/to this surface's texture, tex_hash is used to dump and
+    // replace the texture
+    void UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle, GLuint draw_fb_handle,
+                         u64 tex_hash);
     void DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
                            GLuint draw_fb_handle);
 
@@ -428,6 +438,8 @@ private:
 struct CachedTextureCube {
     OGLTexture texture;
     u16 res_scale = 1;
+    std::size_t memory_size = 0;
+    u64 last_used = 0;
     std::shared_ptr<SurfaceWatcher> px;
     std::shared_ptr<SurfaceWatcher> nx;
     std::shared_ptr<SurfaceWatcher> py;
@@ -505,8 +517,34 @@ private:
     /// Increase/decrease the number of surface in pages touching the specified region
     void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
 
+    /// Mark the surface as the most recently used one, and update its memory size
+    void TouchSurface(const Surface& surface);
+
+    /// Remove the least recently used surfaces and cubes while the memory budget is exceeded
+    void EvictSurfaces();
+
+    void UpdateMemoryStats();
+
+    /// Returns the hash used to dump and replace the texture of the surface, 0 if not needed
+    u64 GetTextureHash(const Surface& surface);
+
+    /// Forgets the hashes of the chunks overlapping the region, as its memory changed
+    void InvalidateChunkHashes(PAddr addr, u32 size);
+
+    struct ChunkHash {
+        u32 size;
+        u64 hash;
+    };
+
     SurfaceCache surface_cache;
-    PageMap cached_pages;
+    std::list<Surface> lru_surfaces; ///< From the most to the least recently used
+    std::size_t surfaces_memory_size = 0;
+    std::size_t cubes_memory_size = 0;
+    u64 cube_use_count = 0;
+    /// Hashes of memory chunks by address for incremental texture hashing, only kept for cached
+    /// pages as writes to the others aren't seen
+    std::map<PAddr, ChunkHash> chunk_hashes;
+    bool chunk_hashes_fast = false; ///< Whether the chunk hashes use the fast hash function
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
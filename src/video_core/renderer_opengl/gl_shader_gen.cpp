@@ -3,11 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/bit_set.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "video_core/regs_framebuffer.h"
@@ -1230,11 +1235,118 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 }
 
+namespace {
+
+/// The part of the config SampleTexture depends on
+struct TextureSamplingState {
+    TexturingRegs::TextureConfig::TextureType texture0_type;
+    bool texture2_use_coord1;
+    bool proctex_enable;
+};
+
+struct TevStageSnippetState {
+    TextureSamplingState sampling;
+    TevStageConfigRaw stage;
+    unsigned index;
+    bool updates_combiner_buffer_color;
+    bool updates_combiner_buffer_alpha;
+};
+
+struct LightingSnippetState {
+    TextureSamplingState sampling;
+    decltype(PicaFSConfigState::lighting) lighting;
+};
+
+using ProcTexSnippetState = decltype(PicaFSConfigState::proctex);
+
+/**
+ * Memoizes the code of a part of the fragment shader, keyed by the part of the config it depends
+ * on. Configs missing from the shader cache usually share most of their TEV stages, lighting and
+ * procedural texture with configs generated before, so only what changed is generated again.
+ */
+std::atomic<bool> snippet_cache_enabled{true};
+
+template <typename State>
+class SnippetCache {
+public:
+    using Key = Common::HashableStruct<State>;
+
+    template <typename Writer>
+    void Append(std::string& out, const Key& key, Writer&& write) {
+        if (!snippet_cache_enabled) {
+            write(out);
+            return;
+        }
+
+        {
+            std::scoped_lock lock{mutex};
+            const auto iter = snippets.find(key);
+            if (iter != snippets.end()) {
+                out += iter->second;
+                return;
+            }
+        }
+
+        // Shaders are generated on several threads while loading the disk cache
+        std::string snippet;
+        write(snippet);
+        out += snippet;
+
+        std::scoped_lock lock{mutex};
+        if (snippets.size() >= MAX_SNIPPETS) {
+            snippets.clear();
+        }
+        snippets.emplace(key, std::move(snippet));
+    }
+
+private:
+    static constexpr std::size_t MAX_SNIPPETS = 4096;
+
+    struct Hash {
+        std::size_t operator()(const Key& key) const {
+            return key.Hash();
+        }
+    };
+
+    std::mutex mutex;
+    std::unordered_map<Key, std::string, Hash> snippets;
+};
+
+SnippetCache<TevStageSnippetState> tev_stage_snippets;
+SnippetCache<LightingSnippetState> lighting_snippets;
+SnippetCache<ProcTexSnippetState> proctex_snippets;
+
+/// The size of the largest fragment shader generated so far, reserved for the next ones
+std::atomic<std::size_t> fragment_shader_capacity{0};
+
+/*
+ * The snippet keys are hashed and compared bytewise, so their padding must stay zeroed like
+ * HashableStruct initializes it. Copying a struct with padding by assignment may leave its padding
+ * unspecified, so the fields are set one by one and the parts of the config are copied bytewise,
+ * as the config's own padding is zeroed.
+ */
+
+void SetTextureSamplingState(TextureSamplingState& sampling, const PicaFSConfig& config) {
+    sampling.texture0_type = config.state.texture0_type;
+    sampling.texture2_use_coord1 = config.state.texture2_use_coord1;
+    sampling.proctex_enable = config.state.proctex.enable;
+}
+
+template <typename T>
+void CopyConfigPart(T& destination, const T& source) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::memcpy(&destination, &source, sizeof(T));
+}
+
+} // Anonymous namespace
+
 ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
                                                        bool separable_shader) {
     const auto& state = config.state;
 
-    std::string out = R"(#version 330 core
+    std::string out;
+    out.reserve(fragment_shader_capacity.load(std::memory_order_relaxed));
+    out += R"(#version 330 core
 
 #extension GL_ARB_shader_image_load_store : enable
 #extension GL_ARB_shader_image_size : enable
@@ -1463,8 +1575,13 @@ vec4 shadowTextureCube(vec2 uv, float w) {
 #endif
 )";
 
-    if (config.state.proctex.enable)
-        AppendProcTexSampler(out, config);
+    if (config.state.proctex.enable) {
+        Common::HashableStruct<ProcTexSnippetState> key;
+        CopyConfigPart(key.state, state.proctex);
+        proctex_snippets.Append(out, key, [&](std::string& snippet) {
+            AppendProcTexSampler(snippet, config);
+        });
+    }
 
     // We round the interpolated primary color to the nearest 1/255th
     // This maintains the PICA's 8 bits of precision
@@ -1500,15 +1617,32 @@ vec4 shadowTextureCube(vec2 uv, float w) {
         out += "depth /= gl_FragCoord.w;\n";
     }
 
-    if (state.lighting.enable)
-        WriteLighting(out, config);
+    if (state.lighting.enable) {
+        Common::HashableStruct<LightingSnippetState> key;
+        SetTextureSamplingState(key.state.sampling, config);
+        CopyConfigPart(key.state.lighting, state.lighting);
+        lighting_snippets.Append(out, key, [&](std::string& snippet) {
+            WriteLighting(snippet, config);
+        });
+    }
 
     out += "vec4 combiner_buffer = vec4(0.0);\n";
     out += "vec4 next_combiner_buffer = tev_combiner_buffer_color;\n";
     out += "vec4 last_tex_env_out = vec4(0.0);\n";
 
-    for (std::size_t index = 0; index < state.tev_stages.size(); ++index)
-        WriteTevStage(out, config, (unsigned)index);
+    for (std::size_t index = 0; index < state.tev_stages.size(); ++index) {
+        Common::HashableStruct<TevStageSnippetState> key;
+        SetTextureSamplingState(key.state.sampling, config);
+        CopyConfigPart(key.state.stage, state.tev_stages[index]);
+        key.state.index = static_cast<unsigned>(index);
+        key.state.updates_combiner_buffer_color =
+            config.TevStageUpdatesCombinerBufferColor(key.state.index);
+        key.state.updates_combiner_buffer_alpha =
+            config.TevStageUpdatesCombinerBufferAlpha(key.state.index);
+        tev_stage_snippets.Append(out, key, [&](std::string& snippet) {
+            WriteTevStage(snippet, config, key.state.index);
+        });
+    }
 
     if (state.alpha_test_func != FramebufferRegs::CompareFunc::Always) {
         out += "if (";
@@ -1575,7 +1709,17 @@ do {
 
     out += "}";
 
-    return {out};
+    std::size_t capacity = fragment_shader_capacity.load(std::memory_order_relaxed);
+    while (out.size() > capacity &&
+           !fragment_shader_capacity.compare_exchange_weak(capacity, out.size(),
+                                                           std::memory_order_relaxed)) {
+    }
+
+    return {std::move(out)};
+}
+
+void SetFragmentShaderSnippetCacheEnabled(bool enabled) {
+    snippet_cache_enabled = enabled;
 }
 
 ShaderDecompiler::ProgramResult GenerateTrivialVertexShader(bool separable_shader) {
@@ -1802,4 +1946,5 @@ void main() {
 
     return {out};
 }
+
 } // namespace OpenGL
@@ -236,6 +236,13 @@ ShaderDecompiler::ProgramResult GenerateFixedGeometryShader(const PicaFixedGSCon
 ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
                                                        bool separable_shader);
 
+/**
+ * Sets whether GenerateFragmentShader reuses the code it generated for the TEV stages, lighting
+ * and procedural texture of previous configs. Enabled by default, only disabled to test that the
+ * reused code is the same as the code that would be generated.
+ */
+void SetFragmentShaderSnippetCacheEnabled(bool enabled);
+
 } // namespace OpenGL
 
 namespace std {
@@ -3,10 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
+#include <future>
 #include <thread>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/thread_pool.h"
 #include "core/core.h"
 #include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
@@ -219,14 +222,24 @@ public:
     explicit ShaderCache(bool separable) : separable(separable) {}
     std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Get(
         const KeyConfigType& config) {
-        auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
-        OGLShaderStage& cached_shader = iter->second;
-        std::optional<ShaderDecompiler::ProgramResult> result{};
-        if (new_shader) {
-            result = CodeGenerator(config, separable);
-            cached_shader.Create(result->code.c_str(), ShaderType);
+        auto iter = shaders.find(config);
+        if (iter != shaders.end()) {
+            return {iter->second.GetHandle(), {}};
         }
-        return {cached_shader.GetHandle(), result};
+        return Build(config, CodeGenerator(config, separable));
+    }
+
+    bool Contains(const KeyConfigType& config) const {
+        return shaders.find(config) != shaders.end();
+    }
+
+    /// Compiles the shader of a config missing from the cache, from code generated beforehand
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Build(
+        const KeyConfigType& config, ShaderDecompiler::ProgramResult result) {
+        OGLShaderStage& cached_shader =
+            shaders.emplace(config, OGLShaderStage{separable}).first->second;
+        cached_shader.Create(result.code.c_str(), ShaderType);
+        return {cached_shader.GetHandle(), std::move(result)};
     }
 
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
@@ -254,24 +267,9 @@ public:
     explicit ShaderDoubleCache(bool separable) : separable(separable) {}
     std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Get(
         const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
-        std::optional<ShaderDecompiler::ProgramResult> result{};
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
-            auto program_opt = CodeGenerator(setup, key, separable);
-            if (!program_opt) {
-                shader_map[key] = nullptr;
-                return {0, {}};
-            }
-
-            std::string& program = program_opt->code;
-            auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
-            OGLShaderStage& cached_shader = iter->second;
-            if (new_shader) {
-                result->code = program;
-                cached_shader.Create(program.c_str(), ShaderType);
-            }
-            shader_map[key] = &cached_shader;
-            return {cached_shader.GetHandle(), result};
+            return Build(key, CodeGenerator(setup, key, separable));
         }
 
         if (map_it->second == nullptr) {
@@ -281,6 +279,30 @@ public:
         return {map_it->second->GetHandle(), {}};
     }
 
+    bool Contains(const KeyConfigType& key) const {
+        return shader_map.find(key) != shader_map.end();
+    }
+
+    /// Compiles the shader of a config missing from the cache, from code generated beforehand
+    std::tuple<GLuint, std::optional<ShaderDecompiler::ProgramResult>> Build(
+        const KeyConfigType& key, std::optional<ShaderDecompiler::ProgramResult> program_opt) {
+        std::optional<ShaderDecompiler::ProgramResult> result{};
+        if (!program_opt) {
+            shader_map[key] = nullptr;
+            return {0, {}};
+        }
+
+        std::string& program = program_opt->code;
+        auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
+        OGLShaderStage& cached_shader = iter->second;
+        if (new_shader) {
+            result->code = program;
+            cached_shader.Create(program.c_str(), ShaderType);
+        }
+        shader_map[key] = &cached_shader;
+        return {cached_shader.GetHandle(), result};
+    }
+
     void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -442,6 +464,10 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
         return;
     }
 
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const auto load_start = Clock::now();
+
     auto& disk_cache = impl->disk_cache;
     const auto transferable = disk_cache.LoadTransferable();
     if (!transferable) {
@@ -450,6 +476,7 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
     const auto raws = *transferable;
 
     auto [decompiled, dumps] = disk_cache.LoadPrecompiled();
+    const auto precompiled_start = Clock::now();
 
     if (stop_loading) {
         return;
@@ -557,6 +584,49 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
     }
 
     compilation_failed = false;
+    const auto build_start = Clock::now();
+
+    // GLSL generation only depends on the entry, so it runs on the thread pool for all the shaders
+    // missing from the caches, while the ones already generated are compiled here in order
+    Common::ThreadPool& thread_pool = Common::ThreadPool::GetPool();
+    std::vector<std::optional<ShaderDecompiler::ProgramResult>> generated(raws.size());
+    std::vector<std::future<void>> generating(raws.size());
+    std::atomic<Clock::rep> generation_ticks = 0;
+    const auto Generate = [&](std::size_t i) {
+        if (stop_loading || compilation_failed) {
+            return;
+        }
+        const auto start = Clock::now();
+        const auto& raw{raws[i]};
+        if (raw.GetProgramType() == ProgramType::VS) {
+            auto [conf, setup] = BuildVSConfigFromRaw(raw);
+            generated[i] = GenerateVertexShader(setup, conf, impl->separable);
+        } else {
+            generated[i] = GenerateFragmentShader(
+                PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig()), impl->separable);
+        }
+        generation_ticks += (Clock::now() - start).count();
+    };
+    for (std::size_t i = 0; i < raws.size(); ++i) {
+        const auto& raw{raws[i]};
+        if (raw.GetProgramType() == ProgramType::VS) {
+            const PicaVSConfig conf = std::get<0>(BuildVSConfigFromRaw(raw));
+            if (impl->programmable_vertex_shaders.Contains(conf)) {
+                continue;
+            }
+        } else if (raw.GetProgramType() == ProgramType::FS) {
+            if (impl->fragment_shaders.Contains(
+                    PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig()))) {
+                continue;
+            }
+        } else {
+            continue;
+        }
+        generating[i] = thread_pool.Push(Generate, i);
+    }
+
+    Clock::duration generation_wait{};
+    Clock::duration compilation_time{};
 
     const auto LoadTransferable = [&](std::size_t begin, std::size_t end,
                                       const std::vector<ShaderDiskCacheRaw>& raws) {
@@ -567,26 +637,38 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
             const auto& raw{raws[i]};
             const u64 unique_identifier{raw.GetUniqueIdentifier()};
 
+            if (generating[i].valid()) {
+                const auto wait_start = Clock::now();
+                generating[i].get();
+                generation_wait += Clock::now() - wait_start;
+                // The generation was skipped if loading stopped meanwhile
+                if (stop_loading) {
+                    return;
+                }
+            }
+            const bool was_generated = generated[i].has_value();
+
+            const auto compilation_start = Clock::now();
             bool sanitize_mul = false;
             GLuint handle{0};
             std::optional<ShaderDecompiler::ProgramResult> result;
-            // Otherwise decompile and build the shader at boot and save the result to the
-            // precompiled file
+            // Build the shader at boot and save the result to the precompiled file. Its code was
+            // generated on the thread pool, unless an earlier entry had the same config or the
+            // generation failed, in which case Get generates it again.
             if (raw.GetProgramType() == ProgramType::VS) {
-                // TODO: This isn't the ideal place to lock, since we really only want to
-                // lock access to the shared cache
                 auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->programmable_vertex_shaders.Get(conf, setup);
-                handle = h;
-                result = r;
+                auto& shaders = impl->programmable_vertex_shaders;
+                std::tie(handle, result) =
+                    was_generated && !shaders.Contains(conf)
+                        ? shaders.Build(conf, std::move(generated[i]))
+                        : shaders.Get(conf, setup);
                 sanitize_mul = conf.state.sanitize_mul;
             } else if (raw.GetProgramType() == ProgramType::FS) {
                 PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->fragment_shaders.Get(conf);
-                handle = h;
-                result = r;
+                auto& shaders = impl->fragment_shaders;
+                std::tie(handle, result) = was_generated && !shaders.Contains(conf)
+                                               ? shaders.Build(conf, std::move(*generated[i]))
+                                               : shaders.Get(conf);
             } else {
                 // Unsupported shader type got stored somehow so nuke the cache
                 LOG_CRITICAL(Frontend, "failed to load raw programtype {}",
@@ -594,6 +676,7 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
                 compilation_failed = true;
                 return;
             }
+            compilation_time += Clock::now() - compilation_start;
             if (handle == 0) {
                 LOG_CRITICAL(Frontend, "compilation from raw failed {:x} {:x}",
                              raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
@@ -614,6 +697,13 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
 
     LoadTransferable(0, raws.size(), raws);
 
+    // After an early exit, pending generation tasks still reference the locals above
+    for (std::future<void>& future : generating) {
+        if (future.valid()) {
+            future.wait();
+        }
+    }
+
     if (compilation_failed) {
         disk_cache.InvalidateAll();
     }
@@ -622,6 +712,19 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
         disk_cache.SaveVirtualPrecompiledFile();
     }
 
+    const auto load_end = Clock::now();
+    LOG_INFO(Render_OpenGL,
+             "Loaded {} disk cache shaders in {:.0f} ms: reading {:.0f} ms, precompiled {:.0f} ms, "
+             "building {:.0f} ms (GLSL generation {:.0f} ms on {} threads, {:.0f} ms waited for "
+             "it, compilation {:.0f} ms)",
+             raws.size(), Milliseconds(load_end - load_start).count(),
+             Milliseconds(precompiled_start - load_start).count(),
+             Milliseconds(build_start - precompiled_start).count(),
+             Milliseconds(load_end - build_start).count(),
+             Milliseconds(Clock::duration(generation_ticks.load())).count(),
+             thread_pool.TotalThreads(), Milliseconds(generation_wait).count(),
+             Milliseconds(compilation_time).count());
+
     if (callback) {
         callback(VideoCore::LoadCallbackStage::Complete, 0, 0);
     }
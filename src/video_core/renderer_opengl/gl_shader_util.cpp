@@ -6,6 +6,7 @@
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/trace.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
 
 namespace OpenGL {
@@ -29,11 +30,15 @@ GLuint LoadShader(const char* source, GLenum type) {
     GLuint shader_id = glCreateShader(type);
     glShaderSource(shader_id, 1, &source, nullptr);
     LOG_DEBUG(Render_OpenGL, "Compiling {} shader...", debug_type);
-    glCompileShader(shader_id);
 
     GLint result = GL_FALSE;
     GLint info_log_length;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+    {
+        // Drivers can compile in the background until the status is queried
+        Common::Trace::Scope trace_scope("Compile shader");
+        glCompileShader(shader_id);
+        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+    }
     glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
 
     if (info_log_length > 1) {
@@ -66,12 +71,14 @@ GLuint LoadProgram(bool separable_program, const std::vector<GLuint>& shaders) {
         glProgramParameteri(program_id, GL_PROGRAM_SEPARABLE, GL_TRUE);
     }
 
-    glLinkProgram(program_id);
-
     // Check the program
     GLint result = GL_FALSE;
     GLint info_log_length;
-    glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+    {
+        Common::Trace::Scope trace_scope("Link program");
+        glLinkProgram(program_id);
+        glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+    }
     glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_log_length);
 
     if (info_log_length > 1) {
@@ -0,0 +1,174 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <set>
+#include <boost/container/small_vector.hpp>
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "core/memory.h"
+
+namespace OpenGL {
+
+/**
+ * Index of the surfaces overlapping each physical memory page, with the number of surfaces
+ * caching each page. Pages are stored in blocks allocated when a surface first uses them, so
+ * looking up an address range doesn't allocate and only visits the pages of the range.
+ *
+ * SurfacePtr must be a pointer-like type to a type with PAddr addr and end members.
+ */
+template <typename SurfacePtr>
+class SurfacePageIndex {
+public:
+    /// Surfaces returned by lookups, the common case doesn't allocate
+    using SurfaceList = boost::container::small_vector<SurfacePtr, 16>;
+
+    void Add(const SurfacePtr& surface) {
+        surfaces.insert(surface);
+        ForEachPage(surface->addr, surface->end,
+                    [&](Page& page) { page.surfaces.push_back(surface); });
+    }
+
+    void Remove(const SurfacePtr& surface) {
+        surfaces.erase(surface);
+        ForEachPage(surface->addr, surface->end, [&](Page& page) {
+            const auto iter = std::find(page.surfaces.begin(), page.surfaces.end(), surface);
+            ASSERT(iter != page.surfaces.end());
+            *iter = std::move(page.surfaces.back());
+            page.surfaces.pop_back();
+        });
+    }
+
+    bool Empty() const {
+        return surfaces.empty();
+    }
+
+    /// Returns one of the surfaces, the index must not be empty
+    SurfacePtr Front() const {
+        return *surfaces.begin();
+    }
+
+    /**
+     * Returns the surfaces overlapping [begin, end), in the order an interval map of surface
+     * sets visits them first: by the start of their overlap with the range, then by pointer.
+     */
+    SurfaceList GetOverlapping(PAddr begin, PAddr end) const {
+        SurfaceList result;
+        if (begin >= end) {
+            return result;
+        }
+        const u64 num_pages = ((end - 1) >> PAGE_BITS) - (begin >> PAGE_BITS) + 1;
+        if (num_pages > surfaces.size()) {
+            // Large ranges, like the whole address space, have more pages than surfaces
+            for (const SurfacePtr& surface : surfaces) {
+                if (surface->addr < end && surface->end > begin) {
+                    result.push_back(surface);
+                }
+            }
+        } else {
+            ForEachExistingPage(begin, end, [&](u32 page_index, const Page& page) {
+                for (const SurfacePtr& surface : page.surfaces) {
+                    // Surfaces are taken from the first page they overlap in the range only
+                    if (surface->addr < end && surface->end > begin &&
+                        std::max(surface->addr, begin) >> PAGE_BITS == page_index) {
+                        result.push_back(surface);
+                    }
+                }
+            });
+        }
+
+        std::sort(result.begin(), result.end(), [begin](const SurfacePtr& a, const SurfacePtr& b) {
+            const PAddr a_start = std::max(a->addr, begin);
+            const PAddr b_start = std::max(b->addr, begin);
+            return a_start != b_start ? a_start < b_start
+                                      : std::addressof(*a) < std::addressof(*b);
+        });
+        return result;
+    }
+
+    /**
+     * Adds delta to the number of surfaces caching the pages of [addr, addr + size). Calls
+     * mark_cached(start, size, cached) for each run of pages that became cached or uncached.
+     */
+    template <typename MarkCached>
+    void UpdateCachedCount(PAddr addr, u32 size, int delta, MarkCached&& mark_cached) {
+        const u32 page_start = addr >> PAGE_BITS;
+        const u32 page_end = ((addr + size - 1) >> PAGE_BITS) + 1;
+        u32 run_start = page_end;
+        for (u32 page_index = page_start; page_index < page_end; ++page_index) {
+            Page& page = GetPage(page_index);
+            page.cached_count += delta;
+            ASSERT(page.cached_count >= 0);
+            const bool changed = delta > 0 ? page.cached_count == delta : page.cached_count == 0;
+            if (changed && run_start == page_end) {
+                run_start = page_index;
+            } else if (!changed && run_start != page_end) {
+                mark_cached(run_start << PAGE_BITS, (page_index - run_start) << PAGE_BITS,
+                            delta > 0);
+                run_start = page_end;
+            }
+        }
+        if (run_start != page_end) {
+            mark_cached(run_start << PAGE_BITS, (page_end - run_start) << PAGE_BITS, delta > 0);
+        }
+    }
+
+    /// Returns the number of surfaces caching the page of the address
+    int GetCachedCount(PAddr addr) const {
+        const auto& block = blocks[addr >> (PAGE_BITS + BLOCK_BITS)];
+        return block ? (*block)[(addr >> PAGE_BITS) & BLOCK_MASK].cached_count : 0;
+    }
+
+private:
+    static constexpr u32 PAGE_BITS = Memory::PAGE_BITS;
+    static constexpr u32 BLOCK_BITS = 10;
+    static constexpr u32 BLOCK_MASK = (1 << BLOCK_BITS) - 1;
+    static constexpr std::size_t NUM_BLOCKS = std::size_t{1} << (32 - PAGE_BITS - BLOCK_BITS);
+
+    struct Page {
+        boost::container::small_vector<SurfacePtr, 4> surfaces;
+        int cached_count = 0;
+    };
+    using Block = std::array<Page, 1 << BLOCK_BITS>;
+
+    Page& GetPage(u32 page_index) {
+        auto& block = blocks[page_index >> BLOCK_BITS];
+        if (!block) {
+            block = std::make_unique<Block>();
+        }
+        return (*block)[page_index & BLOCK_MASK];
+    }
+
+    template <typename Func>
+    void ForEachPage(PAddr begin, PAddr end, Func&& func) {
+        for (u32 page_index = begin >> PAGE_BITS; page_index <= (end - 1) >> PAGE_BITS;
+             ++page_index) {
+            func(GetPage(page_index));
+        }
+    }
+
+    template <typename Func>
+    void ForEachExistingPage(PAddr begin, PAddr end, Func&& func) const {
+        const u32 last_page = (end - 1) >> PAGE_BITS;
+        for (u32 page_index = begin >> PAGE_BITS; page_index <= last_page; ++page_index) {
+            const auto& block = blocks[page_index >> BLOCK_BITS];
+            if (!block) {
+                // Skip to the next block
+                page_index |= BLOCK_MASK;
+                continue;
+            }
+            func(page_index, (*block)[page_index & BLOCK_MASK]);
+        }
+    }
+
+    /// Every surface, ordered by pointer
+    std::set<SurfacePtr> surfaces;
+    std::array<std::unique_ptr<Block>, NUM_BLOCKS> blocks;
+};
+
+} // namespace OpenGL
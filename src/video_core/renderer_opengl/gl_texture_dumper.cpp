@@ -0,0 +1,162 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/logging/log.h"
+#include "common/stb_image_write.h"
+#include "common/texture.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
+
+namespace OpenGL {
+
+namespace {
+
+/// Dumps being read back or encoded at once, new ones are refused above this
+constexpr u64 MAX_QUEUED_DUMPS = 32;
+
+constexpr std::size_t NUM_ENCODERS = 2;
+
+/// zlib level used for dumps, favoring speed over size
+constexpr int PNG_COMPRESSION_LEVEL = 1;
+
+} // Anonymous namespace
+
+TextureDumper::~TextureDumper() {
+    StopEncoders();
+}
+
+bool TextureDumper::Dump(GLuint texture, u32 width, u32 height, std::string path) {
+    ProcessReadbacks();
+    if (queued >= MAX_QUEUED_DUMPS) {
+        ++dropped;
+        return false;
+    }
+    ++queued;
+
+    if (encoders.empty()) {
+        // Shared with the other PNG writers, which are all fine with a fast level
+        stbi_write_png_compression_level = PNG_COMPRESSION_LEVEL;
+        stop_encoders = false;
+        for (std::size_t i = 0; i < NUM_ENCODERS; ++i) {
+            encoders.emplace_back(&TextureDumper::EncoderLoop, this);
+        }
+    }
+    if (read_framebuffer.handle == 0) {
+        read_framebuffer.Create();
+    }
+
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    OpenGLState state;
+    state.draw.read_framebuffer = read_framebuffer.handle;
+    state.Apply();
+
+    Readback readback{{}, nullptr, width, height, std::move(path)};
+    readback.buffer.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ);
+
+    // Only the region of the surface is read, as the texture can be larger if a custom texture
+    // was uploaded to it before
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    cur_state.Apply();
+
+    readbacks.push_back(std::move(readback));
+    return true;
+}
+
+void TextureDumper::ProcessReadbacks(bool wait) {
+    while (!readbacks.empty()) {
+        Readback& readback = readbacks.front();
+        const GLenum status = glClientWaitSync(
+            readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        glDeleteSync(readback.fence);
+
+        EncodeJob job{std::vector<u8>(readback.width * readback.height * 4), readback.width,
+                      readback.height, std::move(readback.path)};
+        bool success = status != GL_WAIT_FAILED;
+        if (success) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+            const void* pixels =
+                glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.pixels.size(), GL_MAP_READ_BIT);
+            success = pixels != nullptr;
+            if (success) {
+                std::memcpy(job.pixels.data(), pixels, job.pixels.size());
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        readbacks.pop_front();
+
+        if (!success) {
+            LOG_ERROR(Render_OpenGL, "Failed to read back texture for {}", job.path);
+            --queued;
+            continue;
+        }
+        {
+            std::lock_guard lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        job_available.notify_one();
+    }
+}
+
+void TextureDumper::Destroy() {
+    ProcessReadbacks(true);
+    read_framebuffer.Release();
+    StopEncoders();
+}
+
+TextureDumper::Stats TextureDumper::GetStats() const {
+    return {queued, written, dropped};
+}
+
+void TextureDumper::EncoderLoop() {
+    for (;;) {
+        EncodeJob job;
+        {
+            std::unique_lock lock(mutex);
+            job_available.wait(lock, [this] { return stop_encoders || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Common::FlipRGBA8Texture(job.pixels, job.width, job.height);
+        if (stbi_write_png(job.path.c_str(), static_cast<int>(job.width),
+                           static_cast<int>(job.height), 4, job.pixels.data(),
+                           static_cast<int>(job.width) * 4) == 0) {
+            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
+        } else {
+            ++written;
+        }
+        --queued;
+    }
+}
+
+void TextureDumper::StopEncoders() {
+    {
+        std::lock_guard lock(mutex);
+        stop_encoders = true;
+    }
+    job_available.notify_all();
+    // The encoders finish the queued jobs first
+    for (std::thread& encoder : encoders) {
+        encoder.join();
+    }
+    encoders.clear();
+}
+
+} // namespace OpenGL
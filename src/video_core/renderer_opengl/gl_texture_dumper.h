@@ -0,0 +1,89 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Dumps textures without stalling the renderer. Textures are read back to pixel buffers, which are
+ * mapped once their fence is signaled, and encoded as PNG by background threads.
+ */
+class TextureDumper {
+public:
+    struct Stats {
+        u64 queued;  ///< Dumps being read back or encoded
+        u64 written; ///< Dumps written since the start
+        u64 dropped; ///< Dumps refused because too many were queued
+    };
+
+    static TextureDumper& GetInstance() {
+        static TextureDumper singleton;
+        return singleton;
+    }
+
+    ~TextureDumper();
+
+    /**
+     * Starts reading back the bottom left width x height region of the texture, to be written
+     * to the path. Returns false if too many dumps are queued, the texture can be dumped later.
+     */
+    bool Dump(GLuint texture, u32 width, u32 height, std::string path);
+
+    /// Hands the finished readbacks to the encoder threads, waiting for the others if needed
+    void ProcessReadbacks(bool wait = false);
+
+    /// Finishes the queued dumps and releases the OpenGL objects
+    void Destroy();
+
+    Stats GetStats() const;
+
+private:
+    struct Readback {
+        OGLBuffer buffer;
+        GLsync fence;
+        u32 width;
+        u32 height;
+        std::string path;
+    };
+
+    struct EncodeJob {
+        std::vector<u8> pixels;
+        u32 width;
+        u32 height;
+        std::string path;
+    };
+
+    TextureDumper() = default;
+
+    void EncoderLoop();
+    void StopEncoders();
+
+    // Only used by the thread owning the OpenGL context
+    std::deque<Readback> readbacks;
+    OGLFramebuffer read_framebuffer;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<EncodeJob> jobs;
+    bool stop_encoders = false;
+    std::vector<std::thread> encoders;
+
+    std::atomic<u64> queued{0};
+    std::atomic<u64> written{0};
+    std::atomic<u64> dropped{0};
+};
+
+} // namespace OpenGL
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <cstdlib>
 #include <memory>
+#include <optional>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/bit_field.h"
@@ -20,8 +21,10 @@
 #include "core/memory.h"
 #include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/frame_capture.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_opengl/post_processing_opengl.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_manager.h"
 #include "video_core/video_core.h"
@@ -152,6 +155,9 @@ RendererOpenGL::~RendererOpenGL() = default;
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers() {
+    std::optional<Core::SubsystemTimer> present_timer;
+    present_timer.emplace(Core::Subsystem::Present);
+
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
@@ -191,41 +197,17 @@ void RendererOpenGL::SwapBuffers() {
         }
     }
 
-    if (VideoCore::g_renderer_screenshot_requested) {
-        // Draw this frame to the screenshot framebuffer
-        screenshot_framebuffer.Create();
-        GLuint old_read_fb = state.draw.read_framebuffer;
-        GLuint old_draw_fb = state.draw.draw_framebuffer;
-        state.draw.read_framebuffer = state.draw.draw_framebuffer = screenshot_framebuffer.handle;
-        state.Apply();
-
-        Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
-
-        GLuint renderbuffer;
-        glGenRenderbuffers(1, &renderbuffer);
-        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
-                                  renderbuffer);
-
-        DrawScreens(layout);
-
-        glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
-                     VideoCore::g_screenshot_bits);
-
-        screenshot_framebuffer.Release();
-        state.draw.read_framebuffer = old_read_fb;
-        state.draw.draw_framebuffer = old_draw_fb;
-        state.Apply();
-        glDeleteRenderbuffers(1, &renderbuffer);
-
-        VideoCore::g_screenshot_complete_callback();
-        VideoCore::g_renderer_screenshot_requested = false;
+    ProcessCaptureReadbacks(false);
+    if (VideoCore::g_frame_capture.ShouldCapture(m_current_frame)) {
+        CaptureFrame(render_window.GetFramebufferLayout());
     }
 
     DrawScreens(render_window.GetFramebufferLayout());
     m_current_frame++;
 
+    TextureDumper::GetInstance().ProcessReadbacks();
+
+    present_timer.reset();
     Core::System::GetInstance().perf_stats->EndSystemFrame();
 
     // Swap buffers
@@ -240,6 +222,95 @@ void RendererOpenGL::SwapBuffers() {
     RefreshRasterizerSetting();
 }
 
+void RendererOpenGL::CaptureFrame(const Layout::FramebufferLayout& layout) {
+    CaptureReadback& readback = capture_readbacks[next_capture_readback];
+    // Both readbacks are in progress if the GPU is far behind
+    FinishCaptureReadback(readback, true);
+
+    if (capture_framebuffer.handle == 0) {
+        capture_framebuffer.Create();
+    }
+    const GLuint old_read_fb = state.draw.read_framebuffer;
+    const GLuint old_draw_fb = state.draw.draw_framebuffer;
+    state.draw.read_framebuffer = state.draw.draw_framebuffer = capture_framebuffer.handle;
+    state.Apply();
+
+    if (layout.width != capture_width || layout.height != capture_height) {
+        if (capture_renderbuffer == 0) {
+            glGenRenderbuffers(1, &capture_renderbuffer);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, capture_renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                  capture_renderbuffer);
+        capture_width = layout.width;
+        capture_height = layout.height;
+    }
+
+    DrawScreens(layout);
+
+    // The pixels are read to the buffer and only mapped once the fence is signaled, so this doesn't
+    // wait for the GPU
+    if (readback.buffer.handle == 0) {
+        readback.buffer.Create();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, layout.width * layout.height * 4, nullptr,
+                 GL_STREAM_READ);
+    glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.frame_number = static_cast<u64>(m_current_frame);
+    readback.width = layout.width;
+    readback.height = layout.height;
+    next_capture_readback = (next_capture_readback + 1) % capture_readbacks.size();
+
+    state.draw.read_framebuffer = old_read_fb;
+    state.draw.draw_framebuffer = old_draw_fb;
+    state.Apply();
+}
+
+void RendererOpenGL::ProcessCaptureReadbacks(bool wait) {
+    // The next readback to be reused is the oldest one
+    for (std::size_t i = 0; i < capture_readbacks.size(); ++i) {
+        const std::size_t index = (next_capture_readback + i) % capture_readbacks.size();
+        if (!FinishCaptureReadback(capture_readbacks[index], wait)) {
+            return;
+        }
+    }
+}
+
+bool RendererOpenGL::FinishCaptureReadback(CaptureReadback& readback, bool wait) {
+    if (readback.fence == nullptr) {
+        return true;
+    }
+    const GLenum status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                           wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status == GL_WAIT_FAILED) {
+        LOG_ERROR(Render_OpenGL, "Failed to read back frame {}", readback.frame_number);
+        return true;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                          readback.width * readback.height * 4, GL_MAP_READ_BIT);
+    if (pixels != nullptr) {
+        // Converted straight from the mapped buffer to the ring buffer of the captures
+        VideoCore::g_frame_capture.PushFrame(readback.frame_number, static_cast<const u8*>(pixels),
+                                             readback.width, readback.height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOG_ERROR(Render_OpenGL, "Failed to map frame {}", readback.frame_number);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
 /**
  * Loads framebuffer from emulated memory into the active OpenGL texture.
  */
@@ -865,6 +936,17 @@ VideoCore::ResultStatus RendererOpenGL::Init() {
 /// Shutdown the renderer
 void RendererOpenGL::ShutDown() {
     TextureFilterManager::GetInstance().Destroy();
+    TextureDumper::GetInstance().Destroy();
+
+    ProcessCaptureReadbacks(true);
+    for (CaptureReadback& readback : capture_readbacks) {
+        readback.buffer.Release();
+    }
+    capture_framebuffer.Release();
+    if (capture_renderbuffer != 0) {
+        glDeleteRenderbuffers(1, &capture_renderbuffer);
+        capture_renderbuffer = 0;
+    }
 }
 
 } // namespace OpenGL
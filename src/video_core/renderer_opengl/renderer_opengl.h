@@ -51,6 +51,15 @@ public:
     void ShutDown() override;
 
 private:
+    /// Screens being read back for VideoCore::FrameCapture
+    struct CaptureReadback {
+        OGLBuffer buffer;
+        GLsync fence = nullptr; ///< Null when no readback is in progress
+        u64 frame_number = 0;
+        u32 width = 0;
+        u32 height = 0;
+    };
+
     void InitOpenGLObjects();
     void ReloadSampler();
     void ReloadShader();
@@ -66,6 +75,13 @@ private:
                                 float x, float y, float w, float h);
     void UpdateFramerate();
 
+    /// Draws the screens to the capture framebuffer and starts reading them back
+    void CaptureFrame(const Layout::FramebufferLayout& layout);
+    /// Hands the finished readbacks to VideoCore::FrameCapture, in order
+    void ProcessCaptureReadbacks(bool wait);
+    /// Returns false if the readback isn't finished and wait is false
+    bool FinishCaptureReadback(CaptureReadback& readback, bool wait);
+
     // Loads framebuffer from emulated memory into the display information structure
     void LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer,
                             ScreenInfo& screen_info, bool right_eye);
@@ -78,9 +94,16 @@ private:
     OGLVertexArray vertex_array;
     OGLBuffer vertex_buffer;
     OGLProgram shader;
-    OGLFramebuffer screenshot_framebuffer;
+    OGLFramebuffer capture_framebuffer;
     OGLSampler filter_sampler;
 
+    GLuint capture_renderbuffer = 0;
+    u32 capture_width = 0;
+    u32 capture_height = 0;
+    /// Two readbacks, so a capture can start while the previous one is being read back
+    std::array<CaptureReadback, 2> capture_readbacks;
+    std::size_t next_capture_readback = 0;
+
     /// Display information for top and bottom screens respectively
     std::array<ScreenInfo, 3> screen_infos;
 
@@ -0,0 +1,174 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/frame_capture.h"
+#include "video_core/renderer_software/renderer_software.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+namespace {
+
+template <Common::Vec4<u8> (*Decode)(const u8*)>
+void DecodeSideways(const GPU::Regs::FramebufferConfig& framebuffer, const u8* source, u8* dest,
+                    std::size_t dest_stride, u32 width, u32 height) {
+    const u32 bpp = static_cast<u32>(GPU::Regs::BytesPerPixel(framebuffer.color_format));
+    const u32 source_width = framebuffer.width;
+    const u32 source_height = framebuffer.height;
+    // Each row of the framebuffer is a column of the screen, from the bottom
+    for (u32 x = 0; x < width; ++x) {
+        const u8* row = source + x * source_height / width * framebuffer.stride;
+        for (u32 y = 0; y < height; ++y) {
+            const Common::Vec4<u8> color =
+                Decode(row + (source_width - 1 - y * source_width / height) * bpp);
+            u8* pixel = dest + y * dest_stride + x * 4;
+            pixel[0] = color.r();
+            pixel[1] = color.g();
+            pixel[2] = color.b();
+            // The LCDs ignore the alpha
+            pixel[3] = 255;
+        }
+    }
+}
+
+} // Anonymous namespace
+
+RendererSoftware::RendererSoftware(Frontend::EmuWindow& window) : RendererBase{window} {}
+RendererSoftware::~RendererSoftware() = default;
+
+/// Swap buffers (render frame)
+void RendererSoftware::SwapBuffers() {
+    const u8 bg_red = static_cast<u8>(Settings::values.bg_red * 255);
+    const u8 bg_green = static_cast<u8>(Settings::values.bg_green * 255);
+    const u8 bg_blue = static_cast<u8>(Settings::values.bg_blue * 255);
+    const u32 bottom_x = (SCREENS_WIDTH - Core::kScreenBottomWidth) / 2;
+    const u32 bottom_y = Core::kScreenTopHeight;
+
+    {
+        Core::SubsystemTimer timer(Core::Subsystem::Present);
+        DrawScreen(0, 0, 0);
+        FillScreens(0, bottom_y, bottom_x, Core::kScreenBottomHeight, bg_red, bg_green, bg_blue);
+        DrawScreen(1, bottom_x, bottom_y);
+        FillScreens(bottom_x + Core::kScreenBottomWidth, bottom_y, bottom_x,
+                    Core::kScreenBottomHeight, bg_red, bg_green, bg_blue);
+
+        if (g_frame_capture.ShouldCapture(m_current_frame)) {
+            g_frame_capture.PushFrameRGBA(m_current_frame, screens.data(), SCREENS_WIDTH,
+                                          SCREENS_HEIGHT);
+        }
+        m_current_frame++;
+    }
+
+    Core::System::GetInstance().perf_stats->EndSystemFrame();
+
+    render_window.PollEvents();
+    render_window.SwapBuffers();
+
+    Core::System::GetInstance().frame_limiter.DoFrameLimiting(
+        Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
+    Core::System::GetInstance().perf_stats->BeginSystemFrame();
+
+    RefreshRasterizerSetting();
+}
+
+void RendererSoftware::DrawScreen(int fb_id, u32 x, u32 y) {
+    const u32 width = fb_id == 0 ? Core::kScreenTopWidth : Core::kScreenBottomWidth;
+    const u32 height = fb_id == 0 ? Core::kScreenTopHeight : Core::kScreenBottomHeight;
+
+    // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
+    u32 lcd_color_addr =
+        (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
+    lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
+    LCD::Regs::ColorFill color_fill = {0};
+    LCD::Read(color_fill.raw, lcd_color_addr);
+    if (color_fill.is_enabled) {
+        FillScreens(x, y, width, height, color_fill.color_r, color_fill.color_g,
+                    color_fill.color_b);
+        return;
+    }
+
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
+    const PAddr framebuffer_addr =
+        framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const u32 size = framebuffer.stride * framebuffer.height;
+    if (framebuffer.width == 0 || size == 0) {
+        FillScreens(x, y, width, height, 0, 0, 0);
+        return;
+    }
+
+    Memory::RasterizerFlushRegion(framebuffer_addr, size);
+    const u8* framebuffer_data = g_memory->GetPhysicalPointer(framebuffer_addr);
+    if (framebuffer_data == nullptr) {
+        LOG_ERROR(Render, "Invalid framebuffer address 0x{:08x}", framebuffer_addr);
+        FillScreens(x, y, width, height, 0, 0, 0);
+        return;
+    }
+
+    // Framebuffers of another size are stretched to the screen, like the OpenGL renderer does
+    if (!DecodeLCDFramebuffer(framebuffer, framebuffer_data, &screens[(y * SCREENS_WIDTH + x) * 4],
+                              SCREENS_WIDTH * 4, width, height)) {
+        LOG_ERROR(Render, "Unknown framebuffer format {}",
+                  static_cast<u32>(framebuffer.color_format.Value()));
+        FillScreens(x, y, width, height, 0, 0, 0);
+    }
+}
+
+void RendererSoftware::FillScreens(u32 x, u32 y, u32 width, u32 height, u8 r, u8 g, u8 b) {
+    for (u32 row = y; row < y + height; ++row) {
+        u8* pixel = &screens[(row * SCREENS_WIDTH + x) * 4];
+        for (u32 column = 0; column < width; ++column, pixel += 4) {
+            pixel[0] = r;
+            pixel[1] = g;
+            pixel[2] = b;
+            pixel[3] = 255;
+        }
+    }
+}
+
+/// Initialize the renderer
+ResultStatus RendererSoftware::Init() {
+    screens.assign(SCREENS_WIDTH * SCREENS_HEIGHT * 4, 0);
+    RefreshRasterizerSetting();
+    LOG_INFO(Render, "Using the headless software renderer");
+    return ResultStatus::Success;
+}
+
+/// Shutdown the renderer
+void RendererSoftware::ShutDown() {
+    screens.clear();
+}
+
+bool DecodeLCDFramebuffer(const GPU::Regs::FramebufferConfig& framebuffer, const u8* source,
+                          u8* dest, std::size_t dest_stride, u32 width, u32 height) {
+    switch (framebuffer.color_format) {
+    case GPU::Regs::PixelFormat::RGBA8:
+        DecodeSideways<Color::DecodeRGBA8>(framebuffer, source, dest, dest_stride, width, height);
+        return true;
+    case GPU::Regs::PixelFormat::RGB8:
+        DecodeSideways<Color::DecodeRGB8>(framebuffer, source, dest, dest_stride, width, height);
+        return true;
+    case GPU::Regs::PixelFormat::RGB565:
+        DecodeSideways<Color::DecodeRGB565>(framebuffer, source, dest, dest_stride, width, height);
+        return true;
+    case GPU::Regs::PixelFormat::RGB5A1:
+        DecodeSideways<Color::DecodeRGB5A1>(framebuffer, source, dest, dest_stride, width, height);
+        return true;
+    case GPU::Regs::PixelFormat::RGBA4:
+        DecodeSideways<Color::DecodeRGBA4>(framebuffer, source, dest, dest_stride, width, height);
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace VideoCore
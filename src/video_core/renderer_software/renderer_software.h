@@ -0,0 +1,60 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "core/3ds.h"
+#include "core/hw/gpu.h"
+#include "video_core/renderer_base.h"
+
+namespace VideoCore {
+
+/**
+ * Renderer that only uses the software rasterizer and composes the screens in memory, so it needs
+ * no graphics context. The screens are composed like the default layout at native resolution,
+ * with the bottom screen centered below the top screen.
+ */
+class RendererSoftware : public RendererBase {
+public:
+    static constexpr u32 SCREENS_WIDTH = Core::kScreenTopWidth;
+    static constexpr u32 SCREENS_HEIGHT = Core::kScreenTopHeight + Core::kScreenBottomHeight;
+
+    explicit RendererSoftware(Frontend::EmuWindow& window);
+    ~RendererSoftware() override;
+
+    /// Swap buffers (render frame)
+    void SwapBuffers() override;
+
+    /// Initialize the renderer
+    ResultStatus Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+
+    /// Returns the screens of the last frame in RGBA8 from the top row
+    const std::vector<u8>& GetScreens() const {
+        return screens;
+    }
+
+private:
+    /// Draws the left eye image of a LCD to the screens at the position
+    void DrawScreen(int fb_id, u32 x, u32 y);
+
+    /// Fills a rectangle of the screens with a color
+    void FillScreens(u32 x, u32 y, u32 width, u32 height, u8 r, u8 g, u8 b);
+
+    std::vector<u8> screens;
+};
+
+/**
+ * Converts a framebuffer read by the LCDs, stored sideways in one of their pixel formats, to
+ * upright RGBA8 from the top row, stretched to the size. Returns false if the format is unknown.
+ * @param dest_stride Distance in bytes between the rows of dest
+ */
+bool DecodeLCDFramebuffer(const GPU::Regs::FramebufferConfig& framebuffer, const u8* source,
+                          u8* dest, std::size_t dest_stride, u32 width, u32 height);
+
+} // namespace VideoCore
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <vector>
 #include <boost/container/static_vector.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
@@ -16,6 +17,10 @@
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/rasterizer.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif
+
 using Pica::Rasterizer::Vertex;
 
 namespace Pica::Clipper {
@@ -84,17 +89,87 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-    using boost::container::static_vector;
+// NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
+// TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
+//       epsilon possible within float24 accuracy.
+static const float24 EPSILON = float24::FromFloat32(0.00001f);
+static const float24 f0 = float24::FromFloat32(0.0);
+static const float24 f1 = float24::FromFloat32(1.0);
+static const std::array<ClippingEdge, 7> clipping_edges = {{
+    {Common::MakeVec(-f1, f0, f0, f1)}, // x = +w
+    {Common::MakeVec(f1, f0, f0, f1)},  // x = -w
+    {Common::MakeVec(f0, -f1, f0, f1)}, // y = +w
+    {Common::MakeVec(f0, f1, f0, f1)},  // y = -w
+    {Common::MakeVec(f0, f0, -f1, f0)}, // z =  0
+    {Common::MakeVec(f0, f0, f1, f1)},  // z = -w
+    {Common::MakeVec(f0, f0, f0, f1),
+     Common::Vec4<float24>(f0, f0, f0, EPSILON)}, // w = EPSILON
+}};
+
+/// Bit of the outcode set when a vertex is outside the custom clipping plane
+constexpr u8 CUSTOM_EDGE_BIT = 1 << clipping_edges.size();
+
+/**
+ * Computes the outcodes of vertices: bit i is set if the vertex is outside clipping_edges[i], in
+ * the order the edges are clipped against.
+ */
+static void ComputeOutcodes(const OutputVertex* vertices, std::size_t count, u8* outcodes) {
+    std::size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    // Zero coefficients contribute zeros to the float24 dot products (PICA multiplications by
+    // infinity give 0), so each edge reduces to one addition with the same result. A NaN makes
+    // every dot product NaN, which is outside of every edge.
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 epsilon = _mm_set1_ps(EPSILON.ToFloat32());
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[i].pos));
+        __m128 y = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[i + 1].pos));
+        __m128 z = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[i + 2].pos));
+        __m128 w = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[i + 3].pos));
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        const __m128 ordered = _mm_and_ps(_mm_cmpord_ps(x, y), _mm_cmpord_ps(z, w));
+        const __m128 inside[7]{
+            _mm_cmpge_ps(_mm_sub_ps(w, x), zero), _mm_cmpge_ps(_mm_add_ps(x, w), zero),
+            _mm_cmpge_ps(_mm_sub_ps(w, y), zero), _mm_cmpge_ps(_mm_add_ps(y, w), zero),
+            _mm_cmple_ps(z, zero),                _mm_cmpge_ps(_mm_add_ps(z, w), zero),
+            _mm_cmpge_ps(_mm_add_ps(w, epsilon), zero),
+        };
+
+        int outside[4]{};
+        for (int edge = 0; edge < 7; ++edge) {
+            const int mask = ~_mm_movemask_ps(_mm_and_ps(inside[edge], ordered));
+            for (int lane = 0; lane < 4; ++lane) {
+                outside[lane] |= ((mask >> lane) & 1) << edge;
+            }
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            outcodes[i + lane] = static_cast<u8>(outside[lane]);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const Vertex vertex(vertices[i]);
+        u8 outcode = 0;
+        for (std::size_t edge = 0; edge < clipping_edges.size(); ++edge) {
+            if (clipping_edges[edge].IsOutSide(vertex)) {
+                outcode |= 1 << edge;
+            }
+        }
+        outcodes[i] = outcode;
+    }
 
-    // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
-    // the new edge (or less in degenerate cases). As such, we can say that each clipping plane
-    // introduces at most 1 new vertex to the polygon. Since we start with a triangle and have a
-    // fixed 6 clipping planes, the maximum number of vertices of the clipped polygon is 3 + 6 = 9.
-    static const std::size_t MAX_VERTICES = 9;
-    static_vector<Vertex, MAX_VERTICES> buffer_a = {v0, v1, v2};
-    static_vector<Vertex, MAX_VERTICES> buffer_b;
+    if (g_state.regs.rasterizer.clip_enable) {
+        const ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
+        for (i = 0; i < count; ++i) {
+            if (custom_edge.IsOutSide(Vertex(vertices[i]))) {
+                outcodes[i] |= CUSTOM_EDGE_BIT;
+            }
+        }
+    }
+}
 
+static void FlipQuaternionsIfOpposite(Vertex& v0, Vertex& v1, Vertex& v2) {
     auto FlipQuaternionIfOpposite = [](auto& a, const auto& b) {
         if (Common::Dot(a, b) < float24::Zero())
             a = a * float24::FromFloat32(-1.0f);
@@ -102,49 +177,90 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
 
     // Flip the quaternions if they are opposite to prevent interpolating them over the wrong
     // direction.
-    FlipQuaternionIfOpposite(buffer_a[1].quat, buffer_a[0].quat);
-    FlipQuaternionIfOpposite(buffer_a[2].quat, buffer_a[0].quat);
+    FlipQuaternionIfOpposite(v1.quat, v0.quat);
+    FlipQuaternionIfOpposite(v2.quat, v0.quat);
+}
+
+/// Converts the triangles of a clipped polygon to screen coordinates and adds them to the output
+template <typename Polygon>
+static void AddPolygon(Polygon& polygon, std::size_t size, std::vector<Vertex>& output) {
+    InitScreenCoordinates(polygon[0]);
+    InitScreenCoordinates(polygon[1]);
+
+    for (std::size_t i = 0; i < size - 2; i++) {
+        Vertex& vtx0 = polygon[0];
+        Vertex& vtx1 = polygon[i + 1];
+        Vertex& vtx2 = polygon[i + 2];
+
+        InitScreenCoordinates(vtx2);
+
+        LOG_TRACE(
+            Render_Software,
+            "Triangle {}/{} at position ({:.3}, {:.3}, {:.3}, {:.3f}), "
+            "({:.3}, {:.3}, {:.3}, {:.3}), ({:.3}, {:.3}, {:.3}, {:.3}) and "
+            "screen position ({:.2}, {:.2}, {:.2}), ({:.2}, {:.2}, {:.2}), ({:.2}, {:.2}, {:.2})",
+            i + 1, size - 2, vtx0.pos.x.ToFloat32(), vtx0.pos.y.ToFloat32(),
+            vtx0.pos.z.ToFloat32(), vtx0.pos.w.ToFloat32(), vtx1.pos.x.ToFloat32(),
+            vtx1.pos.y.ToFloat32(), vtx1.pos.z.ToFloat32(), vtx1.pos.w.ToFloat32(),
+            vtx2.pos.x.ToFloat32(), vtx2.pos.y.ToFloat32(), vtx2.pos.z.ToFloat32(),
+            vtx2.pos.w.ToFloat32(), vtx0.screenpos.x.ToFloat32(), vtx0.screenpos.y.ToFloat32(),
+            vtx0.screenpos.z.ToFloat32(), vtx1.screenpos.x.ToFloat32(),
+            vtx1.screenpos.y.ToFloat32(), vtx1.screenpos.z.ToFloat32(),
+            vtx2.screenpos.x.ToFloat32(), vtx2.screenpos.y.ToFloat32(),
+            vtx2.screenpos.z.ToFloat32());
+
+        output.push_back(vtx0);
+        output.push_back(vtx1);
+        output.push_back(vtx2);
+    }
+}
+
+/// Clips a triangle whose quaternions were flipped against all clipping edges
+static void ClipTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                         std::vector<Vertex>& output) {
+    // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
+    // the new edge (or less in degenerate cases). As such, we can say that each clipping plane
+    // introduces at most 1 new vertex to the polygon. Since we start with a triangle and have at
+    // most 8 clipping planes, the maximum number of vertices of the clipped polygon is 3 + 8 = 11.
+    constexpr std::size_t MAX_VERTICES = 3 + 8;
+
+    // The polygons are lists of indices into a pool of vertices, to which each clipping plane adds
+    // at most 2 vertices. Only new vertices are copied.
+    boost::container::static_vector<Vertex, 3 + 2 * 8> pool = {v0, v1, v2};
+    boost::container::static_vector<u8, MAX_VERTICES> buffer_a = {0, 1, 2};
+    boost::container::static_vector<u8, MAX_VERTICES> buffer_b;
 
     auto* output_list = &buffer_a;
     auto* input_list = &buffer_b;
 
-    // NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
-    // TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
-    //       epsilon possible within float24 accuracy.
-    static const float24 EPSILON = float24::FromFloat32(0.00001f);
-    static const float24 f0 = float24::FromFloat32(0.0);
-    static const float24 f1 = float24::FromFloat32(1.0);
-    static const std::array<ClippingEdge, 7> clipping_edges = {{
-        {Common::MakeVec(-f1, f0, f0, f1)}, // x = +w
-        {Common::MakeVec(f1, f0, f0, f1)},  // x = -w
-        {Common::MakeVec(f0, -f1, f0, f1)}, // y = +w
-        {Common::MakeVec(f0, f1, f0, f1)},  // y = -w
-        {Common::MakeVec(f0, f0, -f1, f0)}, // z =  0
-        {Common::MakeVec(f0, f0, f1, f1)},  // z = -w
-        {Common::MakeVec(f0, f0, f0, f1),
-         Common::Vec4<float24>(f0, f0, f0, EPSILON)}, // w = EPSILON
-    }};
-
     // Simple implementation of the Sutherland-Hodgman clipping algorithm.
-    // TODO: Make this less inefficient (currently lots of useless buffering overhead happens here)
     auto Clip = [&](const ClippingEdge& edge) {
         std::swap(input_list, output_list);
         output_list->clear();
 
-        const Vertex* reference_vertex = &input_list->back();
+        const auto AddIntersection = [&](u8 vertex, u8 reference_vertex) {
+            pool.push_back(edge.GetIntersection(pool[vertex], pool[reference_vertex]));
+            output_list->push_back(static_cast<u8>(pool.size() - 1));
+        };
+
+        u8 reference_vertex = input_list->back();
+        bool reference_inside = edge.IsInside(pool[reference_vertex]);
+
+        for (const u8 vertex : *input_list) {
+            const bool inside = edge.IsInside(pool[vertex]);
 
-        for (const auto& vertex : *input_list) {
             // NOTE: This algorithm changes vertex order in some cases!
-            if (edge.IsInside(vertex)) {
-                if (edge.IsOutSide(*reference_vertex)) {
-                    output_list->push_back(edge.GetIntersection(vertex, *reference_vertex));
+            if (inside) {
+                if (!reference_inside) {
+                    AddIntersection(vertex, reference_vertex);
                 }
 
                 output_list->push_back(vertex);
-            } else if (edge.IsInside(*reference_vertex)) {
-                output_list->push_back(edge.GetIntersection(vertex, *reference_vertex));
+            } else if (reference_inside) {
+                AddIntersection(vertex, reference_vertex);
             }
-            reference_vertex = &vertex;
+            reference_vertex = vertex;
+            reference_inside = inside;
         }
     };
 
@@ -164,33 +280,54 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             return;
     }
 
-    InitScreenCoordinates((*output_list)[0]);
-    InitScreenCoordinates((*output_list)[1]);
+    // Gather the polygon's vertices so that the pool isn't modified for vertices used twice
+    boost::container::static_vector<Vertex, MAX_VERTICES> polygon;
+    for (const u8 vertex : *output_list) {
+        polygon.push_back(pool[vertex]);
+    }
+    AddPolygon(polygon, polygon.size(), output);
+}
 
-    for (std::size_t i = 0; i < output_list->size() - 2; i++) {
-        Vertex& vtx0 = (*output_list)[0];
-        Vertex& vtx1 = (*output_list)[i + 1];
-        Vertex& vtx2 = (*output_list)[i + 2];
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+    static std::vector<Vertex> output;
+    output.clear();
 
-        InitScreenCoordinates(vtx2);
+    Vertex vtx0(v0), vtx1(v1), vtx2(v2);
+    FlipQuaternionsIfOpposite(vtx0, vtx1, vtx2);
+    ClipTriangle(vtx0, vtx1, vtx2, output);
+    Rasterizer::ProcessTriangles(output.data(), output.size() / 3);
+}
 
-        LOG_TRACE(
-            Render_Software,
-            "Triangle {}/{} at position ({:.3}, {:.3}, {:.3}, {:.3f}), "
-            "({:.3}, {:.3}, {:.3}, {:.3}), ({:.3}, {:.3}, {:.3}, {:.3}) and "
-            "screen position ({:.2}, {:.2}, {:.2}), ({:.2}, {:.2}, {:.2}), ({:.2}, {:.2}, {:.2})",
-            i + 1, output_list->size() - 2, vtx0.pos.x.ToFloat32(), vtx0.pos.y.ToFloat32(),
-            vtx0.pos.z.ToFloat32(), vtx0.pos.w.ToFloat32(), vtx1.pos.x.ToFloat32(),
-            vtx1.pos.y.ToFloat32(), vtx1.pos.z.ToFloat32(), vtx1.pos.w.ToFloat32(),
-            vtx2.pos.x.ToFloat32(), vtx2.pos.y.ToFloat32(), vtx2.pos.z.ToFloat32(),
-            vtx2.pos.w.ToFloat32(), vtx0.screenpos.x.ToFloat32(), vtx0.screenpos.y.ToFloat32(),
-            vtx0.screenpos.z.ToFloat32(), vtx1.screenpos.x.ToFloat32(),
-            vtx1.screenpos.y.ToFloat32(), vtx1.screenpos.z.ToFloat32(),
-            vtx2.screenpos.x.ToFloat32(), vtx2.screenpos.y.ToFloat32(),
-            vtx2.screenpos.z.ToFloat32());
+void ProcessTriangles(const OutputVertex* vertices, std::size_t count) {
+    static std::vector<u8> outcodes;
+    static std::vector<Vertex> output;
+    outcodes.resize(count * 3);
+    output.clear();
+
+    ComputeOutcodes(vertices, count * 3, outcodes.data());
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const u8* outcode = &outcodes[i * 3];
+        const u8 outside_any = outcode[0] | outcode[1] | outcode[2];
+        const u8 outside_all = outcode[0] & outcode[1] & outcode[2];
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        // Clipping against the first edge a vertex is outside of either removes the whole
+        // triangle, or creates new vertices that need the full clipper
+        const u8 first_edge = outside_any & -outside_any;
+        if (outside_all & first_edge) {
+            continue;
+        }
+
+        Vertex polygon[3]{vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]};
+        FlipQuaternionsIfOpposite(polygon[0], polygon[1], polygon[2]);
+        if (outside_any == 0) {
+            AddPolygon(polygon, 3, output);
+        } else {
+            ClipTriangle(polygon[0], polygon[1], polygon[2], output);
+        }
     }
+
+    Rasterizer::ProcessTriangles(output.data(), output.size() / 3);
 }
 
 } // namespace Pica::Clipper
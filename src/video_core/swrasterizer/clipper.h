@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
@@ -13,7 +15,15 @@ namespace Clipper {
 
 using Shader::OutputVertex;
 
+/// Clips a triangle and queues the result for rasterization
 void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
 
+/**
+ * Clips a batch of triangles, each given by three consecutive vertices, and queues the result for
+ * rasterization. Triangles entirely inside or outside of the clipping volume skip the clipper.
+ * The result is the same as calling ProcessTriangle for each triangle.
+ */
+void ProcessTriangles(const OutputVertex* vertices, std::size_t num_triangles);
+
 } // namespace Clipper
 } // namespace Pica
@@ -3,119 +3,402 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cmath>
 #include "video_core/swrasterizer/lighting.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace Pica {
 
-static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_t lut_index,
-                               u8 index, float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+void ConfigureLighting(LightingSetup& setup, const LightingRegs& lighting,
+                       const State::Lighting& lighting_state) {
+    setup.enabled = !lighting.disable;
+    if (!setup.enabled) {
+        return;
+    }
 
-    const auto& lut = lighting.luts[lut_index][index];
+    std::array<bool, LightingRegs::NumLightingSampler> used_luts{};
+
+    using Sampler = LightingRegs::LightingSampler;
+    const auto ConfigureSampler = [&](LightingSetup::Sampler& sampler, bool enabled, Sampler lut,
+                                      LightingRegs::LightingLutInput input, bool abs_input,
+                                      LightingRegs::LightingScale scale) {
+        // The spotlight LUTs of all lights are supported by the same configurations
+        const Sampler type = lut >= Sampler::SpotlightAttenuation ? Sampler::SpotlightAttenuation
+                                                                   : lut;
+        sampler.enabled =
+            enabled && LightingRegs::IsLightingSamplerSupported(lighting.config0.config, type);
+        if (!sampler.enabled) {
+            return;
+        }
+        sampler.input = input;
+        sampler.abs_input = abs_input;
+        sampler.scale = lighting.lut_scale.GetScale(scale);
+        sampler.lut = static_cast<std::size_t>(lut);
+        used_luts[sampler.lut] = true;
+    };
+
+    ConfigureSampler(setup.d0, lighting.config1.disable_lut_d0 == 0, Sampler::Distribution0,
+                     lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
+                     lighting.lut_scale.d0);
+    ConfigureSampler(setup.d1, lighting.config1.disable_lut_d1 == 0, Sampler::Distribution1,
+                     lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
+                     lighting.lut_scale.d1);
+    ConfigureSampler(setup.rr, lighting.config1.disable_lut_rr == 0, Sampler::ReflectRed,
+                     lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
+                     lighting.lut_scale.rr);
+    ConfigureSampler(setup.rg, lighting.config1.disable_lut_rg == 0, Sampler::ReflectGreen,
+                     lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
+                     lighting.lut_scale.rg);
+    ConfigureSampler(setup.rb, lighting.config1.disable_lut_rb == 0, Sampler::ReflectBlue,
+                     lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
+                     lighting.lut_scale.rb);
+    ConfigureSampler(setup.fr, lighting.config1.disable_lut_fr == 0, Sampler::Fresnel,
+                     lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
+                     lighting.lut_scale.fr);
+
+    setup.num_lights = lighting.max_light_index + 1;
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const unsigned num = lighting.light_enable.GetNum(light_index);
+        const auto& light_config = lighting.light[num];
+        LightingSetup::Light& light = setup.lights[light_index];
+
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        const Common::Vec3<s32> spot_dir{light_config.spot_x.Value(),
+                                         light_config.spot_y.Value(),
+                                         light_config.spot_z.Value()};
+        light.spot_direction = spot_dir.Cast<float>() / 2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+        light.shadow = !lighting.IsShadowDisabled(num);
+
+        light.dist_atten_enabled = !lighting.IsDistAttenDisabled(num);
+        if (light.dist_atten_enabled) {
+            light.dist_atten_scale =
+                Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+            light.dist_atten_bias =
+                Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+            light.dist_atten_lut =
+                static_cast<std::size_t>(LightingRegs::DistanceAttenuationSampler(num));
+            used_luts[light.dist_atten_lut] = true;
+        }
 
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
+        ConfigureSampler(light.spot, !lighting.IsSpotAttenDisabled(num),
+                         LightingRegs::SpotlightAttenuationSampler(num), lighting.lut_input.sp,
+                         lighting.abs_lut_input.disable_sp == 0, lighting.lut_scale.sp);
+    }
 
-    return lut_value + lut_diff * delta;
+    setup.bump_mode = lighting.config0.bump_mode;
+    setup.bump_selector = lighting.config0.bump_selector;
+    setup.bump_renorm = !lighting.config0.disable_bump_renorm;
+    setup.shadow_enabled = lighting.config0.enable_shadow != 0;
+    setup.shadow_selector = lighting.config0.shadow_selector;
+    setup.shadow_invert = lighting.config0.shadow_invert != 0;
+    setup.shadow_primary = lighting.config0.shadow_primary != 0;
+    setup.shadow_secondary = lighting.config0.shadow_secondary != 0;
+    setup.shadow_alpha = lighting.config0.shadow_alpha != 0;
+    setup.primary_alpha = lighting.config0.enable_primary_alpha != 0;
+    setup.secondary_alpha = lighting.config0.enable_secondary_alpha != 0;
+    setup.clamp_highlights = lighting.config0.clamp_highlights != 0;
+    setup.config7 = lighting.config0.config == LightingRegs::LightingConfig::Config7;
+    setup.global_ambient = lighting.global_ambient.ToVec3f();
+
+    setup.needs_half_vector = false;
+    setup.needs_tangent = false;
+    const auto CheckInput = [&setup](const LightingSetup::Sampler& sampler) {
+        if (!sampler.enabled) {
+            return;
+        }
+        using Input = LightingRegs::LightingLutInput;
+        setup.needs_half_vector |= sampler.input == Input::NH || sampler.input == Input::VH ||
+                                   (sampler.input == Input::CP && setup.config7);
+        setup.needs_tangent |= sampler.input == Input::CP && setup.config7;
+    };
+    for (const auto* sampler : {&setup.d0, &setup.d1, &setup.rr, &setup.rg, &setup.rb, &setup.fr}) {
+        CheckInput(*sampler);
+    }
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        CheckInput(setup.lights[light_index].spot);
+    }
+
+    for (std::size_t lut = 0; lut < used_luts.size(); ++lut) {
+        if (!used_luts[lut]) {
+            continue;
+        }
+        for (std::size_t i = 0; i < setup.luts[lut].size(); ++i) {
+            const auto& entry = lighting_state.luts[lut][i];
+            setup.luts[lut][i] = {entry.ToFloat(), entry.DiffToFloat()};
+        }
+    }
 }
 
-std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
-    const Common::Vec4<u8> (&texture_color)[4]) {
-
-    Common::Vec4<float> shadow;
-    if (lighting.config0.enable_shadow) {
-        shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
-        if (lighting.config0.shadow_invert) {
-            shadow = Common::MakeVec(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
+// The lighting computation below is instantiated for float, and for a vector of four floats which
+// processes four fragments with the exact same operations. The helpers follow the semantics of the
+// standard functions, so that both give bit-identical results.
+
+static float Sqrt(float value) {
+    return std::sqrt(value);
+}
+
+static float Abs(float value) {
+    return std::abs(value);
+}
+
+static float Min(float a, float b) {
+    return std::min(a, b);
+}
+
+static float Max(float a, float b) {
+    return std::max(a, b);
+}
+
+static float Clamp(float value, float min, float max) {
+    return std::clamp(value, min, max);
+}
+
+/// Returns zero_result if value is 0, or result otherwise
+static float IfZero(float value, float zero_result, float result) {
+    return value == 0.0f ? zero_result : result;
+}
+
+/// Looks up a LUT with an input in [0, 1]
+static float LookupUnsigned(const LightingSetup::Lut& lut, float input) {
+    const u8 index = static_cast<u8>(std::clamp(std::floor(input * 256.0f), 0.0f, 255.0f));
+    const float delta = input * 256 - index;
+    return lut[index].value + lut[index].difference * delta;
+}
+
+/// Looks up a LUT with an input in [-1, 1]
+static float LookupSigned(const LightingSetup::Lut& lut, float input) {
+    const float flr = std::floor(input * 128.0f);
+    const s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
+    const float delta = input * 128.0f - signed_index;
+    const u8 index = static_cast<u8>(signed_index);
+    return lut[index].value + lut[index].difference * delta;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Four float values, one for each of four fragments
+struct Float4 {
+    __m128 value;
+
+    Float4() = default;
+    Float4(float scalar) : value(_mm_set1_ps(scalar)) {}
+    explicit Float4(__m128 value) : value(value) {}
+
+    Float4 operator-() const {
+        return Float4(_mm_xor_ps(value, _mm_set1_ps(-0.0f)));
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) {
+        return Float4(_mm_add_ps(a.value, b.value));
+    }
+
+    friend Float4 operator-(Float4 a, Float4 b) {
+        return Float4(_mm_sub_ps(a.value, b.value));
+    }
+
+    friend Float4 operator*(Float4 a, Float4 b) {
+        return Float4(_mm_mul_ps(a.value, b.value));
+    }
+
+    friend Float4 operator/(Float4 a, Float4 b) {
+        return Float4(_mm_div_ps(a.value, b.value));
+    }
+
+    Float4& operator+=(Float4 other) {
+        return *this = *this + other;
+    }
+
+    Float4& operator*=(Float4 other) {
+        return *this = *this * other;
+    }
+};
+
+static Float4 Sqrt(Float4 value) {
+    return Float4(_mm_sqrt_ps(value.value));
+}
+
+static Float4 Abs(Float4 value) {
+    return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), value.value));
+}
+
+// std::min and std::max return their first argument if the comparison is false, unlike the
+// instructions, which return their second argument
+static Float4 Min(Float4 a, Float4 b) {
+    return Float4(_mm_min_ps(b.value, a.value));
+}
+
+static Float4 Max(Float4 a, Float4 b) {
+    return Float4(_mm_max_ps(b.value, a.value));
+}
+
+static Float4 Clamp(Float4 value, Float4 min, Float4 max) {
+    return Min(Max(value, min), max);
+}
+
+static Float4 IfZero(Float4 value, Float4 zero_result, Float4 result) {
+    const __m128 is_zero = _mm_cmpeq_ps(value.value, _mm_setzero_ps());
+    return Float4(_mm_or_ps(_mm_and_ps(is_zero, zero_result.value),
+                            _mm_andnot_ps(is_zero, result.value)));
+}
+
+static Float4 Lookup(const LightingSetup::Lut& lut, __m128i index, Float4 delta) {
+    alignas(16) s32 indices[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+    const auto& e0 = lut[indices[0]];
+    const auto& e1 = lut[indices[1]];
+    const auto& e2 = lut[indices[2]];
+    const auto& e3 = lut[indices[3]];
+    const Float4 value(_mm_setr_ps(e0.value, e1.value, e2.value, e3.value));
+    const Float4 difference(
+        _mm_setr_ps(e0.difference, e1.difference, e2.difference, e3.difference));
+    return value + difference * delta;
+}
+
+// Clamping before rounding down gives the same index as clamping the rounded value, and keeps the
+// value in the range of the conversion to integers
+static Float4 LookupUnsigned(const LightingSetup::Lut& lut, Float4 input) {
+    const Float4 scaled = input * 256.0f;
+    // Rounding towards zero is rounding down for positive values. NaN converts to 0x80000000, and
+    // is masked to the first entry like by the scalar conversion
+    const __m128i index = _mm_and_si128(
+        _mm_cvttps_epi32(Clamp(scaled, 0.0f, 255.0f).value), _mm_set1_epi32(0xFF));
+    return Lookup(lut, index, scaled - Float4(_mm_cvtepi32_ps(index)));
+}
+
+static Float4 LookupSigned(const LightingSetup::Lut& lut, Float4 input) {
+    const Float4 scaled = input * 128.0f;
+    const __m128 clamped = Clamp(scaled, -128.0f, 127.0f).value;
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(clamped));
+    // Negative values are rounded up by the truncation
+    truncated = _mm_sub_ps(truncated,
+                           _mm_and_ps(_mm_cmpgt_ps(truncated, clamped), _mm_set1_ps(1.0f)));
+    const __m128i signed_index = _mm_cvttps_epi32(truncated);
+    const __m128i index = _mm_and_si128(signed_index, _mm_set1_epi32(0xFF));
+    return Lookup(lut, index, scaled - Float4(truncated));
+}
+#endif
+
+template <typename T>
+static Common::Vec3<T> Broadcast(const Common::Vec3<float>& value) {
+    return {T(value.x), T(value.y), T(value.z)};
+}
+
+template <typename T>
+static T Length(const Common::Vec3<T>& value) {
+    return Sqrt(value.x * value.x + value.y * value.y + value.z * value.z);
+}
+
+template <typename T>
+static Common::Vec3<T> Normalized(const Common::Vec3<T>& value) {
+    return value / Length(value);
+}
+
+/**
+ * Computes the lighting of fragments.
+ * @param shadow_texel Texture color used for shadows, as floats in [0, 255]
+ * @param bump_texel Texture color used for bump mapping, as floats in [0, 255]
+ */
+template <typename T>
+static void ComputeLighting(const LightingSetup& setup, const Common::Quaternion<T>& normquat,
+                            const Common::Vec3<T>& view, const Common::Vec4<T>& shadow_texel,
+                            const Common::Vec3<T>& bump_texel, Common::Vec4<T>& diffuse_sum,
+                            Common::Vec4<T>& specular_sum) {
+    Common::Vec4<T> shadow;
+    if (setup.shadow_enabled) {
+        shadow = shadow_texel / 255.0f;
+        if (setup.shadow_invert) {
+            shadow = Common::MakeVec<T>(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
         }
     } else {
-        shadow = Common::MakeVec(1.0f, 1.0f, 1.0f, 1.0f);
+        shadow = Common::MakeVec<T>(1.0f, 1.0f, 1.0f, 1.0f);
     }
 
-    Common::Vec3<float> surface_normal;
-    Common::Vec3<float> surface_tangent;
-
-    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
-        Common::Vec3<float> perturbation =
-            texture_color[lighting.config0.bump_selector].xyz().Cast<float>() / 127.5f -
-            Common::MakeVec(1.0f, 1.0f, 1.0f);
-        if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
-            if (!lighting.config0.disable_bump_renorm) {
-                const float z_square = 1 - perturbation.xy().Length2();
-                perturbation.z = std::sqrt(std::max(z_square, 0.0f));
+    Common::Vec3<T> surface_normal;
+    Common::Vec3<T> surface_tangent;
+
+    if (setup.bump_mode != LightingRegs::LightingBumpMode::None) {
+        Common::Vec3<T> perturbation = bump_texel / 127.5f - Common::MakeVec<T>(1.0f, 1.0f, 1.0f);
+        if (setup.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
+            if (setup.bump_renorm) {
+                const T z_square = 1 - perturbation.xy().Length2();
+                perturbation.z = Sqrt(Max(z_square, 0.0f));
             }
             surface_normal = perturbation;
-            surface_tangent = Common::MakeVec(1.0f, 0.0f, 0.0f);
-        } else if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
-            surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
+            surface_tangent = Common::MakeVec<T>(1.0f, 0.0f, 0.0f);
+        } else if (setup.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
+            surface_normal = Common::MakeVec<T>(0.0f, 0.0f, 1.0f);
             surface_tangent = perturbation;
         } else {
-            LOG_ERROR(HW_GPU, "Unknown bump mode {}",
-                      static_cast<u32>(lighting.config0.bump_mode.Value()));
+            LOG_ERROR(HW_GPU, "Unknown bump mode {}", static_cast<u32>(setup.bump_mode));
         }
     } else {
-        surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
-        surface_tangent = Common::MakeVec(1.0f, 0.0f, 0.0f);
+        surface_normal = Common::MakeVec<T>(0.0f, 0.0f, 1.0f);
+        surface_tangent = Common::MakeVec<T>(1.0f, 0.0f, 0.0f);
     }
 
     // Use the normalized the quaternion when performing the rotation
-    auto normal = Common::QuaternionRotate(normquat, surface_normal);
-    auto tangent = Common::QuaternionRotate(normquat, surface_tangent);
+    const auto normal = Common::QuaternionRotate(normquat, surface_normal);
+    Common::Vec3<T> tangent;
+    if (setup.needs_tangent) {
+        tangent = Common::QuaternionRotate(normquat, surface_tangent);
+    }
 
-    Common::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
-    Common::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
+    diffuse_sum = Common::MakeVec<T>(0.0f, 0.0f, 0.0f, 1.0f);
+    specular_sum = Common::MakeVec<T>(0.0f, 0.0f, 0.0f, 1.0f);
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    const Common::Vec3<T> norm_view = Normalized(view);
 
-        Common::Vec3<float> refl_value = {};
-        Common::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                        float16::FromRaw(light_config.y).ToFloat32(),
-                                        float16::FromRaw(light_config.z).ToFloat32()};
-        Common::Vec3<float> light_vector;
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const LightingSetup::Light& light = setup.lights[light_index];
 
-        if (light_config.config.directional)
+        Common::Vec3<T> refl_value;
+        const Common::Vec3<T> position = Broadcast<T>(light.position);
+        Common::Vec3<T> light_vector;
+
+        if (light.directional)
             light_vector = position;
         else
             light_vector = position + view;
 
-        light_vector.Normalize();
-
-        Common::Vec3<float> norm_view = view.Normalized();
-        Common::Vec3<float> half_vector = norm_view + light_vector;
-
-        float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
-            std::size_t lut =
-                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
+        light_vector = Normalized(light_vector);
 
-            float sample_loc = std::clamp(scale * distance + bias, 0.0f, 1.0f);
+        const Common::Vec3<T> half_vector = norm_view + light_vector;
+        Common::Vec3<T> norm_half_vector;
+        if (setup.needs_half_vector) {
+            norm_half_vector = Normalized(half_vector);
+        }
 
-            u8 lutindex =
-                static_cast<u8>(std::clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
-            float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+        T dist_atten = 1.0f;
+        if (light.dist_atten_enabled) {
+            const T distance =
+                Length(Common::Vec3<T>{-view.x, -view.y, -view.z} - position);
+            const T sample_loc =
+                Clamp(light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
+            dist_atten = LookupUnsigned(setup.luts[light.dist_atten_lut], sample_loc);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
-                               LightingRegs::LightingSampler sampler) {
-            float result = 0.0f;
+        const auto GetLutValue = [&](const LightingSetup::Sampler& sampler) {
+            T result = 0.0f;
 
-            switch (input) {
+            switch (sampler.input) {
             case LightingRegs::LightingLutInput::NH:
-                result = Common::Dot(normal, half_vector.Normalized());
+                result = Common::Dot(normal, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::VH:
-                result = Common::Dot(norm_view, half_vector.Normalized());
+                result = Common::Dot(norm_view, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::NV:
@@ -126,207 +409,204 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
                 result = Common::Dot(light_vector, normal);
                 break;
 
-            case LightingRegs::LightingLutInput::SP: {
-                Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                           light_config.spot_z.Value()};
-                result = Common::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+            case LightingRegs::LightingLutInput::SP:
+                result = Common::Dot(light_vector, Broadcast<T>(light.spot_direction));
                 break;
-            }
+
             case LightingRegs::LightingLutInput::CP:
-                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
-                    const Common::Vec3<float> half_vector_proj =
+                if (setup.config7) {
+                    const Common::Vec3<T> half_vector_proj =
                         norm_half_vector - normal * Common::Dot(normal, norm_half_vector);
                     result = Common::Dot(half_vector_proj, tangent);
                 } else {
                     result = 0.0f;
                 }
                 break;
+
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(input));
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}",
+                             static_cast<u32>(sampler.input));
                 UNIMPLEMENTED();
                 result = 0.0f;
             }
 
-            u8 index;
-            float delta;
-
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
-                    result = std::abs(result);
-                else
-                    result = std::max(result, 0.0f);
-
-                float flr = std::floor(result * 256.0f);
-                index = static_cast<u8>(std::clamp(flr, 0.0f, 255.0f));
-                delta = result * 256 - index;
-            } else {
-                float flr = std::floor(result * 128.0f);
-                s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
-                delta = result * 128.0f - signed_index;
-                index = static_cast<u8>(signed_index);
+            const LightingSetup::Lut& lut = setup.luts[sampler.lut];
+            if (sampler.abs_input) {
+                result = light.two_sided_diffuse ? Abs(result) : Max(result, 0.0f);
+                return sampler.scale * LookupUnsigned(lut, result);
             }
-
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
-                                             index, delta);
+            return sampler.scale * LookupSigned(lut, result);
         };
 
         // If enabled, compute spot light attenuation value
-        float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        T spot_atten = 1.0f;
+        if (light.spot.enabled) {
+            spot_atten = GetLutValue(light.spot);
         }
 
         // Specular 0 component
-        float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        T d0_lut_value = 1.0f;
+        if (setup.d0.enabled) {
+            d0_lut_value = GetLutValue(setup.d0);
         }
 
-        Common::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Common::Vec3<T> specular_0 = d0_lut_value * Broadcast<T>(light.specular_0);
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
-        } else {
-            refl_value.x = 1.0f;
-        }
+        refl_value.x = setup.rr.enabled ? GetLutValue(setup.rr) : T(1.0f);
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
-        } else {
-            refl_value.y = refl_value.x;
-        }
+        refl_value.y = setup.rg.enabled ? GetLutValue(setup.rg) : refl_value.x;
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
-        } else {
-            refl_value.z = refl_value.x;
-        }
+        refl_value.z = setup.rb.enabled ? GetLutValue(setup.rb) : refl_value.x;
 
         // Specular 1 component
-        float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        T d1_lut_value = 1.0f;
+        if (setup.d1.enabled) {
+            d1_lut_value = GetLutValue(setup.d1);
         }
 
-        Common::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Common::Vec3<T> specular_1 = d1_lut_value * refl_value * Broadcast<T>(light.specular_1);
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == setup.num_lights - 1 && setup.fr.enabled) {
+            const T lut_value = GetLutValue(setup.fr);
 
             // Enabled for diffuse lighting alpha component
-            if (lighting.config0.enable_primary_alpha) {
+            if (setup.primary_alpha) {
                 diffuse_sum.a() = lut_value;
             }
 
             // Enabled for the specular lighting alpha component
-            if (lighting.config0.enable_secondary_alpha) {
+            if (setup.secondary_alpha) {
                 specular_sum.a() = lut_value;
             }
         }
 
-        auto dot_product = Common::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
-            dot_product = std::abs(dot_product);
+        T dot_product = Common::Dot(light_vector, normal);
+        if (light.two_sided_diffuse)
+            dot_product = Abs(dot_product);
         else
-            dot_product = std::max(dot_product, 0.0f);
+            dot_product = Max(dot_product, 0.0f);
 
-        float clamp_highlights = 1.0f;
-        if (lighting.config0.clamp_highlights) {
-            clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
+        T clamp_highlights = 1.0f;
+        if (setup.clamp_highlights) {
+            clamp_highlights = IfZero(dot_product, 0.0f, 1.0f);
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
-            float geo_factor = half_vector.Length2();
-            geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
+            T geo_factor = half_vector.Length2();
+            geo_factor = IfZero(geo_factor, 0.0f, Min(dot_product / geo_factor, 1.0f));
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (Broadcast<T>(light.diffuse) * dot_product + Broadcast<T>(light.ambient)) *
+                       dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
-            if (lighting.config0.shadow_primary) {
+        if (light.shadow) {
+            if (setup.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
-            if (lighting.config0.shadow_secondary) {
+            if (setup.shadow_secondary) {
                 specular = specular * shadow.xyz();
             }
         }
 
-        diffuse_sum += Common::MakeVec(diffuse, 0.0f);
-        specular_sum += Common::MakeVec(specular, 0.0f);
+        diffuse_sum += Common::MakeVec(diffuse, T(0.0f));
+        specular_sum += Common::MakeVec(specular, T(0.0f));
     }
 
-    if (lighting.config0.shadow_alpha) {
+    if (setup.shadow_alpha) {
         // Alpha shadow also uses the Fresnel selecotr to determine which alpha to apply
         // Enabled for diffuse lighting alpha component
-        if (lighting.config0.enable_primary_alpha) {
+        if (setup.primary_alpha) {
             diffuse_sum.a() *= shadow.w;
         }
 
         // Enabled for the specular lighting alpha component
-        if (lighting.config0.enable_secondary_alpha) {
+        if (setup.secondary_alpha) {
             specular_sum.a() *= shadow.w;
         }
     }
 
-    diffuse_sum += Common::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
-
-    auto diffuse = Common::MakeVec<float>(std::clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
-                                          std::clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
-                                          std::clamp(diffuse_sum.z, 0.0f, 1.0f) * 255,
-                                          std::clamp(diffuse_sum.w, 0.0f, 1.0f) * 255)
-                       .Cast<u8>();
-    auto specular = Common::MakeVec<float>(std::clamp(specular_sum.x, 0.0f, 1.0f) * 255,
-                                           std::clamp(specular_sum.y, 0.0f, 1.0f) * 255,
-                                           std::clamp(specular_sum.z, 0.0f, 1.0f) * 255,
-                                           std::clamp(specular_sum.w, 0.0f, 1.0f) * 255)
-                        .Cast<u8>();
-    return std::make_tuple(diffuse, specular);
+    diffuse_sum += Common::MakeVec(Broadcast<T>(setup.global_ambient), T(0.0f));
+}
+
+static Common::Vec4<u8> ToColor(const Common::Vec4<float>& sum) {
+    return Common::MakeVec<float>(std::clamp(sum.x, 0.0f, 1.0f) * 255,
+                                  std::clamp(sum.y, 0.0f, 1.0f) * 255,
+                                  std::clamp(sum.z, 0.0f, 1.0f) * 255,
+                                  std::clamp(sum.w, 0.0f, 1.0f) * 255)
+        .Cast<u8>();
+}
+
+std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
+    const LightingSetup& setup, const Common::Quaternion<float>& normquat,
+    const Common::Vec3<float>& view, const std::array<Common::Vec4<u8>, 4>& texture_color) {
+    const Common::Vec4<float> shadow_texel = texture_color[setup.shadow_selector].Cast<float>();
+    const Common::Vec3<float> bump_texel = texture_color[setup.bump_selector].xyz().Cast<float>();
+
+    Common::Vec4<float> diffuse_sum;
+    Common::Vec4<float> specular_sum;
+    ComputeLighting(setup, normquat, view, shadow_texel, bump_texel, diffuse_sum, specular_sum);
+    return std::make_tuple(ToColor(diffuse_sum), ToColor(specular_sum));
+}
+
+#ifdef ARCHITECTURE_x86_64
+void ComputeFragmentsColors4(const LightingSetup& setup,
+                             const Common::Quaternion<float> (&normquat)[4],
+                             const Common::Vec3<float> (&view)[4],
+                             const std::array<Common::Vec4<u8>, 4>* const (&texture_color)[4],
+                             Common::Vec4<u8> (&primary_color)[4],
+                             Common::Vec4<u8> (&secondary_color)[4]) {
+    const auto Gather = [](auto GetValue) {
+        return Float4(_mm_setr_ps(GetValue(0), GetValue(1), GetValue(2), GetValue(3)));
+    };
+    const auto GatherTexel = [&](unsigned selector, std::size_t component) {
+        return Gather(
+            [&](int i) { return static_cast<float>((*texture_color[i])[selector][component]); });
+    };
+
+    const Common::Quaternion<Float4> normquat4{
+        {Gather([&](int i) { return normquat[i].xyz.x; }),
+         Gather([&](int i) { return normquat[i].xyz.y; }),
+         Gather([&](int i) { return normquat[i].xyz.z; })},
+        Gather([&](int i) { return normquat[i].w; }),
+    };
+    const Common::Vec3<Float4> view4{Gather([&](int i) { return view[i].x; }),
+                                     Gather([&](int i) { return view[i].y; }),
+                                     Gather([&](int i) { return view[i].z; })};
+    const Common::Vec4<Float4> shadow_texel{
+        GatherTexel(setup.shadow_selector, 0), GatherTexel(setup.shadow_selector, 1),
+        GatherTexel(setup.shadow_selector, 2), GatherTexel(setup.shadow_selector, 3)};
+    const Common::Vec3<Float4> bump_texel{GatherTexel(setup.bump_selector, 0),
+                                          GatherTexel(setup.bump_selector, 1),
+                                          GatherTexel(setup.bump_selector, 2)};
+
+    Common::Vec4<Float4> diffuse_sum;
+    Common::Vec4<Float4> specular_sum;
+    ComputeLighting(setup, normquat4, view4, shadow_texel, bump_texel, diffuse_sum, specular_sum);
+
+    alignas(16) float diffuse[4][4];
+    alignas(16) float specular[4][4];
+    for (std::size_t component = 0; component < 4; ++component) {
+        _mm_store_ps(diffuse[component], diffuse_sum[component].value);
+        _mm_store_ps(specular[component], specular_sum[component].value);
+    }
+    for (int i = 0; i < 4; ++i) {
+        primary_color[i] = ToColor({diffuse[0][i], diffuse[1][i], diffuse[2][i], diffuse[3][i]});
+        secondary_color[i] =
+            ToColor({specular[0][i], specular[1][i], specular[2][i], specular[3][i]});
+    }
 }
+#endif
 
 } // namespace Pica
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,9 +12,98 @@
 
 namespace Pica {
 
+/**
+ * Lighting configuration shared by all fragments of a draw: the registers decoded once, and the
+ * LUTs they use converted to floats.
+ */
+struct LightingSetup {
+    struct LutEntry {
+        float value;
+        float difference;
+    };
+    using Lut = std::array<LutEntry, 256>;
+
+    /// A LUT lookup of the lighting computation
+    struct Sampler {
+        bool enabled = false;
+        LightingRegs::LightingLutInput input{};
+        bool abs_input = false;
+        float scale = 1.0f;
+        std::size_t lut = 0;
+    };
+
+    struct Light {
+        Common::Vec3<float> position;
+        Common::Vec3<float> spot_direction;
+        Common::Vec3<float> specular_0;
+        Common::Vec3<float> specular_1;
+        Common::Vec3<float> diffuse;
+        Common::Vec3<float> ambient;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool shadow;
+        bool dist_atten_enabled;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        std::size_t dist_atten_lut;
+        Sampler spot;
+    };
+
+    bool enabled = false;
+    unsigned num_lights = 0;
+    std::array<Light, 8> lights;
+
+    Sampler d0;
+    Sampler d1;
+    Sampler rr;
+    Sampler rg;
+    Sampler rb;
+    Sampler fr;
+
+    LightingRegs::LightingBumpMode bump_mode{};
+    unsigned bump_selector = 0;
+    bool bump_renorm = false;
+
+    bool shadow_enabled = false;
+    unsigned shadow_selector = 0;
+    bool shadow_invert = false;
+    bool shadow_primary = false;
+    bool shadow_secondary = false;
+    bool shadow_alpha = false;
+
+    bool primary_alpha = false;
+    bool secondary_alpha = false;
+    bool clamp_highlights = false;
+    bool config7 = false;
+    Common::Vec3<float> global_ambient;
+
+    /// Whether any lookup uses the normalized half vector or the tangent
+    bool needs_half_vector = false;
+    bool needs_tangent = false;
+
+    /// Only the LUTs used by the samplers are converted
+    std::array<Lut, LightingRegs::NumLightingSampler> luts;
+};
+
+/// Decodes the lighting registers, and converts the LUTs they use
+void ConfigureLighting(LightingSetup& setup, const LightingRegs& lighting,
+                       const State::Lighting& lighting_state);
+
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
-    const Common::Vec4<u8> (&texture_color)[4]);
+    const LightingSetup& setup, const Common::Quaternion<float>& normquat,
+    const Common::Vec3<float>& view, const std::array<Common::Vec4<u8>, 4>& texture_color);
+
+#ifdef ARCHITECTURE_x86_64
+/// Computes the lighting of four fragments at once. The result is the same as
+/// ComputeFragmentsColors for each fragment.
+void ComputeFragmentsColors4(const LightingSetup& setup,
+                             const Common::Quaternion<float> (&normquat)[4],
+                             const Common::Vec3<float> (&view)[4],
+                             const std::array<Common::Vec4<u8>, 4>* const (&texture_color)[4],
+                             Common::Vec4<u8> (&primary_color)[4],
+                             Common::Vec4<u8> (&secondary_color)[4]);
+#endif
 
 } // namespace Pica
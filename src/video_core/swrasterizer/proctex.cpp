@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <thread>
 #include "common/math_util.h"
 #include "video_core/swrasterizer/proctex.h"
 
@@ -45,7 +48,7 @@ static float NoiseRand2D(unsigned int x, unsigned int y) {
     return -1.0f + v2 * 2.0f / 15.0f;
 }
 
-static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex state) {
+static float NoiseCoef(float u, float v, const TexturingRegs& regs, const State::ProcTex& state) {
     const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
     const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
     const float phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
@@ -154,7 +157,8 @@ float CombineAndMap(float u, float v, ProcTexCombiner combiner,
     return LookupLUT(map_table, f);
 }
 
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state) {
+Common::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs,
+                         const State::ProcTex& state) {
     u = std::abs(u);
     v = std::abs(v);
 
@@ -218,4 +222,131 @@ Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex st
     }
 }
 
+// The generated texture has samples at multiples of 1 / TEXELS_PER_UNIT, which is finer than the
+// 128 entries of the map LUTs over [0, 1]. It covers coordinates up to CACHE_RANGE, and is
+// generated lazily in tiles of TILE_SIZE * TILE_SIZE samples.
+constexpr u32 TEXELS_PER_UNIT = 256;
+constexpr float CACHE_RANGE = 6.0f;
+constexpr u32 CACHE_SIZE = static_cast<u32>(CACHE_RANGE) * TEXELS_PER_UNIT + 1;
+constexpr u32 TILE_SIZE = 16;
+constexpr u32 TILES_PER_ROW = (CACHE_SIZE + TILE_SIZE - 1) / TILE_SIZE;
+
+// Noise with a lattice finer than this many samples per cell isn't represented by the texture
+constexpr float MIN_SAMPLES_PER_NOISE_CELL = 8.0f;
+
+enum class TileState : u8 {
+    Empty,
+    Generating,
+    Ready,
+};
+
+struct ProcTexCache {
+    std::array<Common::Vec4<u8>, CACHE_SIZE * CACHE_SIZE> samples;
+    std::array<std::atomic<TileState>, TILES_PER_ROW * TILES_PER_ROW> tile_states{};
+};
+
+static ProcTexCache& GetProcTexCache() {
+    static const std::unique_ptr<ProcTexCache> cache = std::make_unique<ProcTexCache>();
+    return *cache;
+}
+
+/**
+ * Maps a coordinate beyond the generated texture to one inside it with the same result, if there
+ * is no noise. The shift of the other coordinate repeats every 4 units, every clamp mode repeats
+ * with a period dividing 4 or is constant beyond 2.
+ */
+static float ReduceCoord(float coord) {
+    if (coord < CACHE_RANGE) {
+        return coord;
+    }
+    return 2.0f + std::fmod(coord - 2.0f, 4.0f);
+}
+
+/// Generates the tile if needed. Waits if another thread is generating it.
+static void GenerateTile(ProcTexCache& cache, u32 tile_x, u32 tile_y, const TexturingRegs& regs,
+                         const State::ProcTex& state) {
+    std::atomic<TileState>& tile_state = cache.tile_states[tile_y * TILES_PER_ROW + tile_x];
+    TileState expected = tile_state.load(std::memory_order_acquire);
+    while (expected != TileState::Ready) {
+        if (expected == TileState::Empty &&
+            tile_state.compare_exchange_weak(expected, TileState::Generating,
+                                             std::memory_order_acquire)) {
+            break;
+        }
+        if (expected == TileState::Generating) {
+            // A tile takes microseconds to generate
+            std::this_thread::yield();
+            expected = tile_state.load(std::memory_order_acquire);
+        }
+    }
+    if (expected == TileState::Ready) {
+        return;
+    }
+
+    const u32 end_x = std::min((tile_x + 1) * TILE_SIZE, CACHE_SIZE);
+    const u32 end_y = std::min((tile_y + 1) * TILE_SIZE, CACHE_SIZE);
+    for (u32 y = tile_y * TILE_SIZE; y < end_y; ++y) {
+        for (u32 x = tile_x * TILE_SIZE; x < end_x; ++x) {
+            cache.samples[y * CACHE_SIZE + x] =
+                ProcTex(static_cast<float>(x) / TEXELS_PER_UNIT,
+                        static_cast<float>(y) / TEXELS_PER_UNIT, regs, state);
+        }
+    }
+
+    tile_state.store(TileState::Ready, std::memory_order_release);
+}
+
+Common::Vec4<u8> GetCachedProcTex(float u, float v, const TexturingRegs& regs,
+                                  const State::ProcTex& state) {
+    u = std::abs(u);
+    v = std::abs(v);
+
+    if (regs.proctex.noise_enable) {
+        const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
+        const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
+        // NoiseCoef has 9 * frequency cells per unit
+        if (9 * std::max(std::abs(freq_u), std::abs(freq_v)) * MIN_SAMPLES_PER_NOISE_CELL >
+            TEXELS_PER_UNIT) {
+            return ProcTex(u, v, regs, state);
+        }
+    } else {
+        u = ReduceCoord(u);
+        v = ReduceCoord(v);
+    }
+
+    if (!(u < CACHE_RANGE && v < CACHE_RANGE)) {
+        return ProcTex(u, v, regs, state);
+    }
+
+    const float x = u * TEXELS_PER_UNIT;
+    const float y = v * TEXELS_PER_UNIT;
+    const u32 x0 = std::min(static_cast<u32>(x), CACHE_SIZE - 2);
+    const u32 y0 = std::min(static_cast<u32>(y), CACHE_SIZE - 2);
+
+    // The four samples can be in up to four tiles
+    ProcTexCache& cache = GetProcTexCache();
+    for (u32 tile_y = y0 / TILE_SIZE; tile_y <= (y0 + 1) / TILE_SIZE; ++tile_y) {
+        for (u32 tile_x = x0 / TILE_SIZE; tile_x <= (x0 + 1) / TILE_SIZE; ++tile_x) {
+            GenerateTile(cache, tile_x, tile_y, regs, state);
+        }
+    }
+
+    const Common::Vec4<u8>* const row0 = &cache.samples[y0 * CACHE_SIZE + x0];
+    const Common::Vec4<u8>* const row1 = row0 + CACHE_SIZE;
+    const float frac_x = x - x0;
+    const float frac_y = y - y0;
+    const Common::Vec4<float> color =
+        Common::BilinearInterp(row0[0].Cast<float>(), row0[1].Cast<float>(),
+                               row1[0].Cast<float>(), row1[1].Cast<float>(), frac_x, frac_y);
+    return Common::MakeVec(std::round(color.r()), std::round(color.g()), std::round(color.b()),
+                           std::round(color.a()))
+        .Cast<u8>();
+}
+
+void InvalidateProcTexCache() {
+    for (std::atomic<TileState>& tile_state : GetProcTexCache().tile_states) {
+        tile_state.store(TileState::Empty, std::memory_order_relaxed);
+    }
+}
+
 } // namespace Pica::Rasterizer
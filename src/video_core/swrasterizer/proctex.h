@@ -9,6 +9,18 @@
 namespace Pica::Rasterizer {
 
 /// Generates procedural texture color for the given coordinates
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+Common::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs,
+                         const State::ProcTex& state);
+
+/**
+ * Returns the procedural texture color for the given coordinates, filtered from the procedural
+ * texture generated once at a fixed resolution. Coordinates the generated texture doesn't cover,
+ * and high frequency noise, fall back to ProcTex. Safe to call from the rasterizer worker threads.
+ */
+Common::Vec4<u8> GetCachedProcTex(float u, float v, const TexturingRegs& regs,
+                                  const State::ProcTex& state);
+
+/// Drops the generated procedural texture. Must be called when the ProcTex registers change.
+void InvalidateProcTexCache();
 
 } // namespace Pica::Rasterizer
@@ -4,17 +4,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <future>
+#include <thread>
 #include <tuple>
+#include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/math_util.h"
 #include "common/quaternion.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
@@ -26,11 +33,16 @@
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace Pica::Rasterizer {
 
 // NOTE: Assuming that rasterizer coordinates are 12.4 fixed-point values
@@ -116,70 +128,475 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
     return std::make_tuple(x / z * half + half, y / z * half + half, z_abs, addr);
 }
 
+// vertex positions in rasterizer coordinates
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+static Common::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Common::Vec3<float24>& vec) {
+    return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
 /**
- * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * Calculate the pixel-aligned bounding box (in 12.4 fixed point) of the triangle, restricted to
+ * the scissor box if the scissor mode is set to Include.
  */
-static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+static Common::Rectangle<u16> GetBoundingBox(const Common::Vec3<Fix12P4> (&vtxpos)[3]) {
     const auto& regs = g_state.regs;
 
-    // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+
+    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
+        // Convert the scissor box coordinates to 12.4 fixed point
+        // x2,y2 have +1 added to cover the entire sub-pixel area
+        min_x = std::max(min_x, (u16)(regs.rasterizer.scissor_test.x1 << 4));
+        min_y = std::max(min_y, (u16)(regs.rasterizer.scissor_test.y1 << 4));
+        max_x = std::min(max_x, (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4));
+        max_y = std::min(max_y, (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4));
+    }
+
+    min_x &= Fix12P4::IntMask();
+    min_y &= Fix12P4::IntMask();
+    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
+    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
+
+    return {min_x, min_y, max_x, max_y};
+}
+
+/// Per-triangle values used to compute the fragments covered by the triangle
+struct TriangleSetup {
+    const Vertex& v0;
+    const Vertex& v1;
+    const Vertex& v2;
+    Common::Vec3<Fix12P4> vtxpos[3];
+    int bias0;
+    int bias1;
+    int bias2;
+    Common::Vec3<float24> w_inverse;
+    float depth_scale;
+    float depth_offset;
+    bool w_buffer;
+};
+
+/// Interpolated values of a pixel covered by a triangle, ready to be shaded
+struct Fragment {
+    u16 x;
+    Common::Vec3<float24> baricentric_coordinates;
+    float24 interpolated_w_inverse;
+    float depth;
+    Common::Vec4<float24> color;
+    Common::Vec2<float24> uv[3];
+};
+
+// Perspective correct attribute interpolation:
+// Attribute values cannot be calculated by simple linear interpolation since
+// they are not linear in screen space. For example, when interpolating a
+// texture coordinate across two vertices, something simple like
+//     u = (u0*w0 + u1*w1)/(w0+w1)
+// will not work. However, the attribute value divided by the
+// clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+// in screenspace. Hence, we can linearly interpolate these two independently and
+// calculate the interpolated attribute by dividing the results.
+// I.e.
+//     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+//     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+//     u = u_over_w / one_over_w
+//
+// The generalization to three vertices is straightforward in baricentric coordinates.
+static float24 GetInterpolatedAttribute(const Fragment& fragment, float24 attr0, float24 attr1,
+                                        float24 attr2) {
+    auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
+    float24 interpolated_attr_over_w = Common::Dot(attr_over_w, fragment.baricentric_coordinates);
+    return interpolated_attr_over_w * fragment.interpolated_w_inverse;
+}
+
+/// Converts a depth value in [0, 1] to the integer representation of the depth buffer
+static u32 DepthToInt(float depth) {
+    unsigned num_bits =
+        FramebufferRegs::DepthBitsPerPixel(g_state.regs.framebuffer.framebuffer.depth_format);
+    return (u32)(depth * ((1 << num_bits) - 1));
+}
+
+static bool DepthTestPasses(FramebufferRegs::CompareFunc func, u32 z, u32 ref_z) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+
+    case FramebufferRegs::CompareFunc::Equal:
+        return z == ref_z;
+
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return z != ref_z;
+
+    case FramebufferRegs::CompareFunc::LessThan:
+        return z < ref_z;
+
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return z <= ref_z;
+
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return z > ref_z;
+
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return z >= ref_z;
+    }
+
+    return false;
+}
+
+/**
+ * Computes the fragment of the given pixel. This is the reference implementation for the
+ * vectorized versions below, which must produce bit-identical results.
+ * @returns false if the pixel is not covered by the triangle
+ */
+static bool SetupFragment(const TriangleSetup& setup, u16 x, u16 y, Fragment& fragment) {
+    const auto& vtxpos = setup.vtxpos;
+    const Vertex& v0 = setup.v0;
+    const Vertex& v1 = setup.v1;
+    const Vertex& v2 = setup.v2;
+
+    // Calculate the barycentric coordinates w0, w1 and w2
+    int w0 = setup.bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
+    int w1 = setup.bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
+    int w2 = setup.bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+    int wsum = w0 + w1 + w2;
+
+    // If current pixel is not covered by the current primitive
+    if (w0 < 0 || w1 < 0 || w2 < 0)
+        return false;
+
+    fragment.x = x;
+    fragment.baricentric_coordinates =
+        Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                        float24::FromFloat32(static_cast<float>(w1)),
+                        float24::FromFloat32(static_cast<float>(w2)));
+    fragment.interpolated_w_inverse =
+        float24::FromFloat32(1.0f) / Common::Dot(setup.w_inverse, fragment.baricentric_coordinates);
+
+    // interpolated_z = z / w
+    float interpolated_z_over_w =
+        (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+         v2.screenpos[2].ToFloat32() * w2) /
+        wsum;
+
+    // Not fully accurate. About 3 bits in precision are missing.
+    // Z-Buffer (z / w * scale + offset)
+    float depth = interpolated_z_over_w * setup.depth_scale + setup.depth_offset;
+
+    // Potentially switch to W-Buffer
+    if (setup.w_buffer) {
+        // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+        depth *= fragment.interpolated_w_inverse.ToFloat32() * wsum;
+    }
+
+    // Clamp the result
+    fragment.depth = std::clamp(depth, 0.0f, 1.0f);
+
+    fragment.color = Common::MakeVec(
+        GetInterpolatedAttribute(fragment, v0.color.r(), v1.color.r(), v2.color.r()),
+        GetInterpolatedAttribute(fragment, v0.color.g(), v1.color.g(), v2.color.g()),
+        GetInterpolatedAttribute(fragment, v0.color.b(), v1.color.b(), v2.color.b()),
+        GetInterpolatedAttribute(fragment, v0.color.a(), v1.color.a(), v2.color.a()));
+
+    fragment.uv[0].u() = GetInterpolatedAttribute(fragment, v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+    fragment.uv[0].v() = GetInterpolatedAttribute(fragment, v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
+    fragment.uv[1].u() = GetInterpolatedAttribute(fragment, v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
+    fragment.uv[1].v() = GetInterpolatedAttribute(fragment, v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
+    fragment.uv[2].u() = GetInterpolatedAttribute(fragment, v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
+    fragment.uv[2].v() = GetInterpolatedAttribute(fragment, v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+
+    return true;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Multiplies two vectors of float24 values, following the semantics of float24::operator*
+static __m128 MulFloat24(__m128 a, __m128 b) {
+    const __m128 result = _mm_mul_ps(a, b);
+    // PICA gives 0 instead of NaN when multiplying by inf
+    const __m128 result_nan = _mm_cmpunord_ps(result, result);
+    const __m128 input_nan = _mm_cmpunord_ps(a, b);
+    return _mm_andnot_ps(_mm_andnot_ps(input_nan, result_nan), result);
+}
+
+/// Interpolates a vertex attribute for four fragments, see GetInterpolatedAttribute
+static __m128 InterpolateAttribute4(const __m128 (&baricentric_coordinates)[3],
+                                    __m128 interpolated_w_inverse, float24 attr0, float24 attr1,
+                                    float24 attr2) {
+    const __m128 interpolated_attr_over_w = _mm_add_ps(
+        _mm_add_ps(MulFloat24(_mm_set1_ps(attr0.ToFloat32()), baricentric_coordinates[0]),
+                   MulFloat24(_mm_set1_ps(attr1.ToFloat32()), baricentric_coordinates[1])),
+        MulFloat24(_mm_set1_ps(attr2.ToFloat32()), baricentric_coordinates[2]));
+    return MulFloat24(interpolated_attr_over_w, interpolated_w_inverse);
+}
+
+/**
+ * Computes the fragments of four horizontally adjacent pixels, starting at the given one.
+ * @returns a mask with bit i set if pixel i is covered by the triangle
+ */
+static int SetupFragments4(const TriangleSetup& setup, u16 x, u16 y, Fragment (&fragments)[4]) {
+    const auto& vtxpos = setup.vtxpos;
+    const Vertex& v0 = setup.v0;
+    const Vertex& v1 = setup.v1;
+    const Vertex& v2 = setup.v2;
+
+    // The edge functions are linear in x, so the other pixels of the group are reached by adding
+    // multiples of the per-pixel step. This is exact as everything is integer math.
+    const auto EdgeFunction = [x, y](int bias, const Common::Vec2<Fix12P4>& vtx1,
+                                     const Common::Vec2<Fix12P4>& vtx2) {
+        const int w = bias + SignedArea(vtx1, vtx2, {x, y});
+        const int step = -((int)vtx2.y - (int)vtx1.y) * 0x10;
+        return _mm_add_epi32(_mm_set1_epi32(w), _mm_setr_epi32(0, step, 2 * step, 3 * step));
     };
-    static auto ScreenToRasterizerCoordinates = [](const Common::Vec3<float24>& vec) {
-        return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+    const __m128i w0 = EdgeFunction(setup.bias0, vtxpos[1].xy(), vtxpos[2].xy());
+    const __m128i w1 = EdgeFunction(setup.bias1, vtxpos[2].xy(), vtxpos[0].xy());
+    const __m128i w2 = EdgeFunction(setup.bias2, vtxpos[0].xy(), vtxpos[1].xy());
+
+    // A pixel is covered if none of its barycentric coordinates is negative
+    const int coverage =
+        ~_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(w0, w1), w2))) & 0xF;
+    if (coverage == 0) {
+        return 0;
+    }
+
+    const __m128 wsum = _mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(w0, w1), w2));
+    const __m128 baricentric_coordinates[3]{_mm_cvtepi32_ps(w0), _mm_cvtepi32_ps(w1),
+                                            _mm_cvtepi32_ps(w2)};
+    const __m128 interpolated_w_inverse = _mm_div_ps(
+        _mm_set1_ps(1.0f),
+        _mm_add_ps(_mm_add_ps(MulFloat24(_mm_set1_ps(setup.w_inverse.x.ToFloat32()),
+                                         baricentric_coordinates[0]),
+                              MulFloat24(_mm_set1_ps(setup.w_inverse.y.ToFloat32()),
+                                         baricentric_coordinates[1])),
+                   MulFloat24(_mm_set1_ps(setup.w_inverse.z.ToFloat32()),
+                              baricentric_coordinates[2])));
+
+    const __m128 interpolated_z_over_w = _mm_div_ps(
+        _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(v0.screenpos[2].ToFloat32()), baricentric_coordinates[0]),
+                _mm_mul_ps(_mm_set1_ps(v1.screenpos[2].ToFloat32()), baricentric_coordinates[1])),
+            _mm_mul_ps(_mm_set1_ps(v2.screenpos[2].ToFloat32()), baricentric_coordinates[2])),
+        wsum);
+    __m128 depth = _mm_add_ps(_mm_mul_ps(interpolated_z_over_w, _mm_set1_ps(setup.depth_scale)),
+                              _mm_set1_ps(setup.depth_offset));
+    if (setup.w_buffer) {
+        depth = _mm_mul_ps(depth, _mm_mul_ps(interpolated_w_inverse, wsum));
+    }
+
+    const auto Interpolate = [&](float24 attr0, float24 attr1, float24 attr2) {
+        return InterpolateAttribute4(baricentric_coordinates, interpolated_w_inverse, attr0,
+                                     attr1, attr2);
+    };
+    const __m128 attributes[10]{
+        Interpolate(v0.color.r(), v1.color.r(), v2.color.r()),
+        Interpolate(v0.color.g(), v1.color.g(), v2.color.g()),
+        Interpolate(v0.color.b(), v1.color.b(), v2.color.b()),
+        Interpolate(v0.color.a(), v1.color.a(), v2.color.a()),
+        Interpolate(v0.tc0.u(), v1.tc0.u(), v2.tc0.u()),
+        Interpolate(v0.tc0.v(), v1.tc0.v(), v2.tc0.v()),
+        Interpolate(v0.tc1.u(), v1.tc1.u(), v2.tc1.u()),
+        Interpolate(v0.tc1.v(), v1.tc1.v(), v2.tc1.v()),
+        Interpolate(v0.tc2.u(), v1.tc2.u(), v2.tc2.u()),
+        Interpolate(v0.tc2.v(), v1.tc2.v(), v2.tc2.v()),
     };
 
-    Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
-                                    ScreenToRasterizerCoordinates(v1.screenpos),
-                                    ScreenToRasterizerCoordinates(v2.screenpos)};
+    alignas(16) float lanes[15][4];
+    _mm_store_ps(lanes[0], baricentric_coordinates[0]);
+    _mm_store_ps(lanes[1], baricentric_coordinates[1]);
+    _mm_store_ps(lanes[2], baricentric_coordinates[2]);
+    _mm_store_ps(lanes[3], interpolated_w_inverse);
+    _mm_store_ps(lanes[4], depth);
+    for (std::size_t i = 0; i < 10; ++i) {
+        _mm_store_ps(lanes[5 + i], attributes[i]);
+    }
 
-    if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
-        // Make sure we always end up with a triangle wound counter-clockwise
-        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+    for (int i = 0; i < 4; ++i) {
+        Fragment& fragment = fragments[i];
+        fragment.x = x + i * 0x10;
+        fragment.baricentric_coordinates =
+            Common::MakeVec(float24::FromFloat32(lanes[0][i]), float24::FromFloat32(lanes[1][i]),
+                            float24::FromFloat32(lanes[2][i]));
+        fragment.interpolated_w_inverse = float24::FromFloat32(lanes[3][i]);
+        fragment.depth = std::clamp(lanes[4][i], 0.0f, 1.0f);
+        fragment.color =
+            Common::MakeVec(float24::FromFloat32(lanes[5][i]), float24::FromFloat32(lanes[6][i]),
+                            float24::FromFloat32(lanes[7][i]), float24::FromFloat32(lanes[8][i]));
+        for (std::size_t j = 0; j < 3; ++j) {
+            fragment.uv[j] = Common::MakeVec(float24::FromFloat32(lanes[9 + 2 * j][i]),
+                                             float24::FromFloat32(lanes[10 + 2 * j][i]));
         }
-    } else {
-        if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
-            // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+    }
+
+    return coverage;
+}
+#endif
+
+/**
+ * Computes the fragments of the pixels of a row that are covered by the triangle, skipping
+ * pixels which are excluded by the scissor test. If early_depth_test is true, fragments which
+ * are going to fail the depth test are skipped, too.
+ */
+static void SetupRowFragments(const TriangleSetup& setup, u16 y, u16 min_x, u16 max_x,
+                              bool early_depth_test, std::vector<Fragment>& fragments) {
+    const auto& regs = g_state.regs;
+
+    const bool scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
+    const u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
+    const u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
+    const u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
+    const u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
+
+    // Do not process the pixel if it's inside the scissor box and the scissor mode is set
+    // to Exclude
+    const auto IsScissored = [&](u16 x) {
+        return scissor_exclude && x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 &&
+               y < scissor_y2;
+    };
+
+    u16 x = min_x + 8;
+
+#ifdef ARCHITECTURE_x86_64
+    if (Settings::values.enable_software_renderer_simd) {
+        const auto& output_merger = regs.framebuffer.output_merger;
+        Fragment group[4];
+
+        for (; x + 0x30 < max_x; x += 0x40) {
+            const int coverage = SetupFragments4(setup, x, y, group);
+            for (int i = 0; i < 4; ++i) {
+                const Fragment& fragment = group[i];
+                if (!(coverage & (1 << i)) || IsScissored(fragment.x)) {
+                    continue;
+                }
+                if (early_depth_test &&
+                    !DepthTestPasses(output_merger.depth_test_func, DepthToInt(fragment.depth),
+                                     GetDepth(fragment.x >> 4, y >> 4))) {
+                    continue;
+                }
+                fragments.push_back(fragment);
+            }
         }
+    }
+#endif
 
-        // Cull away triangles which are wound clockwise.
-        if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
-            return;
+    for (; x < max_x; x += 0x10) {
+        if (IsScissored(x)) {
+            continue;
+        }
+
+        Fragment fragment;
+        if (SetupFragment(setup, x, y, fragment)) {
+            fragments.push_back(fragment);
+        }
     }
+}
 
-    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
-    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+/// Colors of the four texture units sampled for a fragment
+using TextureColors = std::array<Common::Vec4<u8>, 4>;
 
-    // Convert the scissor box coordinates to 12.4 fixed point
-    u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
-    u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
-    // x2,y2 have +1 added to cover the entire sub-pixel area
-    u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
-    u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
+struct FogLutEntry {
+    float value;
+    float difference;
+};
 
-    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
-        // Calculate the new bounds
-        min_x = std::max(min_x, scissor_x1);
-        min_y = std::max(min_y, scissor_y1);
-        max_x = std::min(max_x, scissor_x2);
-        max_y = std::min(max_y, scissor_y2);
+// The lighting and fog configuration only changes between draws. It is converted before the first
+// triangle after a change is drawn, and read by all rasterizer threads.
+static LightingSetup lighting_setup;
+static std::array<FogLutEntry, 128> fog_lut;
+static bool lighting_setup_dirty = true;
+
+static void UpdateLightingSetup() {
+    ConfigureLighting(lighting_setup, g_state.regs.lighting, g_state.lighting);
+    for (std::size_t i = 0; i < fog_lut.size(); ++i) {
+        fog_lut[i] = {g_state.fog.lut[i].ToFloat(), g_state.fog.lut[i].DiffToFloat()};
     }
+    lighting_setup_dirty = false;
+}
 
-    min_x &= Fix12P4::IntMask();
-    min_y &= Fix12P4::IntMask();
-    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
-    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
+/// Computes the primary and secondary fragment colors of a row of fragments
+static void ComputeRowLighting(const TriangleSetup& setup, const std::vector<Fragment>& fragments,
+                               const std::vector<TextureColors>& texture_colors,
+                               std::vector<Common::Vec4<u8>>& primary_colors,
+                               std::vector<Common::Vec4<u8>>& secondary_colors) {
+    const Vertex& v0 = setup.v0;
+    const Vertex& v1 = setup.v1;
+    const Vertex& v2 = setup.v2;
+
+    const auto GetNormalQuaternion = [&](const Fragment& fragment) {
+        return Common::Quaternion<float>{
+            {GetInterpolatedAttribute(fragment, v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
+             GetInterpolatedAttribute(fragment, v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
+             GetInterpolatedAttribute(fragment, v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
+            GetInterpolatedAttribute(fragment, v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
+        }
+            .Normalized();
+    };
+    const auto GetView = [&](const Fragment& fragment) {
+        return Common::Vec3<float>{
+            GetInterpolatedAttribute(fragment, v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
+            GetInterpolatedAttribute(fragment, v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
+            GetInterpolatedAttribute(fragment, v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+        };
+    };
+
+    primary_colors.resize(fragments.size());
+    secondary_colors.resize(fragments.size());
+
+    std::size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    if (Settings::values.enable_software_renderer_simd) {
+        for (; i + 4 <= fragments.size(); i += 4) {
+            const Common::Quaternion<float> normquat[4]{
+                GetNormalQuaternion(fragments[i]), GetNormalQuaternion(fragments[i + 1]),
+                GetNormalQuaternion(fragments[i + 2]), GetNormalQuaternion(fragments[i + 3])};
+            const Common::Vec3<float> view[4]{GetView(fragments[i]), GetView(fragments[i + 1]),
+                                              GetView(fragments[i + 2]),
+                                              GetView(fragments[i + 3])};
+            const TextureColors* const texture_color[4]{
+                &texture_colors[i], &texture_colors[i + 1], &texture_colors[i + 2],
+                &texture_colors[i + 3]};
+            Common::Vec4<u8> primary_color[4];
+            Common::Vec4<u8> secondary_color[4];
+            ComputeFragmentsColors4(lighting_setup, normquat, view, texture_color, primary_color,
+                                    secondary_color);
+            std::copy(std::begin(primary_color), std::end(primary_color), &primary_colors[i]);
+            std::copy(std::begin(secondary_color), std::end(secondary_color),
+                      &secondary_colors[i]);
+        }
+    }
+#endif
+    for (; i < fragments.size(); ++i) {
+        std::tie(primary_colors[i], secondary_colors[i]) =
+            ComputeFragmentsColors(lighting_setup, GetNormalQuaternion(fragments[i]),
+                                   GetView(fragments[i]), texture_colors[i]);
+    }
+}
+
+/**
+ * Draws the pixels of a counter-clockwise wound triangle which lie within the given rectangle.
+ * The rectangle is given in pixels, with the right and bottom edges being exclusive.
+ */
+static void DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                         const Common::Rectangle<u32>& clip) {
+    const auto& regs = g_state.regs;
+
+    Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
+                                    ScreenToRasterizerCoordinates(v1.screenpos),
+                                    ScreenToRasterizerCoordinates(v2.screenpos)};
+
+    const Common::Rectangle<u16> bounds = GetBoundingBox(vtxpos);
+    const u16 min_x = static_cast<u16>(std::max<u32>(bounds.left, clip.left << 4));
+    const u16 min_y = static_cast<u16>(std::max<u32>(bounds.top, clip.top << 4));
+    const u16 max_x = static_cast<u16>(std::min<u32>(bounds.right, clip.right << 4));
+    const u16 max_y = static_cast<u16>(std::min<u32>(bounds.bottom, clip.bottom << 4));
 
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
@@ -206,7 +623,19 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
-    auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
+    const TriangleSetup setup{
+        v0,
+        v1,
+        v2,
+        {vtxpos[0], vtxpos[1], vtxpos[2]},
+        bias0,
+        bias1,
+        bias2,
+        Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w),
+        float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32(),
+        float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32(),
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering,
+    };
 
     auto textures = regs.texturing.GetTextures();
     auto tev_stages = regs.texturing.GetTevStages();
@@ -216,104 +645,43 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+    // Fragments which fail the depth test can be discarded before shading them, unless they still
+    // have side effects (stencil updates, shadow map writes)
+    const bool early_depth_test =
+        regs.framebuffer.output_merger.depth_test_enable && !stencil_action_enable &&
+        regs.framebuffer.output_merger.fragment_operation_mode !=
+            FramebufferRegs::FragmentOperationMode::Shadow;
 
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
-                    continue;
-            }
+    thread_local std::vector<Fragment> fragments;
+    thread_local std::vector<TextureColors> texture_colors;
+    thread_local std::vector<Common::Vec4<u8>> primary_fragment_colors;
+    thread_local std::vector<Common::Vec4<u8>> secondary_fragment_colors;
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
-
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
-
-            auto baricentric_coordinates =
-                Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                float24::FromFloat32(static_cast<float>(w1)),
-                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Common::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
+    // Decoded textures are looked up again only when the sampled address changes (cube faces)
+    std::array<const Common::Vec4<u8>*, 3> decoded_textures{};
+    std::array<PAddr, 3> decoded_texture_addresses{};
 
-            // Clamp the result
-            depth = std::clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w =
-                    Common::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
-
-            Common::Vec4<u8> primary_color{
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
-                    255)),
+    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
+    // TODO: Not sure if looping through x first might be faster
+    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
+        fragments.clear();
+        SetupRowFragments(setup, y, min_x, max_x, early_depth_test, fragments);
+
+        // Textures are sampled for the whole row first, so that the lighting, which can depend on
+        // them, is computed for several fragments at once
+        texture_colors.resize(fragments.size());
+        for (std::size_t index = 0; index < fragments.size(); ++index) {
+            const Fragment& fragment = fragments[index];
+
+            const auto GetInterpolatedAttribute = [&fragment](float24 attr0, float24 attr1,
+                                                              float24 attr2) {
+                return Rasterizer::GetInterpolatedAttribute(fragment, attr0, attr1, attr2);
             };
 
-            Common::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+            const auto& uv = fragment.uv;
 
-            Common::Vec4<u8> texture_color[4]{};
+            TextureColors& texture_color = texture_colors[index];
+            texture_color = {};
             for (int i = 0; i < 3; ++i) {
                 const auto& texture = textures[i];
                 if (!texture.enabled || texture.config.address == 0)
@@ -398,14 +766,19 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     t = texture.config.height - 1 -
                         GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    const u8* texture_data =
-                        VideoCore::g_memory->GetPhysicalPointer(texture_address);
-
-                    auto info =
-                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                    if (decoded_textures[i] == nullptr ||
+                        decoded_texture_addresses[i] != texture_address) {
+                        auto info =
+                            Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                        info.physical_address = texture_address;
+                        decoded_textures[i] = GetDecodedTexture(info);
+                        decoded_texture_addresses[i] = texture_address;
+                    }
 
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    if (decoded_textures[i] != nullptr) {
+                        texture_color[i] = decoded_textures[i][t * texture.config.width + s];
+                    }
                 }
 
                 if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -428,9 +801,33 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // sample procedural texture
             if (regs.texturing.main_config.texture3_enable) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                const float u = proctex_uv.u().ToFloat32();
+                const float v = proctex_uv.v().ToFloat32();
+                texture_color[3] =
+                    Settings::values.enable_software_renderer_proctex_cache
+                        ? GetCachedProcTex(u, v, g_state.regs.texturing, g_state.proctex)
+                        : ProcTex(u, v, g_state.regs.texturing, g_state.proctex);
             }
+        }
+
+        if (lighting_setup.enabled) {
+            ComputeRowLighting(setup, fragments, texture_colors, primary_fragment_colors,
+                               secondary_fragment_colors);
+        }
+
+        for (std::size_t index = 0; index < fragments.size(); ++index) {
+            const Fragment& fragment = fragments[index];
+            const u16 x = fragment.x;
+            const float depth = fragment.depth;
+
+            Common::Vec4<u8> primary_color{
+                static_cast<u8>(round(fragment.color.r().ToFloat32() * 255)),
+                static_cast<u8>(round(fragment.color.g().ToFloat32() * 255)),
+                static_cast<u8>(round(fragment.color.b().ToFloat32() * 255)),
+                static_cast<u8>(round(fragment.color.a().ToFloat32() * 255)),
+            };
+
+            const TextureColors& texture_color = texture_colors[index];
 
             // Texture environment - consists of 6 stages of color and alpha combining.
             //
@@ -451,23 +848,9 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
             Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
 
-            if (!g_state.regs.lighting.disable) {
-                Common::Quaternion<float> normquat =
-                    Common::Quaternion<float>{
-                        {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
-                        GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
-                    }
-                        .Normalized();
-
-                Common::Vec3<float> view{
-                    GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
-                };
-                std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+            if (lighting_setup.enabled) {
+                primary_fragment_color = primary_fragment_colors[index];
+                secondary_fragment_color = secondary_fragment_colors[index];
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
@@ -645,8 +1028,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 // Generate clamped fog factor from LUT for given fog index
                 float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
                 float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
+                const FogLutEntry& fog_lut_entry = fog_lut[static_cast<unsigned int>(fog_i)];
+                float fog_factor = fog_lut_entry.value + fog_lut_entry.difference * fog_f;
                 fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
 
                 // Blend the fog
@@ -715,48 +1098,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             }
 
             // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
+            u32 z = DepthToInt(depth);
 
             if (output_merger.depth_test_enable) {
                 u32 ref_z = GetDepth(x >> 4, y >> 4);
 
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
+                bool pass = DepthTestPasses(output_merger.depth_test_func, z, ref_z);
 
                 if (!pass) {
                     if (stencil_action_enable)
@@ -886,8 +1233,162 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     }
 }
 
+// Triangles are binned into square screen tiles of this size (in pixels). Each tile is
+// rasterized by a single thread, which preserves the per-pixel primitive order.
+constexpr u32 TILE_SIZE = 32;
+// The PICA framebuffer is at most 1024x1024 pixels. Pixels beyond that (which can only be
+// produced by broken viewports) are assigned to the last tile of each row/column.
+constexpr u32 TILES_PER_ROW = 1024 / TILE_SIZE;
+// Rasterizer coordinates are 12.4 fixed point, so no pixel lies beyond this
+constexpr u32 MAX_SCREEN_COORDINATE = 0x10000 >> 4;
+
+struct BinnedTriangle {
+    Vertex v0;
+    Vertex v1;
+    Vertex v2;
+};
+
+static std::vector<BinnedTriangle> binned_triangles;
+static std::array<std::vector<u32>, TILES_PER_ROW * TILES_PER_ROW> tile_bins;
+// Indices of the tiles that have at least one triangle binned to them, in no particular order
+static std::vector<u32> active_tiles;
+
+static Common::Rectangle<u32> GetTileRectangle(u32 tile) {
+    const u32 tile_x = tile % TILES_PER_ROW;
+    const u32 tile_y = tile / TILES_PER_ROW;
+    return {
+        tile_x * TILE_SIZE,
+        tile_y * TILE_SIZE,
+        tile_x == TILES_PER_ROW - 1 ? MAX_SCREEN_COORDINATE : (tile_x + 1) * TILE_SIZE,
+        tile_y == TILES_PER_ROW - 1 ? MAX_SCREEN_COORDINATE : (tile_y + 1) * TILE_SIZE,
+    };
+}
+
+static void BinTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
+                                    ScreenToRasterizerCoordinates(v1.screenpos),
+                                    ScreenToRasterizerCoordinates(v2.screenpos)};
+
+    const Common::Rectangle<u16> bounds = GetBoundingBox(vtxpos);
+    if (bounds.right <= bounds.left || bounds.bottom <= bounds.top) {
+        return;
+    }
+
+    // Range of the pixels which may be covered by the triangle, inclusive
+    const u32 min_tile_x = std::min<u32>((bounds.left >> 4) / TILE_SIZE, TILES_PER_ROW - 1);
+    const u32 min_tile_y = std::min<u32>((bounds.top >> 4) / TILE_SIZE, TILES_PER_ROW - 1);
+    const u32 max_tile_x = std::min<u32>(((bounds.right >> 4) - 1) / TILE_SIZE, TILES_PER_ROW - 1);
+    const u32 max_tile_y =
+        std::min<u32>(((bounds.bottom >> 4) - 1) / TILE_SIZE, TILES_PER_ROW - 1);
+
+    const u32 index = static_cast<u32>(binned_triangles.size());
+    binned_triangles.push_back({v0, v1, v2});
+
+    for (u32 tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y) {
+        for (u32 tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x) {
+            const u32 tile = tile_y * TILES_PER_ROW + tile_x;
+            if (tile_bins[tile].empty()) {
+                active_tiles.push_back(tile);
+            }
+            tile_bins[tile].push_back(index);
+        }
+    }
+}
+
+/**
+ * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
+ * culling via recursion.
+ */
+static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                                    bool reversed = false) {
+    const auto& regs = g_state.regs;
+
+    if (lighting_setup_dirty) {
+        UpdateLightingSetup();
+    }
+
+    Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
+                                    ScreenToRasterizerCoordinates(v1.screenpos),
+                                    ScreenToRasterizerCoordinates(v2.screenpos)};
+
+    if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
+        // Make sure we always end up with a triangle wound counter-clockwise
+        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
+            ProcessTriangleInternal(v0, v2, v1, true);
+            return;
+        }
+    } else {
+        if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
+            // Reverse vertex order and use the CCW code path.
+            ProcessTriangleInternal(v0, v2, v1, true);
+            return;
+        }
+
+        // Cull away triangles which are wound clockwise.
+        if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
+            return;
+    }
+
+    if (Settings::values.enable_software_renderer_multithread) {
+        BinTriangle(v0, v1, v2);
+    } else {
+        DrawTriangle(v0, v1, v2, {0, 0, MAX_SCREEN_COORDINATE, MAX_SCREEN_COORDINATE});
+    }
+}
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
     ProcessTriangleInternal(v0, v1, v2);
 }
 
+void ProcessTriangles(const Vertex* vertices, std::size_t num_triangles) {
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+        ProcessTriangleInternal(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+    }
+}
+
+void InvalidateLightingSetup() {
+    lighting_setup_dirty = true;
+}
+
+void FlushTriangles() {
+    if (binned_triangles.empty()) {
+        return;
+    }
+
+    std::atomic<std::size_t> next_tile{0};
+
+    const auto RasterizeTiles = [&] {
+        for (std::size_t i = next_tile++; i < active_tiles.size(); i = next_tile++) {
+            const u32 tile = active_tiles[i];
+            const Common::Rectangle<u32> clip = GetTileRectangle(tile);
+
+            // Triangles are binned in submission order, so drawing them in bin order keeps the
+            // result identical to drawing them one after another.
+            for (const u32 index : tile_bins[tile]) {
+                const BinnedTriangle& triangle = binned_triangles[index];
+                DrawTriangle(triangle.v0, triangle.v1, triangle.v2, clip);
+            }
+            tile_bins[tile].clear();
+        }
+    };
+
+    Common::ThreadPool& thread_pool = Common::ThreadPool::GetPool();
+    std::vector<std::future<void>> futures;
+
+    const std::size_t num_workers = std::min<std::size_t>(
+        active_tiles.size() - 1, std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        futures.emplace_back(thread_pool.Push(RasterizeTiles));
+    }
+    RasterizeTiles();
+
+    for (std::future<void>& future : futures) {
+        future.get();
+    }
+
+    binned_triangles.clear();
+    active_tiles.clear();
+}
+
 } // namespace Pica::Rasterizer
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
@@ -39,6 +40,22 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
+/**
+ * Queues a triangle for rasterization. Depending on the settings, the triangle is either drawn
+ * immediately or binned into screen tiles until the next call to FlushTriangles.
+ */
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/// Queues a batch of triangles, each given by three consecutive vertices, like ProcessTriangle
+void ProcessTriangles(const Vertex* vertices, std::size_t num_triangles);
+
+/// Draws all binned triangles, rasterizing independent screen tiles in parallel
+void FlushTriangles();
+
+/**
+ * Marks the lighting and fog configuration as changed. It is converted again before the next
+ * triangle is queued. Binned triangles must be flushed first.
+ */
+void InvalidateLightingSetup();
+
 } // namespace Pica::Rasterizer
@@ -2,15 +2,93 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "video_core/pica_state.h"
+#include "video_core/regs.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/proctex.h"
+#include "video_core/swrasterizer/rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
 
 namespace VideoCore {
 
+SWRasterizer::~SWRasterizer() {
+    Pica::Rasterizer::FlushTriangles();
+    Pica::Rasterizer::ClearDecodedTextures();
+    // The rasterizer is switched on the emulation thread, and the next one may mark the pages
+    Pica::Rasterizer::CommitDecodedTextures();
+    Pica::Rasterizer::InvalidateLightingSetup();
+    Pica::Rasterizer::InvalidateProcTexCache();
+}
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
     Pica::Clipper::ProcessTriangle(v0, v1, v2);
 }
 
+void SWRasterizer::AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                                std::size_t num_triangles) {
+    Pica::Clipper::ProcessTriangles(vertices, num_triangles);
+}
+
+void SWRasterizer::DrawTriangles() {
+    Pica::Rasterizer::FlushTriangles();
+
+    // The rasterizer writes the framebuffer directly, so textures decoded from it are stale now
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    Pica::Rasterizer::InvalidateDecodedTextures(
+        framebuffer.GetColorBufferPhysicalAddress(),
+        num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(framebuffer.color_format));
+    Pica::Rasterizer::InvalidateDecodedTextures(
+        framebuffer.GetDepthBufferPhysicalAddress(),
+        num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format));
+    Pica::Rasterizer::TrimDecodedTextures();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Triangles are binned per draw and DrawTriangles flushes them, so this only guards against
+    // rasterizer and framebuffer state changing while triangles are binned. The shader, vertex
+    // and command buffer registers after them don't affect binned triangles.
+    constexpr u32 rasterizer_state_end = PICA_REG_INDEX(pipeline);
+    if (id < rasterizer_state_end) {
+        Pica::Rasterizer::FlushTriangles();
+    }
+
+    // The lighting registers and LUTs, and the fog LUT, are converted once for all triangles
+    constexpr u32 lighting_begin = PICA_REG_INDEX(lighting);
+    constexpr u32 lighting_end = lighting_begin + sizeof(Pica::LightingRegs) / sizeof(u32);
+    constexpr u32 fog_lut_begin = PICA_REG_INDEX(texturing.fog_lut_data);
+    constexpr u32 fog_lut_end = PICA_REG_INDEX(texturing.fog_lut_data[7]) + 1;
+    if ((id >= lighting_begin && id < lighting_end) || (id >= fog_lut_begin && id < fog_lut_end)) {
+        Pica::Rasterizer::InvalidateLightingSetup();
+    }
+
+    // The procedural texture is generated once for all fragments
+    constexpr u32 proctex_begin = PICA_REG_INDEX(texturing.proctex);
+    constexpr u32 proctex_end = PICA_REG_INDEX(texturing.proctex_lut_data[7]) + 1;
+    if (id >= proctex_begin && id < proctex_end) {
+        Pica::Rasterizer::InvalidateProcTexCache();
+    }
+}
+
+void SWRasterizer::FlushAll() {
+    Pica::Rasterizer::FlushTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::FlushTriangles();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::FlushTriangles();
+    Pica::Rasterizer::InvalidateDecodedTextures(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::FlushTriangles();
+    Pica::Rasterizer::InvalidateDecodedTextures(addr, size);
+}
+
 } // namespace VideoCore
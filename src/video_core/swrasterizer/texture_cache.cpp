@@ -0,0 +1,231 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include <boost/range/iterator_range.hpp>
+#include "common/assert.h"
+#include "common/fast_hash.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+namespace {
+
+struct TextureKey {
+    PAddr address;
+    u32 size;
+    TexturingRegs::TextureFormat format;
+    u32 width;
+    u32 height;
+
+    bool operator<(const TextureKey& other) const {
+        return std::tie(address, size, format, width, height) <
+               std::tie(other.address, other.size, other.format, other.width, other.height);
+    }
+};
+
+using PageMap = boost::icl::interval_map<u32, int>;
+
+// Decoded textures take 4 bytes per texel, this is enough for 32 1024x1024 textures
+constexpr std::size_t MAX_CACHED_BYTES = 128 * 1024 * 1024;
+
+std::mutex cache_mutex;
+std::map<TextureKey, std::vector<Common::Vec4<u8>>> decoded_textures;
+std::size_t cached_bytes = 0;
+PageMap cached_pages;
+
+/// A change of the cached state of a region, applied to the memory on the emulation thread
+struct PendingMark {
+    PAddr address;
+    u32 size;
+    bool cached;
+};
+
+/// Marks to apply in order, and the textures decoded since the last commit with the hashes of
+/// their data before decoding
+std::vector<PendingMark> pending_marks;
+std::vector<std::pair<TextureKey, u64>> unverified_textures;
+std::atomic<bool> has_pending_changes{false};
+
+/// Returns the number of bytes of texture data LookupTexture reads for the whole texture
+u32 GetTextureSize(const Texture::TextureInfo& info) {
+    const u32 tile_size = static_cast<u32>(Texture::CalculateTileSize(info.format));
+    return static_cast<u32>(info.stride) * ((info.height - 1) / 8) +
+           tile_size * ((info.width - 1) / 8 + 1);
+}
+
+/// Queues marking the pages of a region as cached the first time any decoded texture covers them
+/// and unmarking them once no decoded texture covers them anymore
+void UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+    const u32 page_start = addr >> Memory::PAGE_BITS;
+    const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+
+    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
+    // subtract after iterating
+    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
+    if (delta > 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+
+    for (auto& pair : boost::make_iterator_range(cached_pages.equal_range(pages_interval))) {
+        const auto interval = pair.first & pages_interval;
+        const int count = pair.second;
+
+        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
+        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+        const u32 interval_size = interval_end_addr - interval_start_addr;
+
+        if (delta > 0 && count == delta) {
+            pending_marks.push_back({interval_start_addr, interval_size, true});
+        } else if (delta < 0 && count == -delta) {
+            pending_marks.push_back({interval_start_addr, interval_size, false});
+        } else {
+            ASSERT(count >= 0);
+        }
+    }
+
+    if (delta < 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+
+    if (!pending_marks.empty()) {
+        has_pending_changes.store(true, std::memory_order_release);
+    }
+}
+
+void ApplyPendingMarks() {
+    for (const PendingMark& mark : pending_marks) {
+        VideoCore::g_memory->RasterizerMarkRegionCached(mark.address, mark.size, mark.cached);
+    }
+    pending_marks.clear();
+}
+
+void EraseDecodedTexture(decltype(decoded_textures)::iterator it) {
+    UpdatePagesCachedCount(it->first.address, it->first.size, -1);
+    cached_bytes -= it->second.size() * sizeof(Common::Vec4<u8>);
+    decoded_textures.erase(it);
+}
+
+} // Anonymous namespace
+
+const Common::Vec4<u8>* GetDecodedTexture(const Texture::TextureInfo& info) {
+    if (info.width == 0 || info.height == 0) {
+        return nullptr;
+    }
+
+    const TextureKey key{info.physical_address, GetTextureSize(info), info.format, info.width,
+                         info.height};
+
+    std::lock_guard lock(cache_mutex);
+
+    const auto it = decoded_textures.find(key);
+    if (it != decoded_textures.end()) {
+        return it->second.data();
+    }
+
+    const u8* source = VideoCore::g_memory->GetPhysicalPointer(info.physical_address);
+    if (source == nullptr) {
+        return nullptr;
+    }
+
+    // Hashed before decoding, so a CPU write while decoding can only make the commit drop the
+    // texture needlessly
+    const u64 source_hash = Common::ComputeFastHash64(source, key.size);
+
+    std::vector<Common::Vec4<u8>> texels(info.width * info.height);
+    if (info.width % 8 == 0 && info.height % 8 == 0) {
+        Texture::DecodeTexture(source, texels[0].AsArray(), info.width, info.height, info.format);
+    } else {
+        for (u32 y = 0; y < info.height; ++y) {
+            for (u32 x = 0; x < info.width; ++x) {
+                texels[y * info.width + x] = Texture::LookupTexture(source, x, y, info);
+            }
+        }
+    }
+
+    UpdatePagesCachedCount(key.address, key.size, 1);
+    unverified_textures.emplace_back(key, source_hash);
+    has_pending_changes.store(true, std::memory_order_release);
+    cached_bytes += texels.size() * sizeof(Common::Vec4<u8>);
+    return decoded_textures.emplace(key, std::move(texels)).first->second.data();
+}
+
+void InvalidateDecodedTextures(PAddr addr, u32 size) {
+    if (size == 0) {
+        return;
+    }
+
+    std::lock_guard lock(cache_mutex);
+
+    const u32 page_start = addr >> Memory::PAGE_BITS;
+    const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+    if (!boost::icl::intersects(cached_pages,
+                                PageMap::interval_type::right_open(page_start, page_end))) {
+        return;
+    }
+
+    for (auto it = decoded_textures.begin(); it != decoded_textures.end();) {
+        const TextureKey& key = it->first;
+        if (key.address < addr + size && addr < key.address + key.size) {
+            EraseDecodedTexture(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TrimDecodedTextures() {
+    std::lock_guard lock(cache_mutex);
+
+    if (cached_bytes <= MAX_CACHED_BYTES) {
+        return;
+    }
+
+    while (!decoded_textures.empty()) {
+        EraseDecodedTexture(decoded_textures.begin());
+    }
+}
+
+void ClearDecodedTextures() {
+    std::lock_guard lock(cache_mutex);
+
+    while (!decoded_textures.empty()) {
+        EraseDecodedTexture(decoded_textures.begin());
+    }
+}
+
+void CommitDecodedTextures() {
+    if (!has_pending_changes.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard lock(cache_mutex);
+    has_pending_changes.store(false, std::memory_order_relaxed);
+
+    // CPU writes after this invalidate the textures through the rasterizer, and the hashes catch
+    // the writes between decoding the textures and marking their memory
+    ApplyPendingMarks();
+    for (const auto& [key, source_hash] : unverified_textures) {
+        const auto it = decoded_textures.find(key);
+        if (it == decoded_textures.end()) {
+            continue;
+        }
+        const u8* source = VideoCore::g_memory->GetPhysicalPointer(key.address);
+        if (Common::ComputeFastHash64(source, key.size) != source_hash) {
+            EraseDecodedTexture(it);
+        }
+    }
+    unverified_textures.clear();
+    ApplyPendingMarks();
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,41 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * Returns the texture described by info decoded to linear RGBA8. The texel at index y * width + x
+ * is the one Texture::LookupTexture would return for (x, y).
+ * The memory backing the texture is marked as cached by the next CommitDecodedTextures, so CPU
+ * writes to it invalidate the decoded texture. Safe to call from the GPU and rasterizer worker
+ * threads.
+ * @returns nullptr if the texture is empty or not backed by memory. Otherwise the pointer stays
+ * valid until the texture is invalidated or the cache is trimmed or cleared.
+ */
+const Common::Vec4<u8>* GetDecodedTexture(const Texture::TextureInfo& info);
+
+/// Drops the decoded textures that overlap the given region
+void InvalidateDecodedTextures(PAddr addr, u32 size);
+
+/// Drops all decoded textures if they take up more memory than the cache budget
+void TrimDecodedTextures();
+
+/// Drops all decoded textures
+void ClearDecodedTextures();
+
+/**
+ * Marks the memory of the textures decoded since the last call as cached and unmarks the memory
+ * no decoded texture covers anymore. Textures whose memory changed since they were decoded are
+ * dropped. The CPU reads the page tables this changes, so this must be called on the emulation
+ * thread, before it queues GPU commands that may use the textures.
+ */
+void CommitDecodedTextures();
+
+} // namespace Pica::Rasterizer
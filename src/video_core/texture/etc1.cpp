@@ -115,6 +115,32 @@ union ETC1Tile {
 
         return ret.Cast<u8>();
     }
+
+    /// Returns the base colors of the two halves of the subtile
+    std::array<Common::Vec3<int>, 2> GetBaseColors() const {
+        std::array<Common::Vec3<int>, 2> ret;
+        if (differential_mode) {
+            const Common::Vec3<int> base{static_cast<int>(differential.r),
+                                         static_cast<int>(differential.g),
+                                         static_cast<int>(differential.b)};
+            const Common::Vec3<int> delta{static_cast<int>(differential.dr),
+                                          static_cast<int>(differential.dg),
+                                          static_cast<int>(differential.db)};
+            const Common::Vec3<int> second = base + delta;
+            for (std::size_t i = 0; i < 3; ++i) {
+                ret[0][i] = Color::Convert5To8(base[i]);
+                ret[1][i] = Color::Convert5To8(second[i]);
+            }
+        } else {
+            ret[0] = {Color::Convert4To8(static_cast<u8>(separate.r1)),
+                      Color::Convert4To8(static_cast<u8>(separate.g1)),
+                      Color::Convert4To8(static_cast<u8>(separate.b1))};
+            ret[1] = {Color::Convert4To8(static_cast<u8>(separate.r2)),
+                      Color::Convert4To8(static_cast<u8>(separate.g2)),
+                      Color::Convert4To8(static_cast<u8>(separate.b2))};
+        }
+        return ret;
+    }
 };
 
 } // anonymous namespace
@@ -124,4 +150,28 @@ Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Subtile(u64 value, Common::Vec3<u8> (&texels)[16]) {
+    const ETC1Tile tile{value};
+    const auto base_colors = tile.GetBaseColors();
+    const std::array<unsigned, 2> table_indices{static_cast<unsigned>(tile.table_index_1),
+                                                static_cast<unsigned>(tile.table_index_2)};
+
+    for (unsigned int y = 0; y < 4; ++y) {
+        for (unsigned int x = 0; x < 4; ++x) {
+            const unsigned int texel = 4 * x + y;
+            const std::size_t half = ((tile.flip ? y : x) >= 2) ? 1 : 0;
+
+            int modifier = etc1_modifier_table[table_indices[half]][tile.GetTableSubIndex(texel)];
+            if (tile.GetNegationFlag(texel))
+                modifier *= -1;
+
+            const auto& base = base_colors[half];
+            texels[x + 4 * y] = Common::MakeVec(std::clamp(base.r() + modifier, 0, 255),
+                                                std::clamp(base.g() + modifier, 0, 255),
+                                                std::clamp(base.b() + modifier, 0, 255))
+                                    .Cast<u8>();
+        }
+    }
+}
+
 } // namespace Pica::Texture
@@ -11,4 +11,7 @@ namespace Pica::Texture {
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
+/// Decodes all texels of a 4x4 subtile at once, the texel at (x, y) is stored at index x + 4 * y
+void DecodeETC1Subtile(u64 value, Common::Vec3<u8> (&texels)[16]);
+
 } // namespace Pica::Texture
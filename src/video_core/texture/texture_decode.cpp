@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
@@ -13,6 +15,11 @@
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#include "video_core/texture/texture_decode_x64.h"
+#endif
+
 using TextureFormat = Pica::TexturingRegs::TextureFormat;
 
 namespace Pica::Texture {
@@ -222,4 +229,144 @@ TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& co
     return info;
 }
 
+namespace {
+
+template <TextureFormat format>
+void DecodeTile(const u8* tile, u8* texels) {
+    TextureInfo info{};
+    info.format = format;
+
+    // LookupTexelInTile expects coordinates, so invert the Morton order of each texel first
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            auto texel = LookupTexelInTile(tile, x, y, info, false);
+            std::memcpy(texels + VideoCore::MortonInterleave(x, y) * 4, texel.AsArray(), 4);
+        }
+    }
+}
+
+template <bool has_alpha>
+void DecodeTileETC1(const u8* tile, u8* texels) {
+    constexpr std::size_t subtile_size = has_alpha ? 16 : 8;
+
+    // ETC1 further subdivides each 8x8 tile into four 4x4 subtiles
+    for (u32 subtile_index = 0; subtile_index < ETC1_SUBTILES; ++subtile_index) {
+        const u8* subtile_ptr = tile + subtile_index * subtile_size;
+
+        u64_le packed_alpha{};
+        if (has_alpha) {
+            memcpy(&packed_alpha, subtile_ptr, sizeof(u64));
+            subtile_ptr += sizeof(u64);
+        }
+
+        u64_le subtile_data;
+        memcpy(&subtile_data, subtile_ptr, sizeof(u64));
+
+        Common::Vec3<u8> colors[16];
+        DecodeETC1Subtile(subtile_data, colors);
+
+        const u32 subtile_x = (subtile_index % 2) * 4;
+        const u32 subtile_y = (subtile_index / 2) * 4;
+        for (u32 y = 0; y < 4; ++y) {
+            for (u32 x = 0; x < 4; ++x) {
+                u8* texel =
+                    texels + VideoCore::MortonInterleave(subtile_x + x, subtile_y + y) * 4;
+                const auto& color = colors[x + 4 * y];
+                texel[0] = color.r();
+                texel[1] = color.g();
+                texel[2] = color.b();
+                texel[3] = has_alpha ? Color::Convert4To8((packed_alpha >> (4 * (x * 4 + y))) & 0xF)
+                                     : 255;
+            }
+        }
+    }
+}
+
+TileDecoder GetTileDecoder(TextureFormat format) {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        if (const TileDecoder decoder = GetTileDecoderAVX2(format)) {
+            return decoder;
+        }
+    }
+    if (caps.ssse3) {
+        if (const TileDecoder decoder = GetTileDecoderSSSE3(format)) {
+            return decoder;
+        }
+    }
+#endif
+    return GetTileDecoderGeneric(format);
+}
+
+} // Anonymous namespace
+
+TileDecoder GetTileDecoderGeneric(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTile<TextureFormat::RGBA8>;
+    case TextureFormat::RGB8:
+        return DecodeTile<TextureFormat::RGB8>;
+    case TextureFormat::RGB5A1:
+        return DecodeTile<TextureFormat::RGB5A1>;
+    case TextureFormat::RGB565:
+        return DecodeTile<TextureFormat::RGB565>;
+    case TextureFormat::RGBA4:
+        return DecodeTile<TextureFormat::RGBA4>;
+    case TextureFormat::IA8:
+        return DecodeTile<TextureFormat::IA8>;
+    case TextureFormat::RG8:
+        return DecodeTile<TextureFormat::RG8>;
+    case TextureFormat::I8:
+        return DecodeTile<TextureFormat::I8>;
+    case TextureFormat::A8:
+        return DecodeTile<TextureFormat::A8>;
+    case TextureFormat::IA4:
+        return DecodeTile<TextureFormat::IA4>;
+    case TextureFormat::I4:
+        return DecodeTile<TextureFormat::I4>;
+    case TextureFormat::A4:
+        return DecodeTile<TextureFormat::A4>;
+    case TextureFormat::ETC1:
+        return DecodeTileETC1<false>;
+    case TextureFormat::ETC1A4:
+        return DecodeTileETC1<true>;
+    default:
+        return nullptr;
+    }
+}
+
+void DecodeTexture(const u8* source, u8* dest, unsigned int width, unsigned int height,
+                   TextureFormat format) {
+    DEBUG_ASSERT(width % 8 == 0 && height % 8 == 0);
+
+    const TileDecoder decode_tile = GetTileDecoder(format);
+    if (decode_tile == nullptr) {
+        LOG_ERROR(HW_GPU, "Unknown texture format: {:x}", static_cast<u32>(format));
+        return;
+    }
+
+    const std::size_t tile_size = CalculateTileSize(format);
+    const std::size_t dest_stride = width * 4;
+    std::array<u8, TILE_SIZE * 4> texels;
+
+    for (unsigned int tile_y = 0; tile_y < height; tile_y += 8) {
+        for (unsigned int tile_x = 0; tile_x < width; tile_x += 8) {
+            decode_tile(source, texels.data());
+            source += tile_size;
+
+            // Each row of a tile is made of four pairs of texels which are adjacent in Morton
+            // order, so rows are copied two texels at a time
+            u8* dest_tile = dest + tile_y * dest_stride + tile_x * 4;
+            for (u32 y = 0; y < 8; ++y) {
+                u8* dest_row = dest_tile + y * dest_stride;
+                for (u32 x = 0; x < 8; x += 2) {
+                    std::memcpy(dest_row + x * 4,
+                                texels.data() + VideoCore::MortonInterleave(x, y) * 4, 8);
+                }
+            }
+        }
+    }
+}
+
 } // namespace Pica::Texture
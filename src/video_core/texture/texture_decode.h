@@ -55,4 +55,22 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/// Decodes the 64 texels of an 8x8 tile to RGBA8, keeping them in Morton order
+using TileDecoder = void (*)(const u8* tile, u8* texels);
+
+/// Returns the portable tile decoder for the format, or nullptr if the format is unknown
+TileDecoder GetTileDecoderGeneric(TexturingRegs::TextureFormat format);
+
+/**
+ * Decodes a whole tiled texture to linear RGBA8.
+ *
+ * @param source Pointer to the beginning of the texture.
+ * @param dest Destination buffer of width * height * 4 bytes. The texel at (x, y) is stored at
+ *             offset (x + y * width) * 4 and is the same as LookupTexture would return for it.
+ * @param width, height Dimensions of the texture. Must be multiples of 8.
+ * @param format Format of the texture.
+ */
+void DecodeTexture(const u8* source, u8* dest, unsigned int width, unsigned int height,
+                   TexturingRegs::TextureFormat format);
+
 } // namespace Pica::Texture
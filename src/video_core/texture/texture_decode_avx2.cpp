@@ -0,0 +1,135 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include <immintrin.h>
+#include "video_core/texture/texture_decode_x64.h"
+
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+namespace Pica::Texture {
+
+namespace {
+
+constexpr std::size_t TILE_TEXELS = 8 * 8;
+
+__m256i Load(const u8* source) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+}
+
+void Store(u8* dest, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), value);
+}
+
+// The Convert*To8 functions work on 16 bit lanes holding values that fit in the source bit count
+__m256i Convert4To8(__m256i value) {
+    return _mm256_or_si256(_mm256_slli_epi16(value, 4), value);
+}
+
+__m256i Convert5To8(__m256i value) {
+    return _mm256_or_si256(_mm256_slli_epi16(value, 3), _mm256_srli_epi16(value, 2));
+}
+
+__m256i Convert6To8(__m256i value) {
+    return _mm256_or_si256(_mm256_slli_epi16(value, 2), _mm256_srli_epi16(value, 4));
+}
+
+/**
+ * Stores two vectors whose 128 bit lanes hold texels 0-3 and 8-11 (first) and texels 4-7 and
+ * 12-15 (second), as unpacking and in-lane shuffles leave them, as 16 consecutive texels
+ */
+void StoreLanes(u8* dest, __m256i first, __m256i second) {
+    Store(dest, _mm256_permute2x128_si256(first, second, 0x20));
+    Store(dest + 32, _mm256_permute2x128_si256(first, second, 0x31));
+}
+
+/// Interleaves 16 8 bit components held in 16 bit lanes into 16 RGBA8 texels
+void StoreRGBA(u8* dest, __m256i r, __m256i g, __m256i b, __m256i a) {
+    const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+    const __m256i ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+    StoreLanes(dest, _mm256_unpacklo_epi16(rg, ba), _mm256_unpackhi_epi16(rg, ba));
+}
+
+void DecodeTileRGBA8(const u8* tile, u8* texels) {
+    const __m256i shuffle =
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+                         5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        Store(texels + i * 4, _mm256_shuffle_epi8(Load(tile + i * 4), shuffle));
+    }
+}
+
+void DecodeTileRGB5A1(const u8* tile, u8* texels) {
+    const __m256i mask = _mm256_set1_epi16(0x1F);
+    const __m256i one = _mm256_set1_epi16(1);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        const __m256i pixels = Load(tile + i * 2);
+        const __m256i r = Convert5To8(_mm256_srli_epi16(pixels, 11));
+        const __m256i g = Convert5To8(_mm256_and_si256(_mm256_srli_epi16(pixels, 6), mask));
+        const __m256i b = Convert5To8(_mm256_and_si256(_mm256_srli_epi16(pixels, 1), mask));
+        const __m256i a =
+            _mm256_mullo_epi16(_mm256_and_si256(pixels, one), _mm256_set1_epi16(0xFF));
+        StoreRGBA(texels + i * 4, r, g, b, a);
+    }
+}
+
+void DecodeTileRGB565(const u8* tile, u8* texels) {
+    const __m256i mask5 = _mm256_set1_epi16(0x1F);
+    const __m256i mask6 = _mm256_set1_epi16(0x3F);
+    const __m256i alpha = _mm256_set1_epi16(0xFF);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        const __m256i pixels = Load(tile + i * 2);
+        const __m256i r = Convert5To8(_mm256_srli_epi16(pixels, 11));
+        const __m256i g = Convert6To8(_mm256_and_si256(_mm256_srli_epi16(pixels, 5), mask6));
+        const __m256i b = Convert5To8(_mm256_and_si256(pixels, mask5));
+        StoreRGBA(texels + i * 4, r, g, b, alpha);
+    }
+}
+
+void DecodeTileRGBA4(const u8* tile, u8* texels) {
+    const __m256i mask = _mm256_set1_epi16(0xF);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        const __m256i pixels = Load(tile + i * 2);
+        const __m256i r = Convert4To8(_mm256_srli_epi16(pixels, 12));
+        const __m256i g = Convert4To8(_mm256_and_si256(_mm256_srli_epi16(pixels, 8), mask));
+        const __m256i b = Convert4To8(_mm256_and_si256(_mm256_srli_epi16(pixels, 4), mask));
+        const __m256i a = Convert4To8(_mm256_and_si256(pixels, mask));
+        StoreRGBA(texels + i * 4, r, g, b, a);
+    }
+}
+
+void DecodeTileIA8(const u8* tile, u8* texels) {
+    const __m256i shuffle_low =
+        _mm256_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6, 1, 1, 1, 0, 3, 3, 3, 2,
+                         5, 5, 5, 4, 7, 7, 7, 6);
+    const __m256i shuffle_high =
+        _mm256_setr_epi8(9, 9, 9, 8, 11, 11, 11, 10, 13, 13, 13, 12, 15, 15, 15, 14, 9, 9, 9, 8,
+                         11, 11, 11, 10, 13, 13, 13, 12, 15, 15, 15, 14);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        const __m256i pixels = Load(tile + i * 2);
+        StoreLanes(texels + i * 4, _mm256_shuffle_epi8(pixels, shuffle_low),
+                   _mm256_shuffle_epi8(pixels, shuffle_high));
+    }
+}
+
+} // Anonymous namespace
+
+TileDecoder GetTileDecoderAVX2(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTileRGBA8;
+    case TextureFormat::RGB5A1:
+        return DecodeTileRGB5A1;
+    case TextureFormat::RGB565:
+        return DecodeTileRGB565;
+    case TextureFormat::RGBA4:
+        return DecodeTileRGBA4;
+    case TextureFormat::IA8:
+        return DecodeTileIA8;
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace Pica::Texture
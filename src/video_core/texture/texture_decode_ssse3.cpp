@@ -0,0 +1,224 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include <tmmintrin.h>
+#include "video_core/texture/texture_decode_x64.h"
+
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+namespace Pica::Texture {
+
+namespace {
+
+constexpr std::size_t TILE_TEXELS = 8 * 8;
+constexpr int ALPHA_MASK = static_cast<int>(0xFF000000);
+
+__m128i Load(const u8* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+void Store(u8* dest, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+}
+
+// The Convert*To8 functions work on 16 bit lanes holding values that fit in the source bit count
+__m128i Convert4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+__m128i Convert5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+__m128i Convert6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+
+/// Interleaves eight 8 bit components held in 16 bit lanes into eight RGBA8 texels
+void StoreRGBA(u8* dest, __m128i r, __m128i g, __m128i b, __m128i a) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    Store(dest, _mm_unpacklo_epi16(rg, ba));
+    Store(dest + 16, _mm_unpackhi_epi16(rg, ba));
+}
+
+/// Shuffles 16 single byte texels into 16 RGBA8 texels, four at a time
+void StoreShuffledBytes(u8* dest, __m128i values, __m128i shuffle, __m128i or_mask) {
+    for (int i = 0; i < 4; ++i) {
+        Store(dest + i * 16, _mm_or_si128(_mm_shuffle_epi8(values, shuffle), or_mask));
+        values = _mm_srli_si128(values, 4);
+    }
+}
+
+void StoreIntensity(u8* dest, __m128i values) {
+    const __m128i shuffle = _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1);
+    StoreShuffledBytes(dest, values, shuffle, _mm_set1_epi32(ALPHA_MASK));
+}
+
+void StoreAlpha(u8* dest, __m128i values) {
+    const __m128i shuffle =
+        _mm_setr_epi8(-1, -1, -1, 0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3);
+    StoreShuffledBytes(dest, values, shuffle, _mm_setzero_si128());
+}
+
+/// Splits 32 packed 4 bit texels into two vectors of 16 texels expanded to 8 bits
+void Unpack4(const u8* source, __m128i& first, __m128i& second) {
+    const __m128i mask = _mm_set1_epi8(0xF);
+    const __m128i packed = Load(source);
+    const __m128i low = _mm_and_si128(packed, mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+    // The lower nibble holds the first texel of each pair
+    first = Convert4To8(_mm_unpacklo_epi8(low, high));
+    second = Convert4To8(_mm_unpackhi_epi8(low, high));
+}
+
+void DecodeTileRGBA8(const u8* tile, u8* texels) {
+    const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 4) {
+        Store(texels + i * 4, _mm_shuffle_epi8(Load(tile + i * 4), shuffle));
+    }
+}
+
+void DecodeTileRGB8(const u8* tile, u8* texels) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32(ALPHA_MASK);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        // 16 texels take up 48 bytes, which are realigned so every group of 4 starts a vector
+        const __m128i first = Load(tile + i * 3);
+        const __m128i second = Load(tile + i * 3 + 16);
+        const __m128i third = Load(tile + i * 3 + 32);
+        const __m128i groups[4]{first, _mm_alignr_epi8(second, first, 12),
+                                _mm_alignr_epi8(third, second, 8), _mm_srli_si128(third, 4)};
+        for (int group = 0; group < 4; ++group) {
+            Store(texels + (i + group * 4) * 4,
+                  _mm_or_si128(_mm_shuffle_epi8(groups[group], shuffle), alpha));
+        }
+    }
+}
+
+void DecodeTileRGB5A1(const u8* tile, u8* texels) {
+    const __m128i mask = _mm_set1_epi16(0x1F);
+    const __m128i one = _mm_set1_epi16(1);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        const __m128i pixels = Load(tile + i * 2);
+        const __m128i r = Convert5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Convert5To8(_mm_and_si128(_mm_srli_epi16(pixels, 6), mask));
+        const __m128i b = Convert5To8(_mm_and_si128(_mm_srli_epi16(pixels, 1), mask));
+        const __m128i a = _mm_mullo_epi16(_mm_and_si128(pixels, one), _mm_set1_epi16(0xFF));
+        StoreRGBA(texels + i * 4, r, g, b, a);
+    }
+}
+
+void DecodeTileRGB565(const u8* tile, u8* texels) {
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i alpha = _mm_set1_epi16(0xFF);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        const __m128i pixels = Load(tile + i * 2);
+        const __m128i r = Convert5To8(_mm_srli_epi16(pixels, 11));
+        const __m128i g = Convert6To8(_mm_and_si128(_mm_srli_epi16(pixels, 5), mask6));
+        const __m128i b = Convert5To8(_mm_and_si128(pixels, mask5));
+        StoreRGBA(texels + i * 4, r, g, b, alpha);
+    }
+}
+
+void DecodeTileRGBA4(const u8* tile, u8* texels) {
+    const __m128i mask = _mm_set1_epi16(0xF);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        const __m128i pixels = Load(tile + i * 2);
+        const __m128i r = Convert4To8(_mm_srli_epi16(pixels, 12));
+        const __m128i g = Convert4To8(_mm_and_si128(_mm_srli_epi16(pixels, 8), mask));
+        const __m128i b = Convert4To8(_mm_and_si128(_mm_srli_epi16(pixels, 4), mask));
+        const __m128i a = Convert4To8(_mm_and_si128(pixels, mask));
+        StoreRGBA(texels + i * 4, r, g, b, a);
+    }
+}
+
+void DecodeTileIA8(const u8* tile, u8* texels) {
+    const __m128i shuffle_low = _mm_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6);
+    const __m128i shuffle_high =
+        _mm_setr_epi8(9, 9, 9, 8, 11, 11, 11, 10, 13, 13, 13, 12, 15, 15, 15, 14);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        const __m128i pixels = Load(tile + i * 2);
+        Store(texels + i * 4, _mm_shuffle_epi8(pixels, shuffle_low));
+        Store(texels + i * 4 + 16, _mm_shuffle_epi8(pixels, shuffle_high));
+    }
+}
+
+void DecodeTileRG8(const u8* tile, u8* texels) {
+    const __m128i shuffle_low =
+        _mm_setr_epi8(1, 0, -1, -1, 3, 2, -1, -1, 5, 4, -1, -1, 7, 6, -1, -1);
+    const __m128i shuffle_high =
+        _mm_setr_epi8(9, 8, -1, -1, 11, 10, -1, -1, 13, 12, -1, -1, 15, 14, -1, -1);
+    const __m128i alpha = _mm_set1_epi32(ALPHA_MASK);
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 8) {
+        const __m128i pixels = Load(tile + i * 2);
+        Store(texels + i * 4, _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle_low), alpha));
+        Store(texels + i * 4 + 16, _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle_high), alpha));
+    }
+}
+
+void DecodeTileI8(const u8* tile, u8* texels) {
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        StoreIntensity(texels + i * 4, Load(tile + i));
+    }
+}
+
+void DecodeTileA8(const u8* tile, u8* texels) {
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 16) {
+        StoreAlpha(texels + i * 4, Load(tile + i));
+    }
+}
+
+void DecodeTileI4(const u8* tile, u8* texels) {
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 32) {
+        __m128i first, second;
+        Unpack4(tile + i / 2, first, second);
+        StoreIntensity(texels + i * 4, first);
+        StoreIntensity(texels + i * 4 + 64, second);
+    }
+}
+
+void DecodeTileA4(const u8* tile, u8* texels) {
+    for (std::size_t i = 0; i < TILE_TEXELS; i += 32) {
+        __m128i first, second;
+        Unpack4(tile + i / 2, first, second);
+        StoreAlpha(texels + i * 4, first);
+        StoreAlpha(texels + i * 4 + 64, second);
+    }
+}
+
+} // Anonymous namespace
+
+TileDecoder GetTileDecoderSSSE3(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        return DecodeTileRGBA8;
+    case TextureFormat::RGB8:
+        return DecodeTileRGB8;
+    case TextureFormat::RGB5A1:
+        return DecodeTileRGB5A1;
+    case TextureFormat::RGB565:
+        return DecodeTileRGB565;
+    case TextureFormat::RGBA4:
+        return DecodeTileRGBA4;
+    case TextureFormat::IA8:
+        return DecodeTileIA8;
+    case TextureFormat::RG8:
+        return DecodeTileRG8;
+    case TextureFormat::I8:
+        return DecodeTileI8;
+    case TextureFormat::A8:
+        return DecodeTileA8;
+    case TextureFormat::I4:
+        return DecodeTileI4;
+    case TextureFormat::A4:
+        return DecodeTileA4;
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace Pica::Texture
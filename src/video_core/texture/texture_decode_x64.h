@@ -0,0 +1,20 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "video_core/regs_texturing.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace Pica::Texture {
+
+// These decode the same texels as the tile decoders of GetTileDecoderGeneric
+
+/// Returns the SSSE3 tile decoder for the format, or nullptr if the format has none
+TileDecoder GetTileDecoderSSSE3(TexturingRegs::TextureFormat format);
+
+/// Returns the AVX2 tile decoder for the format, or nullptr if the format has none
+TileDecoder GetTileDecoderAVX2(TexturingRegs::TextureFormat format);
+
+} // namespace Pica::Texture
@@ -5,9 +5,12 @@
 #include <memory>
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/frame_capture.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/renderer_software/renderer_software.h"
 #include "video_core/video_core.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -16,6 +19,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread;
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
@@ -24,11 +28,11 @@ std::atomic<bool> g_hw_shader_accurate_mul;
 std::atomic<bool> g_renderer_bg_color_update_requested;
 std::atomic<bool> g_renderer_sampler_update_requested;
 std::atomic<bool> g_renderer_shader_update_requested;
-// Screenshot
-std::atomic<bool> g_renderer_screenshot_requested;
-void* g_screenshot_bits;
-std::function<void()> g_screenshot_complete_callback;
-Layout::FramebufferLayout g_screenshot_framebuffer_layout;
+// Surface cache of the OpenGL renderer
+std::atomic<u64> g_surface_cache_memory_used;
+std::atomic<u64> g_surface_cache_evictions;
+// Screenshots and frame streaming
+FrameCapture g_frame_capture;
 
 Memory::MemorySystem* g_memory;
 
@@ -37,7 +41,11 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
     g_memory = &memory;
     Pica::Init();
 
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    if (Settings::values.use_headless_renderer) {
+        g_renderer = std::make_unique<RendererSoftware>(emu_window);
+    } else {
+        g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
     ResultStatus result = g_renderer->Init();
 
     if (result != ResultStatus::Success) {
@@ -46,33 +54,31 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
         LOG_DEBUG(Render, "initialized OK");
     }
 
+    if (Settings::values.use_gpu_thread) {
+        // Commands only go to the GPU thread while the software rasterizer is active, since the
+        // OpenGL context belongs to the emulation thread
+        if (Settings::values.use_hw_renderer) {
+            LOG_WARNING(Render, "The GPU thread is only used with the software renderer");
+        }
+        g_gpu_thread = std::make_unique<GPUThread>();
+    }
+
     return result;
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer->ShutDown();
     g_renderer.reset();
+    g_frame_capture.Reset();
 
     LOG_DEBUG(Render, "shutdown OK");
 }
 
-bool RequestScreenshot(void* data, std::function<void()> callback,
-                       const Layout::FramebufferLayout& layout) {
-    if (g_renderer_screenshot_requested) {
-        return true;
-    }
-
-    g_screenshot_bits = data;
-    g_screenshot_complete_callback = std::move(callback);
-    g_screenshot_framebuffer_layout = layout;
-    g_renderer_screenshot_requested = true;
-
-    return false;
-}
-
 u16 GetResolutionScaleFactor() {
     if (g_hw_renderer_enabled) {
         return Settings::values.resolution_factor
@@ -84,4 +90,10 @@ u16 GetResolutionScaleFactor() {
     }
 }
 
+void SynchronizeGPUThread(const char* reason) {
+    if (g_gpu_thread != nullptr) {
+        g_gpu_thread->Synchronize(reason);
+    }
+}
+
 } // namespace VideoCore
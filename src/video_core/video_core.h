@@ -14,6 +14,11 @@ class EmuWindow;
 
 class RendererBase;
 
+namespace VideoCore {
+class FrameCapture;
+class GPUThread;
+} // namespace VideoCore
+
 namespace Memory {
 class MemorySystem;
 } // namespace Memory
@@ -24,6 +29,7 @@ class MemorySystem;
 namespace VideoCore {
 
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread; ///< Null unless the GPU thread is enabled
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings
 extern std::atomic<bool> g_hw_renderer_enabled;
@@ -33,11 +39,11 @@ extern std::atomic<bool> g_hw_shader_accurate_mul;
 extern std::atomic<bool> g_renderer_bg_color_update_requested;
 extern std::atomic<bool> g_renderer_sampler_update_requested;
 extern std::atomic<bool> g_renderer_shader_update_requested;
-// Screenshot
-extern std::atomic<bool> g_renderer_screenshot_requested;
-extern void* g_screenshot_bits;
-extern std::function<void()> g_screenshot_complete_callback;
-extern Layout::FramebufferLayout g_screenshot_framebuffer_layout;
+// Surface cache of the OpenGL renderer
+extern std::atomic<u64> g_surface_cache_memory_used;
+extern std::atomic<u64> g_surface_cache_evictions;
+// Screenshots and frame streaming
+extern FrameCapture g_frame_capture;
 
 extern Memory::MemorySystem* g_memory;
 
@@ -53,11 +59,9 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 /// Shutdown the video core
 void Shutdown();
 
-/// Request a screenshot of the next frame
-/// Returns: another screenshot pending
-bool RequestScreenshot(void* data, std::function<void()> callback,
-                       const Layout::FramebufferLayout& layout);
-
 u16 GetResolutionScaleFactor();
 
+/// Waits for the GPU thread to run every queued command if it's enabled
+void SynchronizeGPUThread(const char* reason);
+
 } // namespace VideoCore
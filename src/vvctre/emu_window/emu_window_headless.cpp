@@ -0,0 +1,35 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "common/version.h"
+#include "core/3ds.h"
+#include "core/settings.h"
+#include "input_common/main.h"
+#include "vvctre/emu_window/emu_window_headless.h"
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    InputCommon::Init();
+
+    // The size of the screens composed by the renderer
+    UpdateCurrentFramebufferLayout(Core::kScreenTopWidth,
+                                   Core::kScreenTopHeight + Core::kScreenBottomHeight);
+
+    LOG_INFO(Frontend, "Version: {}", version::vvctre.to_string());
+    LOG_INFO(Frontend, "Movie version: {}", version::movie);
+    LOG_INFO(Frontend, "Shader cache version: {}", version::shader_cache);
+    Settings::LogSettings();
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() {
+    InputCommon::Shutdown();
+}
+
+bool EmuWindow_Headless::IsOpen() const {
+    return is_open;
+}
+
+void EmuWindow_Headless::Close() {
+    is_open = false;
+}
@@ -0,0 +1,28 @@
+// Copyright 2020 vvctre emulator project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include "core/frontend/emu_window.h"
+
+/// Window for the headless software renderer, which has no window or graphics context
+class EmuWindow_Headless : public Frontend::EmuWindow {
+public:
+    EmuWindow_Headless();
+    ~EmuWindow_Headless();
+
+    void SwapBuffers() override {}
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+
+    /// Whether a close request hasn't yet been sent
+    bool IsOpen() const;
+
+    void Close();
+
+private:
+    std::atomic<bool> is_open{true};
+};
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <string>
+#include <vector>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <fmt/format.h>
@@ -33,6 +34,7 @@
 #include "input_common/main.h"
 #include "input_common/motion_emu.h"
 #include "input_common/sdl/sdl.h"
+#include "video_core/frame_capture.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_manager.h"
 #include "video_core/video_core.h"
@@ -359,6 +361,31 @@ void EmuWindow_SDL2::SwapBuffers() {
                          ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_AlwaysAutoResize)) {
         ImGui::SetWindowPos(ImVec2(), ImGuiCond_Once);
         ImGui::TextColored(fps_color, "%d FPS", static_cast<int>(ImGui::GetIO().Framerate));
+        if (ImGui::IsItemHovered() && system.perf_stats != nullptr) {
+            // Mean times of the last second of system frames
+            const std::vector<Core::FrameBreakdown> breakdowns =
+                system.perf_stats->GetFrameBreakdowns(60);
+            if (!breakdowns.empty()) {
+                Core::FrameBreakdown mean;
+                for (const Core::FrameBreakdown& breakdown : breakdowns) {
+                    mean.frame_time += breakdown.frame_time / breakdowns.size();
+                    for (std::size_t i = 0; i < mean.subsystem_times.size(); ++i) {
+                        mean.subsystem_times[i] += breakdown.subsystem_times[i] / breakdowns.size();
+                    }
+                }
+
+                ImGui::BeginTooltip();
+                ImGui::Text("Frame: %.2f ms", mean.frame_time);
+                if (Core::AreSubsystemTimesEnabled()) {
+                    for (std::size_t i = 0; i < mean.subsystem_times.size(); ++i) {
+                        ImGui::Text("%s: %.2f ms",
+                                    Core::GetSubsystemName(static_cast<Core::Subsystem>(i)),
+                                    mean.subsystem_times[i]);
+                    }
+                }
+                ImGui::EndTooltip();
+            }
+        }
         if (ImGui::IsWindowFocused() && ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
             ImGui::ColorPicker4("##picker", (float*)&fps_color);
         }
@@ -1236,68 +1263,20 @@ void EmuWindow_SDL2::SwapBuffers() {
 
             if (ImGui::BeginMenu("Tools")) {
                 if (ImGui::MenuItem("Screenshot")) {
-                    const auto& layout = GetFramebufferLayout();
-                    u8* data = new u8[layout.width * layout.height * 4];
-                    if (VideoCore::RequestScreenshot(
-                            data,
-                            [=] {
-                                const auto filename =
-                                    pfd::save_file("Save Screenshot", "screenshot.png",
-                                                   {"Portable Network Graphics", "*.png"})
-                                        .result();
-                                if (!filename.empty()) {
-                                    std::vector<u8> v(layout.width * layout.height * 4);
-                                    std::memcpy(v.data(), data, v.size());
-                                    delete[] data;
-
-                                    const auto rotate =
-                                        [](const std::vector<u8>& input,
-                                           const Layout::FramebufferLayout& layout) {
-                                            std::vector<u8> output(input.size());
-
-                                            for (std::size_t i = 0; i < layout.height; i++) {
-                                                for (std::size_t j = 0; j < layout.width; j++) {
-                                                    for (std::size_t k = 0; k < 4; k++) {
-                                                        output[i * (layout.width * 4) + j * 4 + k] =
-                                                            input[(layout.height - i - 1) *
-                                                                      (layout.width * 4) +
-                                                                  j * 4 + k];
-                                                    }
-                                                }
-                                            }
-
-                                            return output;
-                                        };
-
-                                    const auto convert_bgra_to_rgba =
-                                        [](const std::vector<u8>& input,
-                                           const Layout::FramebufferLayout& layout) {
-                                            int offset = 0;
-                                            std::vector<u8> output(input.size());
-
-                                            for (u32 y = 0; y < layout.height; ++y) {
-                                                for (u32 x = 0; x < layout.width; ++x) {
-                                                    output[offset] = input[offset + 2];
-                                                    output[offset + 1] = input[offset + 1];
-                                                    output[offset + 2] = input[offset];
-                                                    output[offset + 3] = input[offset + 3];
-
-                                                    offset += 4;
-                                                }
-                                            }
-
-                                            return output;
-                                        };
-
-                                    v = convert_bgra_to_rgba(rotate(v, layout), layout);
-
-                                    stbi_write_png(filename.c_str(), layout.width, layout.height, 4,
-                                                   v.data(), layout.width * 4);
-                                }
-                            },
-                            layout)) {
-                        delete[] data;
-                    }
+                    VideoCore::g_frame_capture.RequestFrame(
+                        [](std::shared_ptr<const VideoCore::CapturedFrame> frame) {
+                            if (frame == nullptr) {
+                                return;
+                            }
+                            const auto filename =
+                                pfd::save_file("Save Screenshot", "screenshot.png",
+                                               {"Portable Network Graphics", "*.png"})
+                                    .result();
+                            if (!filename.empty()) {
+                                stbi_write_png(filename.c_str(), frame->width, frame->height, 4,
+                                               frame->pixels.data(), frame->width * 4);
+                            }
+                        });
                 }
 
                 if (ImGui::MenuItem("Generate Launcher For Custom Controls")) {
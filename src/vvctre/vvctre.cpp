@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -12,8 +13,10 @@
 // windows.h needs to be included before shellapi.h
 #include <windows.h>
 
+#include <psapi.h>
 #include <shellapi.h>
 #else
+#include <sys/resource.h>
 #include <sys/stat.h>
 #endif
 
@@ -21,6 +24,7 @@
 #include <SDL.h>
 #include <clipp.h>
 #include <indicators/progress_bar.hpp>
+#include <json.hpp>
 #include <portable-file-dialogs.h>
 #include "common/common_paths.h"
 #include "common/detached_tasks.h"
@@ -31,6 +35,7 @@
 #include "common/param_package.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/trace.h"
 #include "common/version.h"
 #include "core/core.h"
 #include "core/file_sys/cia_container.h"
@@ -48,6 +53,7 @@
 #include "vvctre/applets/mii_selector.h"
 #include "vvctre/applets/swkbd.h"
 #include "vvctre/camera/image.h"
+#include "vvctre/emu_window/emu_window_headless.h"
 #include "vvctre/emu_window/emu_window_sdl2.h"
 
 #ifndef _MSC_VER
@@ -72,6 +78,51 @@ static void InitializeLogging() {
 #endif
 }
 
+/// Returns the peak resident set size of the process in bytes
+static u64 GetPeakResidentSetSize() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<u64>(usage.ru_maxrss);
+#else
+    // In kilobytes
+    return static_cast<u64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/// Returns the performance report of a benchmark run
+static nlohmann::json MakeBenchmarkReport(Core::System& system, int frames,
+                                          std::chrono::duration<double> wall_time) {
+    nlohmann::json report{
+        {"frames", frames},
+        {"wall_time", wall_time.count()},
+        {"fps", frames / wall_time.count()},
+        {"peak_rss", GetPeakResidentSetSize()},
+    };
+
+    report["frame_time"] =
+        RPC::TimeSummaryToJson(Core::SummarizeTimes(system.perf_stats->GetFrameTimes()));
+
+    const Core::SubsystemTimes subsystem_times = Core::GetSubsystemTimes();
+    nlohmann::json& subsystem_time = report["subsystem_time"] = nlohmann::json::object();
+    for (std::size_t i = 0; i < subsystem_times.size(); ++i) {
+        subsystem_time[Core::GetSubsystemName(static_cast<Core::Subsystem>(i))] =
+            std::chrono::duration<double>(subsystem_times[i]).count();
+    }
+
+    return report;
+}
+
 bool EndsWithIgnoreCase(const std::string& str, const std::string& suffix) {
     return std::regex_search(str,
                              std::regex(std::string(suffix) + "$", std::regex_constants::icase));
@@ -98,6 +149,7 @@ int main(int argc, char** argv) {
     bool fullscreen = false;
     bool regenerate_console_id = false;
     int rpc_server_port = 47889;
+    int benchmark_frames = 0;
 
     // for Controls
     bool generate_launcher = false;
@@ -192,6 +244,10 @@ int main(int argc, char** argv) {
               clipp::value("value").set(Settings::values.min_vertices_per_thread),
           clipp::option("--resolution").doc("set resolution\ndefault: 1\n0 means use window size") &
               clipp::value("value").set(Settings::values.resolution_factor),
+          clipp::option("--surface-cache-memory-budget")
+                  .doc("set the texture memory used by cached surfaces\nin MiB, 0 for no "
+                       "limit\ndefault: 0") &
+              clipp::value("value").set(Settings::values.surface_cache_memory_budget),
           clipp::option("--audio-speed")
                   .doc("set audio speed for DSP HLE\ntype: float\nmust be greater than zero") &
               clipp::value("value").set(Settings::values.audio_speed),
@@ -274,6 +330,34 @@ int main(int argc, char** argv) {
           clipp::option("--software-renderer")
               .doc("use software renderer instead of hardware renderer")
               .set(Settings::values.use_hw_renderer, false),
+          clipp::option("--headless")
+              .doc("run without a window or a GPU using the software renderer\nthe screens are "
+                   "available from the RPC server")
+              .set(Settings::values.use_headless_renderer, true)
+              .set(Settings::values.use_hw_renderer, false),
+          clipp::option("--disable-software-renderer-multithreading")
+              .doc("rasterize on the emulation thread only if using software renderer")
+              .set(Settings::values.enable_software_renderer_multithread, false),
+          clipp::option("--disable-software-renderer-simd")
+              .doc("use the scalar reference rasterization loop if using software renderer")
+              .set(Settings::values.enable_software_renderer_simd, false),
+          clipp::option("--software-renderer-proctex-cache")
+              .doc("sample procedural textures from a texture generated once per configuration if "
+                   "using software renderer")
+              .set(Settings::values.enable_software_renderer_proctex_cache, true),
+          clipp::option("--gpu-thread")
+              .doc("run GPU commands on a separate thread if using software renderer")
+              .set(Settings::values.use_gpu_thread, true),
+          clipp::option("--gpu-thread-sync-debug")
+              .doc("wait for every GPU command and log the GPU thread sync points")
+              .set(Settings::values.gpu_thread_sync_debug, true),
+          clipp::option("--command-list-cache")
+              .doc("replay GPU command lists submitted again from a cache of decoded lists")
+              .set(Settings::values.use_command_list_cache, true),
+          clipp::option("--command-list-cache-verify")
+              .doc("check cached GPU command lists against the\ncommand processor instead of "
+                   "replaying")
+              .set(Settings::values.command_list_cache_verify, true),
           clipp::option("--software-shader")
               .doc("use software shader instead of hardware shader")
               .set(Settings::values.use_hw_shader, false),
@@ -303,6 +387,25 @@ int main(int argc, char** argv) {
           clipp::option("--preload-custom-textures")
               .doc("preload custom textures")
               .set(Settings::values.preload_textures, true),
+          clipp::option("--custom-textures-memory-budget")
+                  .doc("set the memory used by custom textures\nin MiB, 0 for no "
+                       "limit\ndefault: 0") &
+              clipp::value("value").set(Settings::values.custom_textures_memory_budget),
+          clipp::option("--build-custom-texture-pack")
+              .doc("build the custom texture pack of the game\nfrom its custom texture files")
+              .set(Settings::values.build_custom_texture_pack, true),
+          clipp::option("--fast-texture-hash")
+              .doc("hash textures with XXH3 instead of CityHash\nfor dumping and custom textures, "
+                   "textures\ndumped without it have different names")
+              .set(Settings::values.fast_texture_hash, true),
+          clipp::option("--incremental-texture-hash")
+              .doc("hash textures in 4 KiB chunks of memory,\nonly rehashing the chunks that "
+                   "changed,\ntextures dumped without it have different\nnames")
+              .set(Settings::values.incremental_texture_hash, true),
+          clipp::option("--frame-stream-interval")
+                  .doc("capture every Nth frame for the /framestream\nRPC endpoint, 0 to "
+                       "disable\ndefault: 0") &
+              clipp::value("value").set(Settings::values.frame_stream_interval),
           clipp::option("--custom-layout")
               .doc("use custom layout")
               .set(Settings::values.custom_layout, true),
@@ -398,13 +501,29 @@ int main(int argc, char** argv) {
           clipp::option("--record-frame-times")
               .doc("record frame times")
               .set(Settings::values.record_frame_times, true),
+          clipp::option("--record-subsystem-times")
+              .doc("record the time of every frame spent in each subsystem, which can be "
+                   "queried using RPC")
+              .set(Settings::values.record_subsystem_times, true),
+          clipp::option("--record-trace")
+              .doc("record a trace of the threads, which can be dumped using RPC")
+              .set(Settings::values.record_trace, true),
           clipp::option("--fullscreen").set(fullscreen).doc("start in fullscreen mode"),
           clipp::option("--regenerate-console-id")
               .set(regenerate_console_id)
               .doc("regenerate the console ID before booting"),
           clipp::option("--unlimited")
               .set(Settings::values.use_frame_limit, false)
-              .doc("disable the speed limiter")) |
+              .doc("disable the speed limiter"),
+          clipp::option("--benchmark")
+                  .doc("run frames without a window or the speed limiter, then print a JSON "
+                       "performance report") &
+              clipp::value("frames")
+                  .set(benchmark_frames)
+                  .set(Settings::values.record_subsystem_times, true)
+                  .set(Settings::values.use_headless_renderer, true)
+                  .set(Settings::values.use_hw_renderer, false)
+                  .set(Settings::values.use_frame_limit, false)) |
          (clipp::command("controls").set(command, Command::Controls).doc("configure controls"),
           clipp::option("--generate-launcher").set(generate_launcher).doc("generate launcher")) |
          (clipp::command("dump-romfs").set(command, Command::DumpRomFS).doc("dump RomFS"),
@@ -475,20 +594,30 @@ int main(int argc, char** argv) {
             // Apply the settings
             Settings::Apply();
 
+            Common::Trace::SetThreadName("Emulation");
             Core::System& system = Core::System::GetInstance();
 
-            std::unique_ptr<EmuWindow_SDL2> emu_window =
-                std::make_unique<EmuWindow_SDL2>(system, fullscreen, argv[0]);
+            std::unique_ptr<EmuWindow_SDL2> emu_window;
+            std::unique_ptr<EmuWindow_Headless> headless_window;
+            if (Settings::values.use_headless_renderer) {
+                // The default applets are used
+                headless_window = std::make_unique<EmuWindow_Headless>();
+            } else {
+                emu_window = std::make_unique<EmuWindow_SDL2>(system, fullscreen, argv[0]);
 
-            // Register frontend applets
-            system.RegisterSoftwareKeyboard(
-                std::make_shared<Frontend::SDL2_SoftwareKeyboard>(*emu_window));
-            system.RegisterMiiSelector(std::make_shared<Frontend::SDL2_MiiSelector>(*emu_window));
+                // Register frontend applets
+                system.RegisterSoftwareKeyboard(
+                    std::make_shared<Frontend::SDL2_SoftwareKeyboard>(*emu_window));
+                system.RegisterMiiSelector(
+                    std::make_shared<Frontend::SDL2_MiiSelector>(*emu_window));
+            }
 
             // Register camera implementations
             Camera::RegisterFactory("image", std::make_unique<Camera::ImageCameraFactory>());
 
-            const Core::System::ResultStatus load_result = system.Load(*emu_window, path);
+            const Core::System::ResultStatus load_result =
+                headless_window != nullptr ? system.Load(*headless_window, path)
+                                           : system.Load(*emu_window, path);
 
             switch (load_result) {
             case Core::System::ResultStatus::ErrorNotInitialized:
@@ -542,7 +671,47 @@ int main(int argc, char** argv) {
                 Core::Movie::GetInstance().StartRecording(movie_record);
             }
 
-            if (Settings::values.use_disk_shader_cache) {
+            if (headless_window != nullptr) {
+                // The boot isn't part of the benchmark
+                Core::ResetSubsystemTimes();
+                const auto start_time = std::chrono::steady_clock::now();
+
+                while (headless_window->IsOpen()) {
+                    if (benchmark_frames > 0 &&
+                        VideoCore::g_renderer->GetCurrentFrame() >= benchmark_frames) {
+                        const std::chrono::duration<double> wall_time =
+                            std::chrono::steady_clock::now() - start_time;
+                        std::cout << MakeBenchmarkReport(system, benchmark_frames, wall_time)
+                                         .dump(4)
+                                  << std::endl;
+                        headless_window->Close();
+                        break;
+                    }
+
+                    if (system.rpc_paused) {
+                        // Keeps capturing the screens, at about 60 frames per second like VSync
+                        VideoCore::g_renderer->SwapBuffers();
+                        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+                        continue;
+                    }
+
+                    switch (system.RunLoop()) {
+                    case Core::System::ResultStatus::FatalError: {
+                        LOG_CRITICAL(Frontend, "Fatal error");
+                        Core::Movie::GetInstance().Shutdown();
+                        system.Shutdown();
+                        return -1;
+                    }
+                    case Core::System::ResultStatus::ShutdownRequested: {
+                        headless_window->Close();
+                        break;
+                    }
+                    default: { break; }
+                    }
+                }
+            }
+
+            if (emu_window != nullptr && Settings::values.use_disk_shader_cache) {
                 std::atomic_bool stop_run{false};
 
                 system.Renderer().Rasterizer()->LoadDiskResources(
@@ -569,7 +738,7 @@ int main(int argc, char** argv) {
                     });
             }
 
-            while (emu_window->IsOpen()) {
+            while (emu_window != nullptr && emu_window->IsOpen()) {
                 if (system.frontend_paused || system.rpc_paused || !emu_window->messages.empty()) {
                     while (emu_window->IsOpen() && (system.frontend_paused || system.rpc_paused ||
                                                     !emu_window->messages.empty())) {